@@ -0,0 +1,93 @@
+/*!
+ * \file
+ * \brief Offline batch runner: the tracks of a set of videos are computed by a pool of threads, the completed videos
+ *        are journaled so that an interrupted batch can be resumed.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "motion/libmotion.h"
+#include "motion/video/video_struct.h"
+
+/**
+ *  Worker of the batch: a thread that processes the videos one after the other. The pipeline and the frame buffer
+ *  are reused from one video to the next as long as the frames size does not change.
+ */
+typedef struct {
+    size_t id; /**< Worker id. */
+    pthread_t thread; /**< Thread of the worker. */
+    struct batch_s* batch; /**< Batch of the worker. */
+    motion_pipeline_t* mp; /**< Pipeline (NULL before the first video). */
+    uint8_t** img; /**< Storage of the decoded frame (NULL before the first video). */
+    int i0, i1, j0, j1; /**< Dimensions of `mp` and `img`. */
+    size_t n_files; /**< Number of processed videos. */
+    size_t n_frames; /**< Number of processed frames. */
+    size_t n_allocs; /**< Number of times `mp` and `img` have been (re)allocated. */
+    double busy_us; /**< Accumulated time spent in processing videos. */
+} batch_worker_t;
+
+/**
+ *  Batch of videos.
+ */
+typedef struct batch_s {
+    char** paths; /**< Paths of the videos (in processing order). */
+    char** names; /**< Names of the results files in `out_path` (`<video file name>.txt`). */
+    uint8_t* done; /**< Booleans, 1 if the video is already in the journal (it is skipped). */
+    size_t n_files; /**< Number of videos. */
+    size_t n_todo; /**< Number of videos that are not in the journal. */
+    const char* out_path; /**< Output directory (results files and journal). */
+    FILE* journal; /**< Journal of the completed videos (opened in append mode). */
+    motion_params_t params; /**< Parameters of the pipelines (the frames size is taken from each video). */
+    enum video_codec_e codec_type; /**< Decoder of the videos. */
+    batch_worker_t* workers; /**< Workers. */
+    size_t n_workers; /**< Number of workers (parallelism between the videos). */
+    size_t n_inner_threads; /**< Number of threads of a worker (OpenMP kernels and decoder, parallelism inside a
+                                 video). */
+    size_t next; /**< Index of the next video to pick in `paths`. */
+    size_t n_finished; /**< Number of videos processed by `batch_run`. */
+    size_t n_failed; /**< Number of videos that can't be opened (skipped and journaled as failed by `batch_run`). */
+    pthread_mutex_t mutex; /**< Protects `next`, `n_finished`, `n_failed` and `journal`. */
+    double run_us; /**< Duration of the last `batch_run`. */
+} batch_t;
+
+/**
+ * Allocation and initialization of a batch. The videos are the regular files of a directory (sorted by name, the
+ * hidden files are skipped) or the lines of a list file (empty lines and lines starting with '#' are skipped). The
+ * output directory is created if needed and the journal (`<out_path>/journal.txt`) is loaded: the videos it contains
+ * are not processed again. The threads are shared between the videos first, the remaining ones go inside the videos.
+ * @param in_path Directory of videos or list file.
+ * @param out_path Output directory (it can't be the directory of videos).
+ * @param params Parameters of the pipelines (the frames size is taken from each video).
+ * @param codec_type Decoder of the videos.
+ * @param n_threads Number of threads (>= 1).
+ * @return The allocated batch.
+ */
+batch_t* batch_alloc_init(const char* in_path, const char* out_path, const motion_params_t* params,
+                          const enum video_codec_e codec_type, const size_t n_threads);
+
+/**
+ * Process all the videos that are not in the journal (blocking call). The results file of a video is written as soon
+ * as it is finished (`<out_path>/<video file name>.txt`, the tracks in the same format as `motion`), then the video
+ * is appended to the journal. A video that can't be opened is skipped and journaled as failed (it is tried again
+ * when the batch is resumed). The progress is printed on `stderr`.
+ * @param batch A pointer of batch.
+ */
+void batch_run(batch_t* batch);
+
+/**
+ * Print the statistics of the workers.
+ * @param f File descriptor (in write mode).
+ * @param batch A pointer of batch.
+ */
+void batch_stats_print(FILE* f, const batch_t* batch);
+
+/**
+ * Deallocation of a batch.
+ * @param batch A pointer of batch.
+ */
+void batch_free(batch_t* batch);
@@ -44,6 +44,29 @@ void features_free_RoIs(RoI_t* RoIs);
 void features_extract(const uint32_t** labels, const int i0, const int i1, const int j0, const int j1,
                       RoI_t* RoIs, const size_t n_RoIs);
 
+/**
+ * Refine in full resolution the features extracted from a downscaled image of labels (see `image_downscale`).
+ * Only the pixels of the up-scaled bounding box of each RoI are visited: a full resolution pixel belongs to the RoI if
+ * its downscaled pixel has the RoI label and if it is moving according to the downscaled Sigma-Delta background
+ * (\f$|I - M| \geq V\f$). The bounding box, the surface and the centroid are then given in full resolution
+ * coordinates. When no pixel is kept, the RoI is removed (its identifier and its surface are set to 0).
+ * @param img Full resolution grayscale image (\f$[i1 - i0 + 1][j1 - j0 + 1]\f$).
+ * @param i0 First \f$y\f$ index in the full resolution image (included).
+ * @param i1 Last \f$y\f$ index in the full resolution image (included).
+ * @param j0 First \f$x\f$ index in the full resolution image (included).
+ * @param j1 Last \f$x\f$ index in the full resolution image (included).
+ * @param labels Downscaled 2D array of labels.
+ * @param M Downscaled Sigma-Delta background (mean) image.
+ * @param V Downscaled Sigma-Delta variance image.
+ * @param RoIs Features (downscaled coordinates in input, full resolution coordinates in output).
+ * @param n_RoIs Number of RoIs in the previous array.
+ * @param factor Downscale factor.
+ * @see RoI_t for more explanations about the features.
+ */
+void features_refine_upscaled(const uint8_t** img, const int i0, const int i1, const int j0, const int j1,
+                              const uint32_t** labels, const uint8_t** M, const uint8_t** V, RoI_t* RoIs,
+                              const size_t n_RoIs, const int factor);
+
 /**
  * This function performs a surface thresholding as follow: if \f$ S_{min} > S \f$ or \f$ S > S_{max}\f$, then the
  * corresponding `RoIs_id` is set to 0.
@@ -8,6 +8,10 @@
 
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  *  Features: bounding box, surface, centroid & associations (matching).
  *  A bounding box represents a rectangular box around the RoI.
@@ -29,3 +33,7 @@ typedef struct {
     uint32_t prev_id; /**< Previous corresponding RoI identifiers (\f$RoI_{t - 1} \leftrightarrow RoI_{t}\f$). */
     uint32_t next_id; /**< Next corresponding RoI identifiers (\f$ RoI_{t} \leftrightarrow RoI_{t + 1}\f$). */
 } RoI_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,79 @@
+/*!
+ * \file
+ * \brief Pool of reference-counted grayscale frames.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+struct frame_pool_s;
+
+/**
+ *  Grayscale frame of a pool. A frame is shared by reference (for instance between the pipeline and the
+ *  visualization) instead of being copied, it goes back to its pool when its last reference is released.
+ */
+typedef struct {
+    uint8_t** img; /**< Grayscale image (2D array \f$[i1 - i0 + 1][j1 - j0 + 1]\f$), the pointer can be swapped with
+                        another image of the same size (see `video_reader_async_get_frame`). */
+    uint32_t refs; /**< Number of references (atomic access). */
+    struct frame_pool_s* pool; /**< Pool of the frame. */
+} frame_t;
+
+/**
+ *  Pool of preallocated frames.
+ */
+typedef struct frame_pool_s {
+    frame_t* frames; /**< Preallocated frames. */
+    size_t n_frames; /**< Number of frames. */
+    frame_t** free; /**< Stack of the frames without reference. */
+    size_t n_free; /**< Number of frames in `free`. */
+    pthread_mutex_t mutex; /**< Protects `free` (the frames can be released from any thread). */
+    int i0, i1, j0, j1; /**< Frames dimensions. */
+} frame_pool_t;
+
+/**
+ * Allocation of a pool of frames.
+ * @param n_frames Number of frames (= maximum number of frames referenced at the same time).
+ * @param i0 First \f$y\f$ index in the frames (included).
+ * @param i1 Last \f$y\f$ index in the frames (included).
+ * @param j0 First \f$x\f$ index in the frames (included).
+ * @param j1 Last \f$x\f$ index in the frames (included).
+ * @return The allocated pool.
+ */
+frame_pool_t* frame_pool_alloc(const size_t n_frames, const int i0, const int i1, const int j0, const int j1);
+
+/**
+ * Get a frame without reference from the pool, the caller owns the first reference. Exit if all the frames are
+ * referenced (the pool is too small).
+ * @param pool A pointer of pool.
+ * @return The frame.
+ */
+frame_t* frame_pool_acquire(frame_pool_t* pool);
+
+/**
+ * Add a reference to a frame.
+ * @param frame A pointer of frame.
+ */
+void frame_retain(frame_t* frame);
+
+/**
+ * Release a reference, the frame goes back to its pool with the last one.
+ * @param frame A pointer of frame.
+ */
+void frame_release(frame_t* frame);
+
+/**
+ * Check if a frame is referenced somewhere else than by the caller (then it should not be modified).
+ * @param frame A pointer of frame.
+ * @return 1 if the frame has more than one reference, 0 otherwise.
+ */
+int frame_is_shared(const frame_t* frame);
+
+/**
+ * Deallocation of a pool (all the frames have to be released).
+ * @param pool A pointer of pool.
+ */
+void frame_pool_free(frame_pool_t* pool);
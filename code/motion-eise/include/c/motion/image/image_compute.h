@@ -55,6 +55,22 @@ uint8_t** image_gs_get_pixels_2d(img_data_t* img_data);
  */
 void image_gs_free(img_data_t* img_data);
 
+/**
+ * Downscale a grayscale image by averaging the pixels of each \f$factor \times factor\f$ block (box filter).
+ * The output image starts at the same indexes (\p i0, \p j0) and its size is
+ * \f$[(i1 - i0 + 1) / factor][(j1 - j0 + 1) / factor]\f$: the last rows/columns that do not fill a block are dropped.
+ * The 2 and 4 factors are vectorized (AVX2).
+ * @param img_in Input image (2D array of size \f$[i1 - i0 + 1][j1 - j0 + 1]\f$).
+ * @param i0 First \f$y\f$ index in the input image (included).
+ * @param i1 Last \f$y\f$ index in the input image (included).
+ * @param j0 First \f$x\f$ index in the input image (included).
+ * @param j1 Last \f$x\f$ index in the input image (included).
+ * @param img_out Output image.
+ * @param factor Downscale factor (\f$\geq 1\f$).
+ */
+void image_downscale(const uint8_t** img_in, const int i0, const int i1, const int j0, const int j1,
+                     uint8_t** img_out, const int factor);
+
 /**
  * Allocate color image data.
  * @param img_height Image height.
@@ -68,7 +84,10 @@ img_data_t* image_color_alloc(const size_t img_height, const size_t img_width);
  * If the program is linked with the OpenCV library, then the `show_id` boolean can be used to draw the ids
  * corresponding to each BB on the color image. Moreover, if the program is linked with OpenCV, this routine add the
  * legend on the top left corner.
- * @param img_data Image data.
+ * The grayscale image is expanded with SSSE3 shuffles and only the pixels that changed since the previous call (plus
+ * the rows of the previous BBs) are written again in the color image. When linked with OpenCV, the whole image is
+ * expanded at each call (the texts are not tracked).
+ * @param img_data Image data (allocated with `image_color_alloc`).
  * @param img 2D grayscale image (2D array of size
  *            \f$[\texttt{img\_data->height}][\texttt{img\_data->width}]\f$). This image will be copied in `img_data`.
  * @param BBs List of bounding boxes.
@@ -45,6 +45,8 @@ typedef struct {
     size_t width; /*!< Image width. */
     void* pixels; /*!< Opaque type, contains image data (= the pixels). */
     void* container_2d; /*!< Opaque type, contains 2D image container. */
+    void* cache; /*!< Opaque type, state kept between two draws in the same image for incremental updates (can be
+                      NULL). */
 } img_data_t;
 
 /**
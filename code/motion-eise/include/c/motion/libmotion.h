@@ -0,0 +1,149 @@
+/*!
+ * \file
+ * \brief Embeddable motion detection and tracking (push-frame API of the `motion` library).
+ *
+ * The frames are owned by the caller and processed in place (without copy). A minimal use looks like:
+ *
+ *     motion_params_t params;
+ *     motion_params_default(&params, width, height);
+ *     motion_pipeline_t* mp = motion_pipeline_create(&params); // NULL on error
+ *     while (...) // for each frame
+ *         motion_pipeline_push_frame(mp, luma, stride);
+ *     const track_t* tracks;
+ *     size_t n_tracks = motion_pipeline_get_tracks(mp, &tracks);
+ *     motion_pipeline_free(mp);
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "motion/features/features_struct.h"
+#include "motion/tracking/tracking_struct.h"
+#include "motion/pipeline/pipeline_struct.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Parameters of a motion pipeline.
+ */
+typedef struct {
+    int width; /**< Width of the frames (in pixels). */
+    int height; /**< Height of the frames (in pixels). */
+    pipeline_params_t chain; /**< Parameters of the processing chain (`i0`, `i1`, `j0` and `j1` are deduced from
+                                  `width` and `height`). */
+    const char* stages; /**< Stages selection (see `pipeline_alloc`), NULL for the default stages. */
+} motion_params_t;
+
+/**
+ *  Motion pipeline: the processing chain and the frames counter.
+ */
+typedef struct {
+    pipeline_t* pip; /**< Processing chain, `pip->frames[0]` and `pip->frames[1]` hold the RoIs of the two last pushed
+                          frames. */
+    const uint8_t** rows; /**< Rows of the last pushed frame (they point in the caller memory). */
+    int height; /**< Height of the frames (in pixels). */
+    size_t n_frames; /**< Number of pushed frames. */
+} motion_pipeline_t;
+
+/**
+ * Set the default parameters (the same as the `motion` executable ones).
+ * @param params Parameters to initialize.
+ * @param width Width of the frames (in pixels).
+ * @param height Height of the frames (in pixels).
+ */
+void motion_params_default(motion_params_t* params, const int width, const int height);
+
+/**
+ * Allocation of a motion pipeline.
+ * @param params Parameters (copied).
+ * @return The allocated pipeline, NULL if the frames size is not positive or if the allocation failed.
+ */
+motion_pipeline_t* motion_pipeline_create(const motion_params_t* params);
+
+/**
+ * Process a frame given as a 2D array. The first frame initializes the detection (no RoI), the next ones are
+ * detected, associated with the previous frame and tracked.
+ * @param mp A pointer of motion pipeline.
+ * @param img Grayscale image (2D array \f$[height][width]\f$), it is only read during the call.
+ * @param frame Frame number (as reported in the tracks).
+ * @return The number of RoIs detected in the frame.
+ */
+uint32_t motion_pipeline_push_view(motion_pipeline_t* mp, const uint8_t** img, const int frame);
+
+/**
+ * Drop the next frame when the caller is late (load shedding, see `pipeline_drop`): there is no detection and no
+ * tracking for it, the next pushed frame compensates for the gap. The frame is counted in `n_frames`. The first
+ * frame can't be dropped, it initializes the background model: it is pushed instead and `img` can't be NULL.
+ * @param mp A pointer of motion pipeline.
+ * @param img Rows of the frame, only the background model is updated with it (NULL to skip the update, except for the
+ *            first frame).
+ */
+void motion_pipeline_drop_view(motion_pipeline_t* mp, const uint8_t** img);
+
+/**
+ * Process the next frame given as a luma plane (see `motion_pipeline_push_view`), the frames are numbered from 0.
+ * @param mp A pointer of motion pipeline.
+ * @param luma First pixel of the luma plane (8-bit), it is only read during the call.
+ * @param stride Distance in bytes between two rows of the plane (\f$\geq\f$ width).
+ * @return The number of RoIs detected in the frame.
+ */
+uint32_t motion_pipeline_push_frame(motion_pipeline_t* mp, const uint8_t* luma, const size_t stride);
+
+/**
+ * Get the RoIs of the last pushed frame (valid until the next push).
+ * @param mp A pointer of motion pipeline.
+ * @param RoIs Output pointer on the RoIs.
+ * @return The number of RoIs.
+ */
+uint32_t motion_pipeline_get_RoIs(const motion_pipeline_t* mp, const RoI_t** RoIs);
+
+/**
+ * Get the tracks (valid until the next push). The tracks with a null `id` have to be skipped, the other ones are
+ * finished or still in progress (see `state`).
+ * @param mp A pointer of motion pipeline.
+ * @param tracks Output pointer on the tracks.
+ * @return The number of tracks.
+ */
+size_t motion_pipeline_get_tracks(const motion_pipeline_t* mp, const track_t** tracks);
+
+/**
+ * Reset a motion pipeline to process another video with the same frames size: the tracks are cleared and the next
+ * pushed frame is the first one of the new video (the buffers are reused, there is no allocation of frames).
+ * @param mp A pointer of motion pipeline.
+ */
+void motion_pipeline_reset(motion_pipeline_t* mp);
+
+/**
+ * Write a checkpoint of a motion pipeline (background model, tracks, RoIs of the last frame and frames counter), see
+ * `pipeline_checkpoint_write`. The file is written under a temporary name and then renamed: an existing checkpoint
+ * is replaced only by a complete one.
+ * @param mp A pointer of motion pipeline.
+ * @param path Path of the checkpoint.
+ * @return 0 on success, -1 if the checkpoint can't be written (the previous one, if any, is left in place).
+ */
+int motion_pipeline_save(const motion_pipeline_t* mp, const char* path);
+
+/**
+ * Restore a checkpoint written by `motion_pipeline_save` (warm start): the next pushed frame is processed with the
+ * converged background model and it continues the tracks. The pipeline has to be created with the same frames size
+ * and stages as the saved one.
+ * @param mp A pointer of motion pipeline.
+ * @param path Path of the checkpoint.
+ * @return 0 on success, -1 if the checkpoint can't be opened, is truncated or does not match the pipeline (the
+ *         pipeline is then reset, see `motion_pipeline_reset`).
+ */
+int motion_pipeline_load(motion_pipeline_t* mp, const char* path);
+
+/**
+ * Deallocation of a motion pipeline.
+ * @param mp A pointer of motion pipeline.
+ */
+void motion_pipeline_free(motion_pipeline_t* mp);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,9 @@
+/*!
+ * \file
+ * \brief Binary log module.
+ */
+
+#pragma once
+
+#include "motion/log/log_struct.h"
+#include "motion/log/log_io.h"
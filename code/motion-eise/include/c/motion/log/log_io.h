@@ -0,0 +1,193 @@
+/*!
+ * \file
+ * \brief IOs for the binary log.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "motion/CCL/CCL_struct.h"
+#include "motion/features/features_struct.h"
+#include "motion/kNN/kNN_struct.h"
+#include "motion/tracking/tracking_struct.h"
+#include "motion/log/log_struct.h"
+
+/**
+ * Create a buffered binary file and start its writer thread.
+ * @param path Path of the file (the file is truncated).
+ * @param chunk_size Size in bytes of a chunk (a chunk is written by the writer thread when it is full).
+ * @param n_chunks Number of chunks (>= 2): when all the chunks are waiting to be written, the caller waits.
+ * @return The allocated buffer.
+ */
+log_buffer_t* log_buffer_alloc_init(const char* path, const size_t chunk_size, const size_t n_chunks);
+
+/**
+ * Get `size` contiguous bytes at the end of the buffer (the previous data are not modified).
+ * @param buf A pointer of previously allocated buffer.
+ * @param size Number of bytes.
+ * @return A pointer to the reserved bytes, valid until the next call to `log_buffer_commit`.
+ */
+uint8_t* log_buffer_reserve(log_buffer_t* buf, const size_t size);
+
+/**
+ * Append the first `size` bytes reserved by the last `log_buffer_reserve` call to the file.
+ * @param buf A pointer of previously allocated buffer.
+ * @param size Number of bytes (lower or equal to the reserved size).
+ */
+void log_buffer_commit(log_buffer_t* buf, const size_t size);
+
+/**
+ * Write the remaining data, stop the writer thread and close the file.
+ * @param buf A pointer of previously allocated buffer.
+ */
+void log_buffer_free(log_buffer_t* buf);
+
+/**
+ * Create a binary log and start its writer thread.
+ * @param path Path of the binary log (the file is truncated).
+ * @param chunk_size Size in bytes of a chunk of records (a chunk is written by the writer thread when it is full).
+ * @param n_chunks Number of chunks (>= 2): when all the chunks are waiting to be written, the caller waits.
+ * @return The allocated writer.
+ */
+log_writer_t* log_writer_alloc_init(const char* path, const size_t chunk_size, const size_t n_chunks);
+
+/**
+ * Append a frame record to the binary log. The record contains the same information as the text logs written by
+ * `features_RoIs0_RoIs1_write`, `kNN_asso_conflicts_write` and `tracking_tracks_write_full`.
+ * @param log A pointer of previously allocated writer.
+ * @param prev_frame Frame number at \f$t - 1\f$ (-1 for the first frame).
+ * @param cur_frame Frame number at \f$t\f$.
+ * @param RoIs0 Features at \f$t - 1\f$.
+ * @param n_RoIs0 Number of RoIs at \f$t - 1\f$.
+ * @param RoIs1 Features at \f$t\f$.
+ * @param n_RoIs1 Number of RoIs at \f$t\f$.
+ * @param kNN_data Inner kNN data (NULL to skip the associations, the conflicts and the tracks sections).
+ * @param tracks A vector of tracks.
+ */
+void log_writer_write_frame(log_writer_t* log, const int prev_frame, const int cur_frame, const RoI_t* RoIs0,
+                            const size_t n_RoIs0, const RoI_t* RoIs1, const size_t n_RoIs1,
+                            const kNN_data_t* kNN_data, const vec_track_t tracks);
+
+/**
+ * Write the remaining records, stop the writer thread and close the binary log.
+ * @param log A pointer of previously allocated writer.
+ */
+void log_writer_free(log_writer_t* log);
+
+/**
+ * Convert a binary log into text logs (one `<folder>/<frame>.txt` file per frame, identical to the `--log-path`
+ * files).
+ * @param bin_path Path of the binary log.
+ * @param folder_path Output folder (created if needed).
+ * @return The number of converted frames.
+ */
+size_t log_convert_text(const char* bin_path, const char* folder_path);
+
+/**
+ * Create a shared-memory records ring (see `log_shm_header_t`). The ring is created under the `<path>.tmp` name and
+ * renamed once initialized, it is not removed by `log_shm_writer_free`.
+ * @param path Path of the ring (for instance `/dev/shm/<name>`).
+ * @param capacity Size in bytes of the records area (rounded up to the next power of 2).
+ * @return The allocated producer.
+ */
+log_shm_writer_t* log_shm_writer_alloc_init(const char* path, const size_t capacity);
+
+/**
+ * Publish a frame record (RoIs at \f$t\f$ and tracks updated since the previous record) without waiting for the
+ * consumers.
+ * @param shm A pointer of previously allocated producer.
+ * @param frame Frame number at \f$t\f$.
+ * @param RoIs Features at \f$t\f$.
+ * @param n_RoIs Number of RoIs at \f$t\f$.
+ * @param tracks A vector of tracks.
+ */
+void log_shm_writer_write_frame(log_shm_writer_t* shm, const int frame, const RoI_t* RoIs, const size_t n_RoIs,
+                                const vec_track_t tracks);
+
+/**
+ * Mark the end of the stream in the shared-memory records ring and deallocate the producer.
+ * @param shm A pointer of previously allocated producer.
+ */
+void log_shm_writer_free(log_shm_writer_t* shm);
+
+/**
+ * Open a shared-memory records ring, the first record returned is the next one published by the producer.
+ * @param path Path of the ring.
+ * @return The allocated consumer.
+ */
+log_shm_reader_t* log_shm_reader_alloc_init(const char* path);
+
+/**
+ * Get the next frame record (in place in the ring). The records overwritten by the producer before being read are
+ * skipped (see `n_lost`).
+ * @param shm A pointer of previously allocated consumer.
+ * @param record Return a pointer to the record, valid until the producer overwrites it (see `log_shm_reader_check`).
+ * @return 1 if a record is returned, 0 if there is no new record yet and -1 at the end of the stream.
+ */
+int log_shm_reader_next(log_shm_reader_t* shm, const log_shm_record_t** record);
+
+/**
+ * Check that the last record returned by `log_shm_reader_next` has not been overwritten while it was read. This has
+ * to be called after the record has been read (or copied), its content has to be discarded otherwise.
+ * @param shm A pointer of previously allocated consumer.
+ * @return 1 if the record is valid, 0 otherwise.
+ */
+int log_shm_reader_check(const log_shm_reader_t* shm);
+
+/**
+ * Deallocation of a consumer.
+ * @param shm A pointer of previously allocated consumer.
+ */
+void log_shm_reader_free(log_shm_reader_t* shm);
+
+/**
+ * Create a binary file of connected-components runs and start its writer thread.
+ * @param path Path of the file (the file is truncated).
+ * @param width Frames width (<= 65536).
+ * @param height Frames height (<= 65536).
+ * @param start Number of the first CC debug frame file (like the `video_writer_t` of `--ccl-fra-path`).
+ * @return The allocated writer.
+ */
+log_runs_writer_t* log_runs_writer_alloc_init(const char* path, const size_t width, const size_t height,
+                                              const int start);
+
+/**
+ * Append the runs of a frame, straight from the CCL inner data: the runs of the connected-components removed by the
+ * surface filtering are skipped and the other ones are relabeled like `features_filter_surface` does.
+ * @param runs A pointer of previously allocated writer.
+ * @param frame Frame number.
+ * @param CCL_data Inner CCL data of the last `CCL_LSL_apply` call.
+ * @param RoIs Features of the CCL labels after the surface filtering (the filtered RoIs have a 0 id).
+ * @param n_RoIs Number of CCL labels.
+ */
+void log_runs_writer_write_frame(log_runs_writer_t* runs, const int frame, const CCL_data_t* CCL_data,
+                                 const RoI_t* RoIs, const size_t n_RoIs);
+
+/**
+ * Write the remaining runs, stop the writer thread and close the file.
+ * @param runs A pointer of previously allocated writer.
+ */
+void log_runs_writer_free(log_runs_writer_t* runs);
+
+/**
+ * Open a binary file of connected-components runs.
+ * @param path Path of the file.
+ * @return The allocated reader.
+ */
+log_runs_reader_t* log_runs_reader_alloc_init(const char* path);
+
+/**
+ * Read the runs of the next frame.
+ * @param runs A pointer of previously allocated reader.
+ * @param frame Return the frame header.
+ * @return 1 if a frame has been read (its runs are in `runs->runs`), 0 at the end of the file.
+ */
+int log_runs_reader_next(log_runs_reader_t* runs, log_runs_frame_t* frame);
+
+/**
+ * Deallocation of a reader.
+ * @param runs A pointer of previously allocated reader.
+ */
+void log_runs_reader_free(log_runs_reader_t* runs);
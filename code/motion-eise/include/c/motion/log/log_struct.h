@@ -0,0 +1,311 @@
+/*!
+ * \file
+ * \brief Binary log structures.
+ *
+ * A binary log is a single append-only file: a `log_file_header_t` followed by one record per processed frame. A frame
+ * record is a `log_frame_t` followed, in this order, by `n_RoIs0` then `n_RoIs1` `log_RoI_t`, `n_assos`
+ * `log_asso_t`, `n_conflict_recs` `log_conflict_t` and `n_track_deltas` `log_track_t`. All the records are fixed-width
+ * and stored in the byte order of the host. Only the tracks that changed since the previous frame are stored: the
+ * full table of tracks is rebuilt by applying the deltas in order.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "motion/spsc_queue.h"
+
+/**
+ *  Magic number at the beginning of a binary log.
+ */
+#define LOG_MAGIC "MOTNLOG"
+
+/**
+ *  Version of the binary log format.
+ */
+#define LOG_VERSION 1
+
+/**
+ *  Tag at the beginning of each frame record (used to detect a truncated or corrupted log).
+ */
+#define LOG_FRAME_TAG 0x4D415246u
+
+/**
+ *  The frame record contains the associations, the conflicts and the tracks sections (this is not the case for the
+ *  first frame).
+ */
+#define LOG_FRAME_ASSOS 0x1u
+
+/**
+ *  Value of `log_frame_t.n_conflicts` when the association conflicts have not been computed.
+ */
+#define LOG_NO_CONFLICTS 0xFFFFFFFFu
+
+/**
+ *  Header of a binary log.
+ */
+typedef struct {
+    char magic[8]; /**< `LOG_MAGIC`. */
+    uint32_t version; /**< `LOG_VERSION`. */
+    uint32_t header_size; /**< Size of this header in bytes. */
+} log_file_header_t;
+
+/**
+ *  Header of a frame record.
+ */
+typedef struct {
+    uint32_t tag; /**< `LOG_FRAME_TAG`. */
+    int32_t prev_frame; /**< Frame number at \f$t - 1\f$ (-1 for the first frame, no RoI at \f$t - 1\f$ then). */
+    int32_t cur_frame; /**< Frame number at \f$t\f$. */
+    uint32_t flags; /**< Bit field of `LOG_FRAME_*` flags. */
+    uint32_t n_RoIs0; /**< Number of RoIs at \f$t - 1\f$. */
+    uint32_t n_RoIs1; /**< Number of RoIs at \f$t\f$. */
+    uint32_t n_assos_tot; /**< Number of RoIs at \f$t - 1\f$ associated with a RoI at \f$t\f$. */
+    uint32_t n_assos; /**< Number of association records. */
+    uint32_t n_conflicts; /**< Number of RoIs at \f$t\f$ in conflict (or `LOG_NO_CONFLICTS`). */
+    uint32_t n_conflict_recs; /**< Number of conflict records. */
+    uint32_t n_tracks; /**< Size of the vector of tracks. */
+    uint32_t n_track_deltas; /**< Number of track records. */
+} log_frame_t;
+
+/**
+ *  RoI record (only the RoIs with a non-zero id are stored).
+ */
+typedef struct {
+    uint32_t id; /**< RoI id. */
+    uint32_t track_id; /**< Id of the corresponding track (0 if none). */
+    uint32_t xmin; /**< Minimum \f$x\f$ coordinates of the bounding box. */
+    uint32_t xmax; /**< Maximum \f$x\f$ coordinates of the bounding box. */
+    uint32_t ymin; /**< Minimum \f$y\f$ coordinates of the bounding box. */
+    uint32_t ymax; /**< Maximum \f$y\f$ coordinates of the bounding box. */
+    uint32_t S; /**< Surface. */
+    float x; /**< \f$x\f$ coordinates of the centroid. */
+    float y; /**< \f$y\f$ coordinates of the centroid. */
+} log_RoI_t;
+
+/**
+ *  Association record (\f$RoI_{t - 1} \leftrightarrow RoI_{t}\f$).
+ */
+typedef struct {
+    uint32_t id0; /**< RoI id at \f$t - 1\f$. */
+    uint32_t id1; /**< RoI id at \f$t\f$. */
+    float dist; /**< Euclidean distance (in pixels). */
+    uint32_t rank; /**< Rank of the association. */
+} log_asso_t;
+
+/**
+ *  Conflict record. A conflict on a RoI at \f$t\f$ is a record with `id0` = 0 followed by one record per possible RoI
+ *  at \f$t - 1\f$.
+ */
+typedef struct {
+    uint32_t id1; /**< RoI id at \f$t\f$. */
+    uint32_t id0; /**< Possible RoI id at \f$t - 1\f$ (0 for the first record of a conflict). */
+    float dist; /**< Euclidean distance (in pixels). */
+} log_conflict_t;
+
+/**
+ *  Track record: new value of the track at position `index` in the vector of tracks.
+ */
+typedef struct {
+    uint32_t index; /**< Position in the vector of tracks. */
+    uint32_t id; /**< Track id (0 for an uninitialized track). */
+    uint32_t begin_frame; /**< Frame number of the first RoI. */
+    float begin_x; /**< \f$x\f$ coordinates of the first RoI. */
+    float begin_y; /**< \f$y\f$ coordinates of the first RoI. */
+    uint32_t end_frame; /**< Frame number of the last RoI. */
+    float end_x; /**< \f$x\f$ coordinates of the last RoI. */
+    float end_y; /**< \f$y\f$ coordinates of the last RoI. */
+    uint32_t state; /**< State of the track (`enum state_e`). */
+} log_track_t;
+
+/**
+ *  State required to serialize the RoIs and the tracks deltas of successive frames.
+ */
+typedef struct {
+    log_track_t* tracks; /**< Tracks in the previous record (to compute the deltas). */
+    size_t n_tracks; /**< Number of tracks in `tracks`. */
+    size_t max_tracks; /**< Capacity of `tracks`. */
+    uint32_t* track_ids; /**< Scratch array: track id of each RoI id. */
+    size_t max_track_ids; /**< Capacity of `track_ids`. */
+} log_state_t;
+
+/**
+ *  Chunk of serialized records, written to the file by the writer thread.
+ */
+typedef struct {
+    uint8_t* data; /**< Serialized records. */
+    size_t size; /**< Number of used bytes in `data`. */
+    size_t capacity; /**< Number of allocated bytes in `data`. */
+    int last; /**< Boolean, the writer thread stops after this chunk. */
+} log_chunk_t;
+
+/**
+ *  Buffered binary file. The records are serialized in a chunk, full chunks are written by a separate thread.
+ */
+typedef struct {
+    FILE* file; /**< Binary file. */
+    log_chunk_t* chunks; /**< Preallocated chunks. */
+    size_t n_chunks; /**< Number of chunks. */
+    log_chunk_t* cur; /**< Chunk being filled (owned by the caller thread). */
+    spsc_queue_t* filled; /**< Chunks waiting to be written. */
+    spsc_queue_t* empty; /**< Chunks available for serialization. */
+    pthread_t thread; /**< Writer thread. */
+    size_t n_bytes; /**< Number of serialized bytes. */
+    double stall_us; /**< Time spent by the caller waiting for an empty chunk (in us). */
+} log_buffer_t;
+
+/**
+ *  Binary log writer.
+ */
+typedef struct {
+    log_buffer_t* buffer; /**< Buffered binary log file. */
+    log_state_t state; /**< RoIs and tracks serialization state. */
+    size_t n_frames; /**< Number of frame records. */
+} log_writer_t;
+
+/**
+ *  Magic number at the beginning of a shared-memory records ring.
+ */
+#define LOG_SHM_MAGIC "MOTNLSHM"
+
+/**
+ *  Version of the shared-memory records ring format.
+ */
+#define LOG_SHM_VERSION 1
+
+/**
+ *  Size in bytes of the header of a shared-memory records ring (the records start after).
+ */
+#define LOG_SHM_HEADER_SIZE 4096
+
+/**
+ *  Tag of a padding record (the end of the ring is skipped, the next record starts at the beginning of the ring).
+ */
+#define LOG_SHM_PAD_TAG 0x44415050u
+
+/**
+ *  Header of a shared-memory records ring. The ring is a file mapped by one producer and any number of consumers.
+ *
+ *  The producer publishes one record per frame and never waits for the consumers: the oldest records are overwritten.
+ *  Positions are monotonic byte offsets (the position in the ring is the offset modulo `capacity`). Before writing a
+ *  record, the producer sets `reserve_pos` to the end of the area it is going to overwrite, then it writes the record
+ *  and sets `write_pos` to its end. A consumer reads the records in place from its own position up to `write_pos`;
+ *  a record at position `pos` is valid as long as `reserve_pos - capacity <= pos`, so a consumer checks again
+ *  `reserve_pos` after having read a record (like a sequence lock). A record never wraps around the end of the ring,
+ *  a padding record fills the end of the ring when needed.
+ */
+typedef struct {
+    char magic[8]; /**< `LOG_SHM_MAGIC`. */
+    uint32_t version; /**< `LOG_SHM_VERSION`. */
+    uint32_t _pad0; /**< Unused. */
+    uint64_t capacity; /**< Size in bytes of the records area (a power of 2). */
+    uint8_t _pad1[40]; /**< Padding to put the producer positions on their own cache line. */
+    uint64_t reserve_pos; /**< End of the area that can be overwritten by the producer. */
+    uint64_t write_pos; /**< End of the last published record. */
+    uint64_t n_records; /**< Number of published frame records (= sequence number of the next record). */
+    uint32_t eos; /**< Boolean, set by the producer at the end of the stream. */
+} log_shm_header_t;
+
+/**
+ *  Header of a frame record in a shared-memory ring, followed by `n_RoIs` `log_RoI_t` (RoIs at \f$t\f$) and
+ *  `n_tracks` `log_track_t` (the tracks updated since the previous record).
+ */
+typedef struct {
+    uint32_t tag; /**< `LOG_FRAME_TAG` (or `LOG_SHM_PAD_TAG` for a padding record, only `size` is valid then). */
+    uint32_t size; /**< Size in bytes of the record (header included, multiple of 8). */
+    uint64_t seq; /**< Sequence number of the record (a gap means that records have been overwritten). */
+    int32_t frame; /**< Frame number. */
+    uint32_t n_RoIs; /**< Number of RoI records. */
+    uint32_t n_tracks; /**< Number of track records. */
+    uint32_t _pad; /**< Unused. */
+} log_shm_record_t;
+
+/**
+ *  Producer of a shared-memory records ring.
+ */
+typedef struct {
+    log_shm_header_t* header; /**< Mapped ring (header and records). */
+    size_t map_size; /**< Size in bytes of the mapping. */
+    log_state_t state; /**< RoIs and tracks serialization state. */
+    size_t n_dropped; /**< Number of records larger than half of the ring (not published). */
+} log_shm_writer_t;
+
+/**
+ *  Consumer of a shared-memory records ring.
+ */
+typedef struct {
+    const log_shm_header_t* header; /**< Mapped ring (header and records). */
+    size_t map_size; /**< Size in bytes of the mapping. */
+    uint64_t pos; /**< Position of the next record to read. */
+    uint64_t cur_pos; /**< Position of the last returned record. */
+    uint64_t seq; /**< Expected sequence number of the next record. */
+    size_t n_lost; /**< Number of records overwritten before being read. */
+} log_shm_reader_t;
+
+/**
+ *  Magic number at the beginning of a binary file of connected-components runs.
+ */
+#define LOG_RUNS_MAGIC "MOTNRUNS"
+
+/**
+ *  Version of the connected-components runs format.
+ */
+#define LOG_RUNS_VERSION 1
+
+/**
+ *  Header of a binary file of connected-components runs. It is followed by one `log_runs_frame_t` per frame, each one
+ *  followed by `n_runs` `log_run_t`.
+ */
+typedef struct {
+    char magic[8]; /**< `LOG_RUNS_MAGIC`. */
+    uint32_t version; /**< `LOG_RUNS_VERSION`. */
+    uint32_t header_size; /**< Size of this header in bytes. */
+    uint32_t width; /**< Frames width. */
+    uint32_t height; /**< Frames height. */
+    int32_t start; /**< Number of the first CC debug frame file (`--vid-in-start`). */
+} log_runs_header_t;
+
+/**
+ *  Header of the runs of a frame.
+ */
+typedef struct {
+    uint32_t tag; /**< `LOG_FRAME_TAG`. */
+    int32_t frame; /**< Frame number. */
+    uint32_t n_runs; /**< Number of runs. */
+    uint32_t n_labels; /**< Number of labels (the labels are in \f$[1;\texttt{n\_labels}]\f$). */
+} log_runs_frame_t;
+
+/**
+ *  Run of pixels of a connected-component on a row, the runs of a frame are sorted by row and by start.
+ */
+typedef struct {
+    uint16_t row; /**< Row (\f$y\f$). */
+    uint16_t start; /**< First column (\f$x\f$, included). */
+    uint16_t end; /**< Last column (\f$x\f$, included). */
+    uint16_t label; /**< Label of the connected-component (= id of the RoI after the surface filtering). */
+} log_run_t;
+
+/**
+ *  Writer of connected-components runs.
+ */
+typedef struct {
+    log_buffer_t* buffer; /**< Buffered binary file. */
+    uint32_t* labels; /**< Scratch array: final label of each CCL label. */
+    size_t max_labels; /**< Capacity of `labels`. */
+    size_t n_frames; /**< Number of written frames. */
+} log_runs_writer_t;
+
+/**
+ *  Reader of connected-components runs.
+ */
+typedef struct {
+    FILE* file; /**< Binary file. */
+    uint32_t width; /**< Frames width. */
+    uint32_t height; /**< Frames height. */
+    int start; /**< Number of the first CC debug frame file. */
+    log_run_t* runs; /**< Runs of the last read frame. */
+    size_t max_runs; /**< Capacity of `runs`. */
+} log_runs_reader_t;
@@ -0,0 +1,10 @@
+/*!
+ * \file
+ * \brief Pipeline engine module (detection and tracking chain built from a registry of stages).
+ */
+
+#pragma once
+
+#include "motion/pipeline/pipeline_struct.h"
+#include "motion/pipeline/pipeline_compute.h"
+#include "motion/pipeline/pipeline_io.h"
@@ -0,0 +1,153 @@
+/*!
+ * \file
+ * \brief Pipeline engine: registry of the stages, chain execution and timings.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "motion/pipeline/pipeline_struct.h"
+
+/**
+ * Short name of a step (the one used to select the stages, e.g. "mrp").
+ * @param step Step of the processing chain.
+ * @return The name.
+ */
+const char* pipeline_step_name(const enum pipeline_stage_e step);
+
+/**
+ * Print the registered stages (one line per stage, the default stage of each step comes first).
+ * @param f File descriptor (in write mode).
+ */
+void pipeline_registry_print(FILE* f);
+
+/**
+ * Allocation of a pipeline, its stages and their buffers.
+ * @param p Parameters of the processing chain (copied).
+ * @param stages Stages selection: a comma separated list of `step=name` (e.g. "mrp=open3,ccl=lsl"), the steps that
+ *               are not in the list use their default stage (the default morphology is "open3" when the detection
+ *               is downscaled). NULL selects all the default stages.
+ * @return The allocated pipeline.
+ */
+pipeline_t* pipeline_alloc(const pipeline_params_t* p, const char* stages);
+
+/**
+ * Initialize the stages with the first frame (for instance the Sigma-Delta model) and reset the buffers.
+ * @param pip A pointer of pipeline.
+ * @param img First input grayscale image (2D array \f$[i1 - i0 + 1][j1 - j0 + 1]\f$).
+ */
+void pipeline_init(pipeline_t* pip, const uint8_t** img);
+
+/**
+ * Set the inner data of a global step declared as external (see `pipeline_params_t`), the data stay owned by the
+ * caller. They can be changed between two frames if the stage does not keep a state from one frame to the next.
+ * @param pip A pointer of pipeline.
+ * @param step An external global step.
+ * @param data Inner data of the selected stage of this step.
+ */
+void pipeline_set_data(pipeline_t* pip, const enum pipeline_stage_e step, void* data);
+
+/**
+ * Run the detection steps (from the Sigma-Delta to the surface filtering) on a frame.
+ * @param pip A pointer of pipeline.
+ * @param f Frame data to use: 0 for \f$t - 1\f$, 1 for \f$t\f$.
+ * @param img Input grayscale image (2D array \f$[i1 - i0 + 1][j1 - j0 + 1]\f$), it has to stay valid until the next
+ *            call with the same \p f.
+ */
+void pipeline_detect(pipeline_t* pip, const int f, const uint8_t** img);
+
+/**
+ * Drop a frame (load shedding): the frame is not detected nor associated, the next association compensates for the
+ * gap (the k-NN distance and the tracks extrapolation are scaled by the number of frames since the previous one).
+ * @param pip A pointer of pipeline.
+ * @param f Frame data to use: 0 for \f$t - 1\f$, 1 for \f$t\f$.
+ * @param img Input grayscale image, only the background model (Sigma-Delta) is updated with it. If NULL, the model
+ *            is not updated (the cheapest drop).
+ */
+void pipeline_drop(pipeline_t* pip, const int f, const uint8_t** img);
+
+/**
+ * Run the association steps (k-NN matching and tracking) between the RoIs of `frames[0]` and `frames[1]` (the
+ * frames dropped in between are taken into account, see `pipeline_drop`).
+ * @param pip A pointer of pipeline.
+ * @param cur_fra Current frame number.
+ */
+void pipeline_associate(pipeline_t* pip, const int cur_fra);
+
+/**
+ * Swap the RoIs of \f$t - 1\f$ and \f$t\f$ (the RoIs at \f$t\f$ become the ones at \f$t - 1\f$ for the next frame).
+ * @param pip A pointer of pipeline.
+ */
+void pipeline_swap_RoIs(pipeline_t* pip);
+
+/**
+ * Reset the pipeline to process a new video with the same frames size: the data of the stateful stages (for instance
+ * the tracks) are reallocated, the timings and the dropped frames counter are cleared, the other buffers are kept.
+ * `pipeline_init` has to be called with the first frame of the new video.
+ * @param pip A pointer of pipeline.
+ */
+void pipeline_reset(pipeline_t* pip);
+
+/**
+ * Print the selected stages.
+ * @param f File descriptor (in write mode).
+ * @param pip A pointer of pipeline.
+ */
+void pipeline_stages_print(FILE* f, const pipeline_t* pip);
+
+/**
+ * Print the average latency of each step (one "# -> " line per step).
+ * @param f File descriptor (in write mode).
+ * @param pip A pointer of pipeline.
+ * @param n_frames Number of processed frames.
+ */
+void pipeline_latencies_print(FILE* f, const pipeline_t* pip, const size_t n_frames);
+
+/**
+ * Allocation of an asynchronous pipeline and start of its threads. The pipeline has to be initialized (see
+ * `pipeline_init`), then it has to be used only through the asynchronous pipeline until `pipeline_async_free`.
+ * @param pip A pointer of pipeline.
+ * @param n_frames Number of frames in flight in the threads (>= 1), the caller holds two more frames.
+ * @return The allocated asynchronous pipeline.
+ */
+pipeline_async_t* pipeline_async_alloc(pipeline_t* pip, const size_t n_frames);
+
+/**
+ * Number of frames that can be pushed without waiting.
+ * @param async A pointer of asynchronous pipeline.
+ * @return The number of free slots.
+ */
+size_t pipeline_async_n_free(const pipeline_async_t* async);
+
+/**
+ * Push a frame to detect (the caller has to check that a slot is free, see `pipeline_async_n_free`).
+ * @param async A pointer of asynchronous pipeline.
+ * @param img Input grayscale image, it has to stay valid until the frame after this one is popped.
+ * @param cur_fra Frame number.
+ * @param user Caller data, given back by `pipeline_async_pop`.
+ */
+void pipeline_async_push(pipeline_async_t* async, const uint8_t** img, const int cur_fra, void* user);
+
+/**
+ * Wait for the oldest pushed frame to be detected, then run the association steps on it: `frames[0]` and `frames[1]`
+ * of the pipeline are the frames \f$t - 1\f$ and \f$t\f$ until the next pop.
+ * @param async A pointer of asynchronous pipeline.
+ * @param user Return the caller data of the frame.
+ * @return The frame number, -1 if there is no pending frame.
+ */
+int pipeline_async_pop(pipeline_async_t* async, void** user);
+
+/**
+ * Stop the threads and deallocate an asynchronous pipeline. The pipeline gets back its own frames (with the RoIs of
+ * the two last popped frames), it can be used (or saved) as after a synchronous processing.
+ * @param async A pointer of asynchronous pipeline.
+ */
+void pipeline_async_free(pipeline_async_t* async);
+
+/**
+ * Deallocation of a pipeline.
+ * @param pip A pointer of pipeline.
+ */
+void pipeline_free(pipeline_t* pip);
@@ -0,0 +1,30 @@
+/*!
+ * \file
+ * \brief Pipeline checkpoints: the state of the processing chain is written to a file and restored (warm start).
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include "motion/pipeline/pipeline_struct.h"
+
+/**
+ * Write the state of a pipeline in binary: the data of the stages that have a state (`save` in the stage interface,
+ * for instance the Sigma-Delta model and the tracks), the RoIs of the two frames, the current frame number and the
+ * number of dropped frames.
+ * @param f File descriptor (in binary write mode).
+ * @param pip A pointer of pipeline.
+ */
+void pipeline_checkpoint_write(FILE* f, const pipeline_t* pip);
+
+/**
+ * Restore the state written by `pipeline_checkpoint_write`, instead of `pipeline_init`: the next frame is processed
+ * with the restored model and tracks. The frames size and the selected stages have to be the same as the ones of
+ * the pipeline that wrote the checkpoint.
+ * @param f File descriptor (in binary read mode).
+ * @param pip A pointer of pipeline.
+ * @return 0 on success, -1 if the checkpoint is truncated or does not match the pipeline (the pipeline is then in an
+ *         undefined state, `pipeline_reset` restores a valid one).
+ */
+int pipeline_checkpoint_read(FILE* f, pipeline_t* pip);
@@ -0,0 +1,189 @@
+/*!
+ * \file
+ * \brief Pipeline engine structures: stages interface, parameters and double-buffered frame data.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "motion/spsc_queue.h"
+#include "motion/features/features_struct.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Steps of the processing chain, in execution order.
+ */
+enum pipeline_stage_e { PIP_SD = 0, /*!< Motion detection (per pixel), Sigma-Delta. */
+                        PIP_MRP, /*!< Mathematical morphology on the binary image. */
+                        PIP_CCL, /*!< Connected components labeling. */
+                        PIP_CCA, /*!< Connected components analysis (labels to RoIs). */
+                        PIP_FLT, /*!< Surface filtering of the RoIs. */
+                        PIP_KNN, /*!< RoIs associations between \f$t - 1\f$ and \f$t\f$. */
+                        PIP_TRK, /*!< Temporal tracking. */
+                        PIP_N_STAGES /*!< Number of steps. */
+};
+
+/**
+ *  Buffers exchanged between the stages (bit field, to declare the inputs and the outputs of a stage).
+ */
+enum pipeline_buffer_e { PIP_BUF_IG = 1 << 0, /*!< Input grayscale image (full resolution). */
+                         PIP_BUF_BG = 1 << 1, /*!< Background (mean) and variance images (detection resolution). */
+                         PIP_BUF_IB = 1 << 2, /*!< Binary image. */
+                         PIP_BUF_L1 = 1 << 3, /*!< Labels (CCL). */
+                         PIP_BUF_RT = 1 << 4, /*!< RoIs of all the CCs (CCA). */
+                         PIP_BUF_RO = 1 << 5, /*!< Filtered RoIs (+ filtered labels if they are allocated). */
+                         PIP_BUF_AS = 1 << 6, /*!< RoIs associations (\f$t - 1\f$, \f$t\f$). */
+                         PIP_BUF_TR = 1 << 7 /*!< Tracks. */
+};
+
+/**
+ *  Parameters of the processing chain (the same as the command line ones).
+ */
+typedef struct {
+    int i0, i1, j0, j1; /*!< Input images dimensions. */
+    int sd_scale; /*!< Detection downscale factor (1 means full resolution). */
+    uint8_t sd_n; /*!< Value of the N parameter in the Sigma-Delta algorithm. */
+    size_t cca_roi_max1; /*!< Maximum number of RoIs after CCA. */
+    size_t cca_roi_max2; /*!< Maximum number of RoIs after surface filtering. */
+    uint32_t flt_s_min; /*!< Minimum surface of the CCs in pixels. */
+    uint32_t flt_s_max; /*!< Maximum surface of the CCs in pixels. */
+    int knn_k; /*!< k-NN: maximum number of neighbors considered. */
+    uint32_t knn_d; /*!< k-NN: maximum distance in pixels between two images. */
+    float knn_s; /*!< k-NN: minimum surface ratio to match two CCs. */
+    size_t trk_ext_d; /*!< Search radius in pixels for CC extrapolation. */
+    size_t trk_obj_min; /*!< Minimum number of frames required to track an object. */
+    uint8_t trk_ext_o; /*!< Maximum number of frames to extrapolate a track. */
+    uint8_t trk_save_RoIs_id; /*!< Boolean, save the RoI ids histories of the tracks. */
+    uint8_t with_L2; /*!< Boolean, allocate the filtered labels (for the CC debug frames). */
+    uint32_t external; /*!< Bit field of the global steps (`1 << step`) whose data are not allocated by the pipeline
+                            but given with `pipeline_set_data` (for instance to share them between pipelines). */
+} pipeline_params_t;
+
+/**
+ *  Stages data of a frame. The pipeline holds two of them (\f$t - 1\f$ and \f$t\f$): each one has its own detection
+ *  stages data (for instance its own Sigma-Delta model).
+ */
+typedef struct {
+    const uint8_t** IG; /*!< Input grayscale image of the last processed frame (view, not owned). */
+    const uint8_t** M; /*!< Background (mean) image (view on the Sigma-Delta data, not owned). */
+    const uint8_t** V; /*!< Variance image (view on the Sigma-Delta data, not owned). */
+    uint8_t** IB; /*!< Binary image. */
+    uint32_t** L1; /*!< Labels (CCL). */
+    uint32_t** L2; /*!< Labels (CCL + surface filter), NULL if not allocated. */
+    RoI_t* RoIs_tmp; /*!< RoIs of all the CCs. */
+    uint32_t n_RoIs_tmp; /*!< Number of RoIs in `RoIs_tmp`. */
+    RoI_t* RoIs; /*!< Filtered RoIs. */
+    uint32_t n_RoIs; /*!< Number of RoIs in `RoIs`. */
+    void* data[PIP_N_STAGES]; /*!< Inner data of the stages that work on a single frame (NULL for the others). */
+} pipeline_frame_t;
+
+struct pipeline_s;
+
+/**
+ *  Stage interface. A stage is an implementation of a step of the processing chain, it is declared once in the
+ *  registry of the pipeline engine.
+ */
+typedef struct {
+    enum pipeline_stage_e step; /*!< Implemented step. */
+    const char* name; /*!< Implementation name (unique for a given step). */
+    const char* desc; /*!< Short description. */
+    uint32_t inputs; /*!< Read buffers (`pipeline_buffer_e` bit field). */
+    uint32_t outputs; /*!< Written buffers (`pipeline_buffer_e` bit field). */
+    uint8_t per_frame; /*!< Boolean, 1 if the stage data are per frame (\f$t - 1\f$ and \f$t\f$), 0 if they are
+                            global to the pipeline. */
+    uint8_t stateful; /*!< Boolean, 1 if the stage data keep a state from one frame to the next (only for the global
+                           stages, the state of the per frame stages is set by `init`). */
+    void* (*alloc)(const struct pipeline_s* pip); /*!< Allocate and initialize the stage data (can be NULL). */
+    void (*init)(void* data, const struct pipeline_s* pip, pipeline_frame_t* fra); /*!< Initialize the stage data
+                                                                                         with the first frame (can be
+                                                                                         NULL). */
+    void (*process)(void* data, struct pipeline_s* pip, pipeline_frame_t* fra); /*!< Process a frame (for the global
+                                                                                     stages `fra` is the frame at
+                                                                                     \f$t\f$). */
+    void (*free)(void* data); /*!< Deallocate the stage data (can be NULL). */
+    void (*save)(const void* data, FILE* f); /*!< Write the state of the stage data in a checkpoint (NULL if there is
+                                                  nothing to restore, the data are then rebuilt from the frames). */
+    int (*load)(void* data, const struct pipeline_s* pip, pipeline_frame_t* fra, FILE* f); /*!< Read the state
+                                                                                                 written by `save`,
+                                                                                                 returns 0 or -1 on
+                                                                                                 error (NULL if
+                                                                                                 `save` is NULL). */
+} pipeline_stage_t;
+
+/**
+ *  Pipeline: the selected stages, their buffers (double-buffered between \f$t - 1\f$ and \f$t\f$) and their timings.
+ */
+typedef struct pipeline_s {
+    pipeline_params_t p; /*!< Parameters. */
+    int si0, si1, sj0, sj1; /*!< Detection images dimensions (downscaled by `p.sd_scale`). */
+    uint32_t sd_s_min; /*!< Minimum surface of the CCs before the full resolution refinement (downscaled). */
+    uint8_t** IS; /*!< Downscaled input image (NULL if `p.sd_scale` is 1). */
+    const pipeline_stage_t* stages[PIP_N_STAGES]; /*!< Selected stage for each step. */
+    pipeline_frame_t frames[2]; /*!< Frames data, `frames[0]` at \f$t - 1\f$ and `frames[1]` at \f$t\f$. */
+    void* data[PIP_N_STAGES]; /*!< Inner data of the global stages (NULL for the others). */
+    int cur_fra; /*!< Current frame number. */
+    uint32_t n_dropped; /*!< Number of frames dropped since the last association (see `pipeline_drop`). */
+    double stage_us[PIP_N_STAGES]; /*!< Accumulated time of each step (in microseconds). */
+} pipeline_t;
+
+/**
+ *  Frame in flight in an asynchronous pipeline: its own detection buffers (the stage data are the ones of
+ *  `frames[1]`, each step is run by a single thread).
+ */
+typedef struct {
+    pipeline_frame_t fra; /*!< Frame data. */
+    uint8_t** M; /*!< Copy of the background image of the frame, NULL if the detection is not downscaled (the model
+                      goes on with the next frames, the copy is read by the full resolution refinement). */
+    uint8_t** V; /*!< Copy of the variance image of the frame (same as `M`). */
+    int cur_fra; /*!< Frame number. */
+    void* user; /*!< Caller data attached to the frame (for instance the owner of `fra.IG`). */
+} pipeline_slot_t;
+
+/**
+ *  Group of consecutive steps run by a thread of an asynchronous pipeline, on the frames of its `in` queue, the
+ *  processed frames go to its `out` queue.
+ */
+typedef struct {
+    struct pipeline_async_s* async; /*!< Asynchronous pipeline of the group. */
+    int first; /*!< First step of the group. */
+    int last; /*!< Last step of the group (included). */
+    spsc_queue_t* in; /*!< Frames to process (previous group or caller -> group). */
+    spsc_queue_t* out; /*!< Processed frames (group -> next group or caller). */
+    pthread_t thread; /*!< Thread of the group. */
+    double busy_us; /*!< Accumulated processing time (in microseconds), safe to read once the pipeline is freed or
+                         when it is drained. */
+} pipeline_async_group_t;
+
+/**
+ *  Asynchronous pipeline: the detection steps run on their own threads, one frame per group at a time, so that the
+ *  frames \f$t + 1\f$, \f$t + 2\f$, ... are detected while the caller associates and logs the frame \f$t\f$. The
+ *  groups are connected by bounded SPSC queues of preallocated frames. The association steps (k-NN and tracking) run
+ *  on the caller thread, in the frames order (the tracks are never read while they are updated).
+ */
+typedef struct pipeline_async_s {
+    pipeline_t* pip; /*!< Pipeline (its frames are views on the slots until `pipeline_async_free`). */
+    pipeline_frame_t frames[2]; /*!< Frames of the pipeline, restored by `pipeline_async_free`. */
+    pipeline_slot_t* slots; /*!< Preallocated frames. */
+    size_t n_slots; /*!< Number of slots. */
+    pipeline_slot_t** free; /*!< Stack of the free slots (caller side only). */
+    size_t n_free; /*!< Number of slots in `free`. */
+    size_t n_pending; /*!< Number of pushed frames that have not been popped yet. */
+    pipeline_slot_t* held[2]; /*!< Slots of the two last popped frames (\f$t - 1\f$ and \f$t\f$), still read by the
+                                   caller. */
+    spsc_queue_t* queues[3]; /*!< Caller -> `groups[0]` -> `groups[1]` -> caller. */
+    pipeline_async_group_t groups[2]; /*!< Pixel steps (Sigma-Delta and morphology), then labels and RoIs steps
+                                           (CCL, CCA and surface filtering). */
+    uint8_t stop; /*!< Boolean, set to 1 to stop the threads (atomic access). */
+    double stall_us; /*!< Accumulated time spent by the caller waiting for a detected frame (in microseconds). */
+} pipeline_async_t;
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,3 +2,4 @@
 
 #include "motion/sigma_delta/sigma_delta_struct.h"
 #include "motion/sigma_delta/sigma_delta_compute.h"
+#include "motion/sigma_delta/sigma_delta_io.h"
@@ -0,0 +1,26 @@
+/*!
+ * \file
+ * \brief IOs for Sigma-Delta (background model checkpoints).
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include "motion/sigma_delta/sigma_delta_struct.h"
+
+/**
+ * Write the background model (mean and variance images) in binary (for a checkpoint).
+ * @param f File descriptor (in binary write mode).
+ * @param sd_data Inner Sigma-Delta data.
+ */
+void sigma_delta_data_write(FILE* f, const sigma_delta_data_t* sd_data);
+
+/**
+ * Read a background model written by `sigma_delta_data_write`. The images dimensions have to be the same as the
+ * `sd_data` ones.
+ * @param f File descriptor (in binary read mode).
+ * @param sd_data Inner Sigma-Delta data (the mean and variance images are overwritten).
+ * @return 0 on success, -1 if the model is truncated or if its dimensions differ.
+ */
+int sigma_delta_data_read(FILE* f, sigma_delta_data_t* sd_data);
@@ -0,0 +1,67 @@
+/*!
+ * \file
+ * \brief Bounded lock-free Single-Producer Single-Consumer (SPSC) queue.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Bounded lock-free queue of pointers. Exactly one thread can push and exactly one (other) thread can pop. The two
+ *  indexes are on separate cache lines to avoid false sharing between the producer and the consumer.
+ */
+typedef struct {
+    void** items; /**< Circular array of items (capacity `_mask + 1`). */
+    size_t _mask; /**< Capacity - 1 (the capacity is a power of 2). */
+    uint8_t _pad0[64]; /**< Padding to put `head` on its own cache line. */
+    size_t head; /**< Next item to pop (written by the consumer only). */
+    uint8_t _pad1[64]; /**< Padding to put `tail` on its own cache line. */
+    size_t tail; /**< Next free position to push (written by the producer only). */
+    uint8_t _pad2[64]; /**< Padding to keep `tail` away from the next allocated data. */
+} spsc_queue_t;
+
+/**
+ * Allocation of a SPSC queue.
+ * @param capacity Minimum number of items that can be stored (rounded up to the next power of 2).
+ * @return The allocated queue.
+ */
+spsc_queue_t* spsc_queue_alloc(const size_t capacity);
+
+/**
+ * Deallocation of a SPSC queue (the items themselves are not freed).
+ * @param queue A pointer of queue.
+ */
+void spsc_queue_free(spsc_queue_t* queue);
+
+/**
+ * Push an item (producer side only).
+ * @param queue A pointer of queue.
+ * @param item Item to push.
+ * @return 1 if the item has been pushed, 0 if the queue is full.
+ */
+int spsc_queue_push(spsc_queue_t* queue, void* item);
+
+/**
+ * Pop an item (consumer side only).
+ * @param queue A pointer of queue.
+ * @param item Return the popped item.
+ * @return 1 if an item has been popped, 0 if the queue is empty.
+ */
+int spsc_queue_pop(spsc_queue_t* queue, void** item);
+
+/**
+ * Number of items currently in the queue (approximate when called concurrently with a push or a pop).
+ * @param queue A pointer of queue.
+ * @return The number of items.
+ */
+size_t spsc_queue_size(const spsc_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,106 @@
+/*!
+ * \file
+ * \brief Multi-stream engine: independent detection/tracking pipelines scheduled on a shared pool of threads.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "motion/libmotion.h"
+#include "motion/video/video_struct.h"
+#include "motion/kNN/kNN_struct.h"
+
+/**
+ *  Stream: a video and its own pipeline state (Sigma-Delta model, CCL buffers, tracks, ...). A stream is processed
+ *  by a single worker at a time, by quantum of frames.
+ */
+typedef struct {
+    size_t id; /**< Stream id (position in the list of streams). */
+    const char* path; /**< Path of the video. */
+    video_reader_t* video; /**< Video reader. */
+    uint8_t** img; /**< Storage of the decoded frame (when the reader can't give a view without copy). */
+    int i0, i1, j0, j1; /**< Frames dimensions. */
+    motion_pipeline_t* mp; /**< Pipeline of the stream. */
+    uint8_t done; /**< Boolean, 1 when the end of the video has been reached. */
+    size_t n_frames; /**< Number of processed frames. */
+    size_t n_quanta; /**< Number of times the stream has been scheduled. */
+    size_t n_stolen; /**< Number of times the stream has been scheduled by another worker than the one that
+                          enqueued it. */
+    double dec_us; /**< Accumulated decoding time. */
+    double proc_us; /**< Accumulated processing time (pipeline). */
+    double wait_us; /**< Accumulated time spent in the ready queues (scheduling delay). */
+    double ready_us; /**< Time when the stream has been enqueued for the last time. */
+} stream_t;
+
+/**
+ *  Worker of the pool: a thread with its own ready queue of streams, it steals the streams of the other workers
+ *  when its queue is empty.
+ */
+typedef struct {
+    size_t id; /**< Worker id. */
+    pthread_t thread; /**< Thread of the worker. */
+    struct streams_s* engine; /**< Engine of the worker. */
+    stream_t** queue; /**< Ready queue, circular buffer of `n_streams` streams (a stream is at most in one queue). */
+    size_t head; /**< Index of the oldest stream in `queue`. */
+    size_t size; /**< Number of streams in `queue`. */
+    pthread_mutex_t mutex; /**< Protects `queue`, `head` and `size`. */
+    kNN_data_t* kNN_data; /**< k-NN matrices of the worker, lent to the pipeline of the scheduled stream (they do
+                               not keep any state from one frame to the next). */
+    size_t n_quanta; /**< Number of processed quanta. */
+    size_t n_steals; /**< Number of stolen streams. */
+    double busy_us; /**< Accumulated time spent in processing streams. */
+} streams_worker_t;
+
+/**
+ *  Multi-stream engine.
+ */
+typedef struct streams_s {
+    stream_t* streams; /**< Streams. */
+    size_t n_streams; /**< Number of streams. */
+    streams_worker_t* workers; /**< Workers. */
+    size_t n_workers; /**< Number of workers. */
+    size_t quantum; /**< Number of frames of a stream processed in a row before it goes back to a ready queue (the
+                         streams are scheduled in round-robin, this bounds the scheduling delay). */
+    size_t n_running; /**< Number of streams that are not done. */
+    size_t n_idle; /**< Number of workers waiting for a stream. */
+    pthread_mutex_t mutex; /**< Protects `n_running` and `n_idle`. */
+    pthread_cond_t cond; /**< Signaled when a stream is enqueued or when all the streams are done. */
+    double run_us; /**< Duration of the last `streams_run`. */
+} streams_t;
+
+/**
+ * Allocation and initialization of a multi-stream engine. The videos are opened and a pipeline is created for each
+ * of them.
+ * @param paths Paths of the videos.
+ * @param n_streams Number of videos.
+ * @param params Parameters of the pipelines (the frames size is taken from each video).
+ * @param codec_type Decoder of the videos.
+ * @param n_workers Number of threads of the pool (>= 1).
+ * @param quantum Number of frames processed in a row for a stream (>= 1).
+ * @return The allocated engine.
+ */
+streams_t* streams_alloc_init(const char** paths, const size_t n_streams, const motion_params_t* params,
+                              const enum video_codec_e codec_type, const size_t n_workers, const size_t quantum);
+
+/**
+ * Process all the streams until the end of their videos (blocking call).
+ * @param engine A pointer of multi-stream engine.
+ */
+void streams_run(streams_t* engine);
+
+/**
+ * Print the statistics of the streams and of the workers.
+ * @param f File descriptor (in write mode).
+ * @param engine A pointer of multi-stream engine.
+ */
+void streams_stats_print(FILE* f, const streams_t* engine);
+
+/**
+ * Deallocation of a multi-stream engine.
+ * @param engine A pointer of multi-stream engine.
+ */
+void streams_free(streams_t* engine);
@@ -34,6 +34,8 @@ void tracking_free_data(tracking_data_t* tracking_data);
  * @param RoIs Features (at \f$t\f$).
  * @param n_RoIs Number of connected-components (= number of RoIs) (at \f$t\f$).
  * @param frame Current frame number.
+ * @param fra_gap Number of frames since the previous call (1 if no frame has been dropped in between): the motion
+ *                of the tracks is extrapolated over the gap and the lost tracks age by as many frames.
  * @param r_extrapol Accepted range for extrapolation.
  * @param fra_obj_min Minimum number of CC/RoI associations before creating a obj track.
  * @param save_RoIs_id Boolean to save the list of the RoI ids for each tracks.
@@ -42,5 +44,14 @@ void tracking_free_data(tracking_data_t* tracking_data);
  *                             \f$r_S < r_S^{min}\f$ then the association for the extrapolation is not made.
  */
 void tracking_perform(tracking_data_t* tracking_data, const RoI_t* RoIs, const size_t n_RoIs, size_t frame,
-                      const size_t r_extrapol, const size_t fra_obj_min, const uint8_t save_RoIs_id,
-                      const uint8_t extrapol_order_max, const float min_extrapol_ratio_S);
+                      const uint32_t fra_gap, const size_t r_extrapol, const size_t fra_obj_min,
+                      const uint8_t save_RoIs_id, const uint8_t extrapol_order_max, const float min_extrapol_ratio_S);
+
+/**
+ * Give back to the pool the RoI ids histories of the finished tracks that ended before a given frame. This is useful
+ * when the histories are only required for a limited time (for instance by the visualization) and not until the end
+ * of the program.
+ * @param tracking_data Inner data.
+ * @param frame_min The histories of the finished tracks with `end.frame` < \p frame_min are released.
+ */
+void tracking_release_RoIs_id(tracking_data_t* tracking_data, const uint32_t frame_min);
@@ -29,3 +29,22 @@ void tracking_tracks_write_full(FILE* f, const vec_track_t tracks);
  * @param tracks A vector of tracks.
  */
 void tracking_tracks_RoIs_id_write(FILE* f, const vec_track_t tracks);
+
+/**
+ * Write the tracking state in binary (for a checkpoint): the RoIs history, the tracks and their RoI ids histories.
+ * The temporary buffers are not written. The format is the memory layout of the structures, it can only be read by
+ * the same build.
+ * @param f File descriptor (in binary write mode).
+ * @param tracking_data Inner tracking data.
+ */
+void tracking_data_write(FILE* f, const tracking_data_t* tracking_data);
+
+/**
+ * Read a tracking state written by `tracking_data_write`: the current tracks are replaced. The history size and
+ * the maximum number of RoIs have to be the same as the `tracking_data` ones.
+ * @param f File descriptor (in binary read mode).
+ * @param tracking_data Inner tracking data.
+ * @return 0 on success, -1 if the state is truncated or does not match `tracking_data` (the tracks read so far
+ *         are kept, they can be cleared).
+ */
+int tracking_data_read(FILE* f, tracking_data_t* tracking_data);
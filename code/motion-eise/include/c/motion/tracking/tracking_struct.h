@@ -10,6 +10,10 @@
 
 #include "motion/features/features_struct.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  *  Enumeration of the states in the tracking finite-state machine.
  */
@@ -25,6 +29,44 @@ enum state_e { STATE_UNKNOWN = 0, /*!< Unknown (= uninitialized). */
  */
 typedef uint32_t* vec_uint32_t;
 
+/**
+ *  Number of RoI ids stored in a single chunk of a track history (a chunk fits in 128 bytes on 64-bit systems).
+ */
+#define TRACKING_RoIs_ID_CHUNK_SIZE 28
+
+/**
+ *  Fixed-size chunk of RoI ids. The chunks of a same track are doubly linked to form its RoI ids history.
+ */
+typedef struct RoIs_id_chunk_t {
+    uint32_t ids[TRACKING_RoIs_ID_CHUNK_SIZE]; /**< RoI ids (0 means that the RoI has been extrapolated). */
+    struct RoIs_id_chunk_t* prev; /**< Previous chunk in the history (NULL for the first chunk). */
+    struct RoIs_id_chunk_t* next; /**< Next chunk in the history (NULL for the last chunk), also used to link the free
+                                       chunks of the pool together. */
+} RoIs_id_chunk_t;
+
+/**
+ *  RoI ids history of a track. This is a list of chunks allocated from a `RoIs_id_pool_t`.
+ */
+typedef struct {
+    RoIs_id_chunk_t* head; /**< First chunk (NULL if the history is empty). */
+    RoIs_id_chunk_t* tail; /**< Last chunk, this is where the new RoI ids are appended. */
+    size_t size; /**< Number of RoI ids in the history. */
+} RoIs_id_list_t;
+
+/**
+ *  Slab allocator of `RoIs_id_chunk_t`. The chunks are allocated by slabs of `slab_n_chunks` elements and the chunks
+ *  of the released histories are recycled through a free list. In steady state, appending a RoI id to a history does
+ *  not allocate memory.
+ */
+typedef struct {
+    RoIs_id_chunk_t** slabs; /**< Vector of slabs, to use with C vector lib. */
+    RoIs_id_chunk_t* free_list; /**< Linked list of the available chunks. */
+    size_t slab_n_chunks; /**< Number of chunks per slab. */
+    size_t n_chunks; /**< Total number of allocated chunks (used + free). */
+    size_t n_free_chunks; /**< Number of chunks in the free list. */
+    size_t n_ids; /**< Number of RoI ids currently stored in the used chunks. */
+} RoIs_id_pool_t;
+
 typedef struct {
     RoI_t r;
     uint32_t frame;
@@ -53,7 +95,8 @@ typedef struct {
     uint8_t extrapol_order; /**< Number of times this track has been extrapolated (used only if `state` ==
                                  `STATE_LOST`). */
     enum state_e state; /**< State of the track. */
-    vec_uint32_t RoIs_id; /**< Vector of the RoI ids history of this track. */
+    RoIs_id_list_t RoIs_id; /**< RoI ids history of this track (empty if the RoI ids are not saved or if the history
+                                 has been released). */
 } track_t;
 
 /**
@@ -78,6 +121,14 @@ typedef struct {
     size_t _max_size; /**< Maximum capacity of data that can be contained in the fields. */
 } History_t;
 
+/**
+ *  Candidate RoI proposed by a track during the update of the existing tracks.
+ */
+typedef struct {
+    uint32_t RoI_id; /**< Proposed RoI id at \f$t\f$ (0 if the track has no candidate). */
+    uint8_t is_knn; /**< Boolean, 1 if the RoI comes from the k-NN association, 0 if it comes from the extrapolation. */
+} track_proposal_t;
+
 /**
  *  Inner data used by the tracking.
  */
@@ -86,6 +137,9 @@ typedef struct {
     History_t* history; /**< RoIs and motions history. */
     RoI4track_t* RoIs_list; /**< List of RoIs. This is a temporary array used to group all the RoIs belonging to a same
                                  track. */
+    RoIs_id_pool_t* RoIs_id_pool; /**< Allocator of the tracks RoI ids histories. */
+    track_proposal_t* proposals; /**< Per-track candidate RoIs, used to update the existing tracks in parallel. */
+    size_t _max_proposals; /**< Capacity of the `proposals` array (grows with the number of tracks). */
 } tracking_data_t;
 
 /**
@@ -110,3 +164,59 @@ size_t tracking_get_track_time(const vec_track_t tracks, const size_t t);
  * @return The real number of tracks (may be less than the \p tracks vector size).
  */
 size_t tracking_count_objects(const vec_track_t tracks);
+
+/**
+ * Allocation of a pool of RoI ids chunks.
+ * @param slab_n_chunks Number of chunks allocated at once when the pool is empty.
+ * @return The allocated pool.
+ */
+RoIs_id_pool_t* tracking_RoIs_id_pool_alloc(const size_t slab_n_chunks);
+
+/**
+ * Free a pool of RoI ids chunks. All the histories allocated from this pool become invalid.
+ * @param pool Pointer of the pool.
+ */
+void tracking_RoIs_id_pool_free(RoIs_id_pool_t* pool);
+
+/**
+ * Append a RoI id at the end of a RoI ids history.
+ * @param pool Pool used to allocate a new chunk when the last chunk of the history is full.
+ * @param list RoI ids history.
+ * @param id RoI id to append.
+ */
+void tracking_RoIs_id_add(RoIs_id_pool_t* pool, RoIs_id_list_t* list, const uint32_t id);
+
+/**
+ * Get a RoI id from a RoI ids history. The list is walked from its closest end (the most recent ids are the fastest
+ * to access).
+ * @param list RoI ids history.
+ * @param pos Position of the RoI id in the history (has to be smaller than `list->size`).
+ * @return The RoI id.
+ */
+uint32_t tracking_RoIs_id_get(const RoIs_id_list_t* list, const size_t pos);
+
+/**
+ * Give back all the chunks of a RoI ids history to the pool. The history is empty after this call.
+ * @param pool Pool from which the chunks have been allocated.
+ * @param list RoI ids history.
+ */
+void tracking_RoIs_id_release(RoIs_id_pool_t* pool, RoIs_id_list_t* list);
+
+/**
+ * Memory footprint of a pool of RoI ids chunks.
+ * @param pool Pointer of the pool.
+ * @return The number of bytes allocated by the pool.
+ */
+size_t tracking_RoIs_id_pool_footprint(const RoIs_id_pool_t* pool);
+
+/**
+ * Fragmentation of a pool of RoI ids chunks: ratio of allocated RoI id slots that do not contain a RoI id (free
+ * chunks plus the unused end of the last chunk of each history).
+ * @param pool Pointer of the pool.
+ * @return The fragmentation ratio in \f$[0;1]\f$.
+ */
+float tracking_RoIs_id_pool_fragmentation(const RoIs_id_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,12 +13,19 @@
  * @param start Start frame number (first frame is frame 0).
  * @param end Last frame number (if 0 then the video sequence is entirely read).
  * @param skip Number of frames to skip between two frames (0 means no frame is skipped).
- * @param bufferize Boolean to store the entire video sequence in memory first (this is useful for benchmarks
- *                  but usually the video sequences are too big to be stored in memory).
+ * @param bufferize Store the entire video sequence in memory first (`VBUF_NONE`, `VBUF_RAW` or `VBUF_DELTA_RLE`),
+ *                  this is useful for benchmarks but usually the video sequences are too big to be stored in memory
+ *                  without compression.
  * @param n_ffmpeg_threads Number of threads used in FFMPEG to decode the video sequence (0 means FFMPEG will decide).
- * @param codec_type Select the API to use for video codec (`VCDC_FFMPEG_IO` or `VCDC_VCODECS_IO`).
+ * @param codec_type Select the API to use for video codec (`VCDC_FFMPEG_IO`, `VCDC_VCODECS_IO`, `VCDC_NATIVE` or
+ *                   `VCDC_SHM`: the path is a shared-memory frames ring).
  * @param hwaccel Select Hardware accelerator (`VCDC_HWACCEL_NONE`, `VCDC_HWACCEL_NVDEC`, `VCDC_HWACCEL_VIDEOTOOLBOX`).
  *                A NULL value will default to `VCDC_HWACCEL_NONE`.
+ * @param raw_width Frames width of a raw gray8 input (`VCDC_NATIVE` only, 0 for Y4M and PGM inputs).
+ * @param raw_height Frames height of a raw gray8 input (`VCDC_NATIVE` only, 0 for Y4M and PGM inputs).
+ * @param cache_path Path to a decoded-frame cache (can be NULL). If the cache exists and matches the source and the
+ *                   `start`, `end` and `skip` parameters, the frames are directly read from the memory-mapped cache
+ *                   (no decoding). Otherwise the video is entirely decoded in a new cache first.
  * @param i0 Return the first \f$y\f$ index in the labels (included).
  * @param i1 Return the last \f$y\f$ index in the labels (included).
  * @param j0 Return the first \f$x\f$ index in the labels (included).
@@ -28,8 +35,53 @@
 video_reader_t* video_reader_alloc_init(const char* path, const size_t start, const size_t end, const size_t skip,
                                         const int bufferize, const size_t n_ffmpeg_threads,
                                         const enum video_codec_e codec_type, const enum video_codec_hwaccel_e hwaccel,
+                                        const size_t raw_width, const size_t raw_height, const char* cache_path,
                                         int* i0, int* i1, int* j0, int* j1);
 
+/**
+ * Check that a video can be opened by `video_reader_alloc_init` without exiting on failure (for instance to skip the
+ * bad inputs of a batch). The stream headers are read, the frames are not decoded. A shared-memory ring can't be
+ * probed, it is always considered valid.
+ * @param path Path to the video or images.
+ * @param codec_type Select the API to use for video codec (see `video_reader_alloc_init`).
+ * @param raw_width Frames width of a raw gray8 input (`VCDC_NATIVE` only, 0 for Y4M and PGM inputs).
+ * @param raw_height Frames height of a raw gray8 input (`VCDC_NATIVE` only, 0 for Y4M and PGM inputs).
+ * @return 1 if the video can be opened, 0 otherwise.
+ */
+int video_reader_probe(const char* path, const enum video_codec_e codec_type, const size_t raw_width,
+                       const size_t raw_height);
+
+/**
+ * Allocation and initialization of a video reader that decodes the video by segments in parallel, for offline
+ * processing. The video is split in segments of `seg_len` frames, each segment is read by its own video reader
+ * (started at the first frame of the segment) and `n_segments` segments are decoded at the same time in separate
+ * threads. The frames are given back in order by `video_reader_get_frame` (or `video_reader_get_frame_view`).
+ * @param path Path to the video or images.
+ * @param start Start frame number (first frame is frame 0).
+ * @param end Last frame number (if 0 then the video sequence is entirely read).
+ * @param skip Number of frames to skip between two frames (0 means no frame is skipped).
+ * @param n_segments Number of segments decoded in parallel (>= 1).
+ * @param seg_len Number of frames in a segment (>= 1), larger segments amortize the start of the decoders (and the
+ *                decoding of the frames between the previous key frame and the start of the segment).
+ * @param n_frames Number of preallocated frames per segment decoder (decode-ahead depth, >= 3).
+ * @param n_ffmpeg_threads Number of threads used by each segment decoder (0 means FFMPEG will decide).
+ * @param codec_type Decoder used to read the segments (`VCDC_FFMPEG_IO`, `VCDC_VCODECS_IO` or `VCDC_NATIVE`).
+ * @param hwaccel Hardware accelerator of the segment decoders.
+ * @param raw_width Frames width of a raw gray8 input (`VCDC_NATIVE` only).
+ * @param raw_height Frames height of a raw gray8 input (`VCDC_NATIVE` only).
+ * @param i0 Return the first \f$y\f$ index in the labels (included).
+ * @param i1 Return the last \f$y\f$ index in the labels (included).
+ * @param j0 Return the first \f$x\f$ index in the labels (included).
+ * @param j1 Return the last \f$x\f$ index in the labels (included).
+ * @return The allocated data.
+ */
+video_reader_t* video_reader_segments_alloc_init(const char* path, const size_t start, const size_t end,
+                                                 const size_t skip, const size_t n_segments, const size_t seg_len,
+                                                 const size_t n_frames, const size_t n_ffmpeg_threads,
+                                                 const enum video_codec_e codec_type,
+                                                 const enum video_codec_hwaccel_e hwaccel, const size_t raw_width,
+                                                 const size_t raw_height, int* i0, int* i1, int* j0, int* j1);
+
 /**
  * Write grayscale image in a given 2D array.
  * @param video A pointer of previously allocated inner video reader data.
@@ -38,12 +90,65 @@ video_reader_t* video_reader_alloc_init(const char* path, const size_t start, co
  */
 int video_reader_get_frame(video_reader_t* video, uint8_t** img);
 
+/**
+ * Get the next frame as a read-only view. When the decoder allows it (`VCDC_VCODECS_IO`, `VCDC_NATIVE`, `VCDC_SEGMENTS`, a frame cache or a buffered video), the
+ * view points directly into the decoder memory and no copy is made. Otherwise the frame is copied into `img` and the
+ * view points on `img`.
+ * @param video A pointer of previously allocated inner video reader data.
+ * @param img Grayscale image used as storage when the frame can't be exposed without copy (2D array
+ *            \f$[i1 - i0 + 1][j1 - j0 + 1]\f$).
+ * @param view Return the rows of the frame. A view on the decoder memory remains valid until two more frames are
+ *             read (the views of the frames at \f$t\f$ and \f$t - 1\f$ can be used together).
+ * @return The frame id (positive integer) or -1 if there is no more frame to read.
+ */
+int video_reader_get_frame_view(video_reader_t* video, uint8_t** img, const uint8_t*** view);
+
+/**
+ * Frame rate of the returned frames (the skipped frames are taken into account), it is known for `VCDC_FFMPEG_IO`
+ * only.
+ * @param video A pointer of previously allocated inner video reader data.
+ * @return The number of frames per second, 0 if it is unknown.
+ */
+double video_reader_get_frame_rate(const video_reader_t* video);
+
 /**
  * Deallocation of inner video reader data.
  * @param video A pointer of video reader inner data.
  */
 void video_reader_free(video_reader_t* video);
 
+/**
+ * Allocation and initialization of an asynchronous video reader. A decoder thread is started, it reads the frames
+ * from `video` ahead of the pipeline.
+ * @param video A pointer of previously allocated inner video reader data (owned by the asynchronous reader until it
+ *              is freed, it should not be used directly in the meantime).
+ * @param n_frames Number of preallocated frames in the ring (decode-ahead depth, >= 1).
+ * @param i0 First \f$y\f$ index in the frames (included).
+ * @param i1 Last \f$y\f$ index in the frames (included).
+ * @param j0 First \f$x\f$ index in the frames (included).
+ * @param j1 Last \f$x\f$ index in the frames (included).
+ * @return The allocated data.
+ */
+video_reader_async_t* video_reader_async_alloc_init(video_reader_t* video, const size_t n_frames, const int i0,
+                                                    const int i1, const int j0, const int j1);
+
+/**
+ * Get the next decoded frame by pointer swap: the image pointed by `img` goes back to the decoder thread and is
+ * replaced by the decoded one. `*img` has to be allocated with `ui8matrix(i0, i1, j0, j1)`. This call blocks if the
+ * decoder thread is late.
+ * @param async A pointer of previously allocated asynchronous video reader.
+ * @param img Input/output grayscale image (2D array \f$[i1 - i0 + 1][j1 - j0 + 1]\f$), untouched at the end of the
+ *            video.
+ * @return The frame id (positive integer) or -1 if there is no more frame to read.
+ */
+int video_reader_async_get_frame(video_reader_async_t* async, uint8_t*** img);
+
+/**
+ * Stop the decoder thread and deallocate the asynchronous video reader (the underlying video reader is not freed).
+ * @param async A pointer of asynchronous video reader.
+ */
+void video_reader_async_free(video_reader_async_t* async);
+
 /**
  * Allocation and initialization of inner data required for a video writer.
  * @param path Path to the video or images.
@@ -68,7 +173,52 @@ video_writer_t* video_writer_alloc_init(const char* path, const size_t start, co
 void video_writer_save_frame(video_writer_t* video, const uint8_t** img);
 
 /**
- * Deallocation of inner video writer data.
+ * Start a writer thread: from now `video_writer_save_frame` copies the frames into a ring of `n_frames` preallocated
+ * frames and returns, the frames are encoded by the writer thread in the same order. A player (`win_play`) is not
+ * started in a thread: it remains synchronous.
+ * @param video A pointer of previously allocated inner video writer data.
+ * @param n_frames Number of preallocated frames in the ring (>= 1).
+ * @param policy What to do when all the frames of the ring are waiting to be encoded (block or drop).
+ */
+void video_writer_async_start(video_writer_t* video, const size_t n_frames, const enum video_writer_policy_e policy);
+
+/**
+ * Wait until the writer thread has encoded all the saved frames (does nothing without writer thread). After this call
+ * the statistics of `video->async` can be read.
+ * @param video A pointer of previously allocated inner video writer data.
+ */
+void video_writer_flush(video_writer_t* video);
+
+/**
+ * Deallocation of inner video writer data. With a writer thread, the remaining frames are encoded first.
  * @param video A pointer of video writer inner data.
  */
 void video_writer_free(video_writer_t* video);
+
+/**
+ * Create a shared-memory frames ring (see `video_shm_header_t`) that can be read by a video reader (`VCDC_SHM`). The
+ * ring is created under the `<path>.tmp` name and renamed once initialized, it is not removed by
+ * `video_shm_writer_free`.
+ * @param path Path of the ring (for instance `/dev/shm/<name>`).
+ * @param width Frames width.
+ * @param height Frames height.
+ * @param n_slots Number of frames in the ring (>= 3).
+ * @return The allocated producer.
+ */
+video_shm_writer_t* video_shm_writer_alloc_init(const char* path, const size_t width, const size_t height,
+                                                const size_t n_slots);
+
+/**
+ * Publish a frame in the shared-memory ring.
+ * @param shm A pointer of previously allocated producer.
+ * @param img Input grayscale image (2D array \f$[\texttt{height}][\texttt{width}]\f$).
+ * @param block If the ring is full: wait for the consumer (1) or drop the frame (0).
+ * @return 1 if the frame has been published, 0 if it has been dropped.
+ */
+int video_shm_writer_save_frame(video_shm_writer_t* shm, const uint8_t** img, const int block);
+
+/**
+ * Mark the end of the stream in the shared-memory ring and deallocate the producer.
+ * @param shm A pointer of previously allocated producer.
+ */
+void video_shm_writer_free(video_shm_writer_t* shm);
@@ -7,14 +7,31 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <pthread.h>
+
+#include "motion/spsc_queue.h"
 
 /**
  *  Video codec enumeration
  */
 enum video_codec_e { VCDC_FFMPEG_IO = 0, /*!< Library calling the `ffmpeg` executable. The communication is made through
                                               system pipes. */
-                     VCDC_VCODECS_IO, /*!< Library based on `AVCodec` library calls. It should be faster than
-                                           `VCDC_FFMPEG_IO`. */
+                     VCDC_VCODECS_IO, /*!< In-process decoding based on `libavformat`/`libavcodec` calls. It is
+                                           faster than `VCDC_FFMPEG_IO` (no pipe) and can expose the decoded luma
+                                           plane without copy (see `video_reader_get_frame_view`).
+                                           Experimental: it is not selectable from the `--vid-in-codec` option
+                                           yet. */
+                     VCDC_NATIVE, /*!< In-process readers for Y4M streams, PGM images sequences and raw gray8
+                                       streams (no external process). Regular files are memory-mapped and the frames
+                                       are exposed without copy, "-" reads the standard input. */
+                     VCDC_SHM, /*!< Frames read from a shared-memory ring filled by another process (see
+                                    `video_shm_header_t`), the frames are exposed without copy. */
+                     VCDC_SEGMENTS, /*!< Frames decoded by segments in parallel (see
+                                         `video_reader_segments_alloc_init`), this is not a real codec: each segment
+                                         is read with one of the other decoders. */
+                     VCDC_FRAME_CACHE, /*!< Frames read from a memory-mapped decoded-frame cache (see
+                                            `video_cache_header_t`), this is not a real codec: a video reader gets
+                                            this type when it is allocated with a valid cache. */
 };
 
 /**
@@ -26,11 +43,131 @@ enum video_codec_hwaccel_e {
     VCDC_HWACCEL_VIDEOTOOLBOX, /*!< Use Videotoolbox on Apple devices. */
 };
 
+/**
+ *  Video buffering enumeration (`bufferize` parameter of `video_reader_alloc_init`).
+ */
+enum video_buffer_e { VBUF_NONE = 0, /*!< Frames are decoded on the fly. */
+                      VBUF_RAW, /*!< All the frames are decoded in memory first. */
+                      VBUF_DELTA_RLE, /*!< All the frames are decoded in memory first, each frame is stored as its
+                                           difference with the previous frame and the unchanged bytes are run-length
+                                           coded (see `video_zbuffer_t`). */
+};
+
+/**
+ *  Compressed frames buffer (`VBUF_DELTA_RLE`). The frames are decoded in order in the two `ref` frames.
+ */
+typedef struct {
+    uint8_t** frames; /*!< Compressed frames. */
+    size_t* sizes; /*!< Sizes in bytes of the compressed frames. */
+    unsigned width; /*!< Frames width. */
+    unsigned height; /*!< Frames height. */
+    int i0; /*!< First \f$y\f$ index of the `ref` frames (the pixels start at `ref[r][i0] + j0`). */
+    int j0; /*!< First \f$x\f$ index of the `ref` frames. */
+    uint8_t** ref[2]; /*!< Two last decompressed frames (the next frame is decoded with the last one as reference). */
+    int cur; /*!< Index in `ref` of the last decompressed frame. */
+    size_t last; /*!< Index in `frames` of the last decompressed frame. */
+    size_t raw_size; /*!< Size in bytes of the frames before compression. */
+    size_t zip_size; /*!< Size in bytes of the compressed frames. */
+    double decode_us; /*!< Cumulated time spent in the decompression (in us). */
+    size_t n_decoded; /*!< Number of decompressed frames. */
+} video_zbuffer_t;
+
+#define VIDEO_CACHE_MAGIC "MOTIONFC" /*!< Magic number of the decoded-frame cache files (8 characters). */
+#define VIDEO_CACHE_VERSION 1 /*!< Version of the decoded-frame cache file format. */
+#define VIDEO_CACHE_HEADER_SIZE 4096 /*!< Size in bytes of the cache header (frames are page aligned). */
+
+/**
+ *  Header of a decoded-frame cache file. The file is made of this header (padded to `VIDEO_CACHE_HEADER_SIZE` bytes)
+ *  followed by `n_frames` grayscale frames of `width` \f$\times\f$ `height` bytes stored contiguously (row-major,
+ *  no padding). The frames are the ones returned by the video reader for the given `frame_start`, `frame_end` and
+ *  `frame_skip` parameters. A cache is reused only if these parameters and the source file (path, size and
+ *  modification time) match, otherwise it is rebuilt.
+ */
+typedef struct {
+    char magic[8]; /*!< `VIDEO_CACHE_MAGIC` (not null-terminated). */
+    uint32_t version; /*!< `VIDEO_CACHE_VERSION`. */
+    uint32_t width; /*!< Frames width in pixels. */
+    uint32_t height; /*!< Frames height in pixels. */
+    uint32_t _reserved; /*!< Unused, set to 0. */
+    uint64_t n_frames; /*!< Number of frames in the file. */
+    uint64_t frame_start; /*!< Start frame number used to decode the source. */
+    uint64_t frame_end; /*!< Last frame number used to decode the source (0 means the entire video). */
+    uint64_t frame_skip; /*!< Number of skipped frames between two frames used to decode the source. */
+    uint64_t src_size; /*!< Size in bytes of the source file (0 for an images sequence). */
+    int64_t src_mtime; /*!< Modification time of the source file (0 for an images sequence). */
+    char src_path[2048]; /*!< Path to the source video or images. */
+} video_cache_header_t;
+
+#define VIDEO_SHM_MAGIC "MOTIONSH" /*!< Magic number of the shared-memory frames rings (8 characters). */
+#define VIDEO_SHM_VERSION 1 /*!< Version of the shared-memory frames ring format. */
+#define VIDEO_SHM_HEADER_SIZE 4096 /*!< Size in bytes of the ring header (the first slot is page aligned). */
+#define VIDEO_SHM_SLOT_HEADER_SIZE 64 /*!< Size in bytes of a slot header (the frame follows it). */
+
+/**
+ *  Header of a shared-memory frames ring (`VCDC_SHM`), written by one producer process and read by one consumer
+ *  process. The shared-memory object (a file of `/dev/shm`, or of any other mapped file system) is made of this header
+ *  (padded to `VIDEO_SHM_HEADER_SIZE` bytes) followed by `n_slots` slots of `slot_size` bytes. A slot starts with a
+ *  `video_shm_slot_t` (padded to `VIDEO_SHM_SLOT_HEADER_SIZE` bytes) followed by a grayscale frame of `width`
+ *  \f$\times\f$ `height` bytes (row-major, no padding). All the fields are in the native byte order.
+ *
+ *  Protocol (all the accesses to the `write_*`, `read_*`, `*_waiting` and `eos` fields are atomic):
+ *  - the producer creates the object under a temporary name, fills the header (counters at 0) and renames it, so the
+ *    consumer never sees a partial header;
+ *  - the frames are numbered from 0 without gap (a producer that can't wait drops a frame before numbering it). The
+ *    frame `n` is written in the slot `n % n_slots`, only if `n < read_seq + n_slots`. The producer writes the pixels
+ *    and the slot `seq`, then stores `n + 1` in `write_seq` and in `write_futex`, and wakes `write_futex` (futex)
+ *    if `consumer_waiting` is set;
+ *  - the consumer reads the frame `r` once `write_seq > r`. It keeps the two last returned frames: when it moves to
+ *    the frame `r`, it stores the previously returned frame (`r - 1` when no frame is skipped) in `read_seq` and in
+ *    `read_futex`, and wakes `read_futex` if `producer_waiting` is set;
+ *  - before waiting on a futex, a process sets its `*_waiting` flag then checks the condition again;
+ *  - at the end of the stream, the producer sets `eos` and wakes the consumer. The object is left in place (the next
+ *    producer replaces it).
+ *  `n_slots` has to be at least 3 (two frames are held by the consumer), and at least 2 plus the number of frames
+ *  skipped between two returned frames (the skipped frames are held until the next returned frame).
+ */
+typedef struct {
+    char magic[8]; /*!< `VIDEO_SHM_MAGIC` (not null-terminated). */
+    uint32_t version; /*!< `VIDEO_SHM_VERSION`. */
+    uint32_t width; /*!< Frames width in pixels. */
+    uint32_t height; /*!< Frames height in pixels. */
+    uint32_t n_slots; /*!< Number of slots in the ring. */
+    uint64_t slot_size; /*!< Size in bytes of a slot (slot header + frame, a multiple of 64). */
+    uint8_t _pad0[32]; /*!< Padding to put the producer fields on their own cache line. */
+    uint64_t write_seq; /*!< Number of published frames (written by the producer). */
+    uint32_t write_futex; /*!< Low 32 bits of `write_seq`, futex word (written by the producer). */
+    uint32_t eos; /*!< Boolean, set to 1 by the producer at the end of the stream. */
+    uint32_t producer_waiting; /*!< Boolean, 1 when the producer waits for a free slot. */
+    uint8_t _pad1[44]; /*!< Padding to put the consumer fields on their own cache line. */
+    uint64_t read_seq; /*!< Oldest frame still used by the consumer, the previous slots are free (written by the
+                            consumer). */
+    uint32_t read_futex; /*!< Low 32 bits of `read_seq`, futex word (written by the consumer). */
+    uint32_t consumer_waiting; /*!< Boolean, 1 when the consumer waits for a new frame. */
+} video_shm_header_t;
+
+/**
+ *  Header of a slot of a shared-memory frames ring (see `video_shm_header_t`).
+ */
+typedef struct {
+    uint64_t seq; /*!< Number of the frame in the slot. */
+} video_shm_slot_t;
+
+/**
+ *  Producer side of a shared-memory frames ring (see `video_shm_header_t`).
+ */
+typedef struct {
+    video_shm_header_t* header; /*!< Mapped ring (header and slots). */
+    size_t map_size; /*!< Size in bytes of the mapping. */
+    double stall_us; /*!< Accumulated time spent waiting for a free slot (in microseconds). */
+    size_t n_dropped; /*!< Number of frames dropped because the ring was full. */
+} video_shm_writer_t;
+
 /**
  *  Video reader structure.
  */
 typedef struct {
-    enum video_codec_e codec_type; /*!< Video decoder type (`VCDC_FFMPEG_IO` or `VCDC_VCODECS_IO`). */
+    enum video_codec_e codec_type; /*!< Video decoder type (`VCDC_FFMPEG_IO`, `VCDC_VCODECS_IO`, `VCDC_NATIVE`,
+                                        `VCDC_SHM`, `VCDC_SEGMENTS` or `VCDC_FRAME_CACHE`). */
     void* metadata; /*!< Internal metadata used by the video decoder. */
     size_t frame_start; /*!< Start frame number (first frame is frame 0). */
     size_t frame_end; /*!< Last frame number. */
@@ -39,13 +176,42 @@ typedef struct {
     char path[2048]; /*!< Path to the video or images. */
 
     uint8_t*** fra_buffer; /*!< Buffer containing the all frames in memory (may be allocated or not depending on the
-                                implementation). */
-    size_t fra_count; /*!< Number of frames in `fra_buffer` array. */
+                                implementation). It grows with the video, there is no limit on the number of
+                                frames. */
+    video_zbuffer_t* fra_zbuffer; /*!< Compressed frames buffer (allocated with `VBUF_DELTA_RLE` only). */
+    size_t fra_count; /*!< Number of frames in `fra_buffer` array (or in `fra_zbuffer` or in the frame cache). */
     size_t loop_size; /*!< Number of times the video sequence should be played in loop (1 means that the video sequence
                            is played once). */
     size_t cur_loop; /*!< Current loop. */
 } video_reader_t;
 
+/**
+ *  Frame slot exchanged between the decoder thread and the pipeline.
+ */
+typedef struct {
+    uint8_t** img; /*!< Grayscale image (2D array \f$[i1 - i0 + 1][j1 - j0 + 1]\f$). */
+    int fra_id; /*!< Frame id returned by `video_reader_get_frame` (-1 means the end of the video). */
+} video_frame_slot_t;
+
+/**
+ *  Asynchronous video reader: a decoder thread reads the frames ahead of the pipeline into a ring of preallocated
+ *  frames. Decoded slots go to the pipeline through the `filled` queue and come back through the `empty` queue.
+ */
+typedef struct {
+    video_reader_t* video; /*!< Synchronous video reader used by the decoder thread. */
+    video_frame_slot_t* slots; /*!< Ring of preallocated frames. */
+    size_t n_slots; /*!< Number of frames in the ring. */
+    spsc_queue_t* filled; /*!< Decoded frames (decoder thread -> pipeline). */
+    spsc_queue_t* empty; /*!< Free frames (pipeline -> decoder thread). */
+    pthread_t thread; /*!< Decoder thread. */
+    int i0, i1, j0, j1; /*!< Frames dimensions. */
+    uint8_t stop; /*!< Boolean, set to 1 to stop the decoder thread (atomic access). */
+    uint8_t eof; /*!< Boolean, 1 when the pipeline has received the end of the video. */
+    double decode_us; /*!< Accumulated decoding time in the decoder thread (in microseconds), safe to read once
+                               `eof` is set. */
+    size_t n_decoded; /*!< Number of decoded frames, safe to read once `eof` is set. */
+} video_reader_async_t;
+
 /**
  *  Pixel formats enumeration.
  */
@@ -53,6 +219,33 @@ enum pixfmt_e { PIXFMT_RGB24 = 0, /*!< 24 bits Red-Green-Blue. */
                 PIXFMT_GRAY /*!< 8 bits grayscale. */
 };
 
+/**
+ *  Policy of the asynchronous video writer when all its frames are waiting to be encoded.
+ */
+enum video_writer_policy_e { VWRT_BLOCK = 0, /*!< Wait for the writer thread (no frame is lost). */
+                             VWRT_DROP /*!< Drop the new frame (the detection is never throttled). */
+};
+
+/**
+ *  Asynchronous part of a video writer: the frames are copied into a ring of preallocated frames and encoded by a
+ *  writer thread. Frames to encode go to the writer thread through the `filled` queue and come back through the
+ *  `empty` queue.
+ */
+typedef struct {
+    video_frame_slot_t* slots; /*!< Ring of preallocated frames (a -1 frame id stops the writer thread). */
+    size_t n_slots; /*!< Number of frames in the ring. */
+    size_t row_size; /*!< Size of a frame row (in bytes). */
+    spsc_queue_t* filled; /*!< Frames to encode (pipeline -> writer thread). */
+    spsc_queue_t* empty; /*!< Free frames (writer thread -> pipeline). */
+    pthread_t thread; /*!< Writer thread. */
+    enum video_writer_policy_e policy; /*!< What to do when there is no free frame. */
+    double encode_us; /*!< Accumulated encoding time in the writer thread (in microseconds), safe to read once the
+                           writer is freed or from the writer thread. */
+    double stall_us; /*!< Accumulated time spent by the pipeline waiting for a free frame (in microseconds). */
+    size_t n_written; /*!< Number of encoded frames (same safety as `encode_us`). */
+    size_t n_dropped; /*!< Number of dropped frames (`VWRT_DROP` policy). */
+} video_writer_async_t;
+
 /**
  *  Video writer structure.
  */
@@ -61,11 +254,16 @@ typedef struct {
     void* metadata; /*!< Internal metadata used by the video encoder. */
     char path[2048]; /*!< Path to the video or images. */
     int win_play; /*!< Boolean: if 0 write into a file, if 1 play in a SDL window. */
+    size_t img_height; /*!< Images height. */
+    size_t img_width; /*!< Images width. */
+    enum pixfmt_e pixfmt; /*!< Pixels format. */
+    video_writer_async_t* async; /*!< Writer thread data (NULL if the frames are encoded by the caller). */
 } video_writer_t;
 
 /**
  * Convert a string into an `video_codec_e` enum value
- * @param str String that can be "FFMPEG-IO" or "VCODECS-IO" (if the code has been linked with vcodecs-io library)
+ * @param str String that can be "FFMPEG-IO" or "VCODECS-IO" (if the code has been linked with the libavcodec libraries,
+ *            see the `MOTION_VCODECS_IO_LINK` CMake option)
  * @return Corresponding enum value.
  */
 enum video_codec_e video_str_to_enum(const char* str);
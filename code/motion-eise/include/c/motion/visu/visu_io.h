@@ -20,28 +20,41 @@
  * @param draw_track_id If 1, draw the track id corresponding to the bounding box.
  * @param win_play Boolean, if 0 write into a file, if 1 play in a SDL window.
  * @param buff_size Number of frames to buffer.
- * @param max_RoIs_size Max number of RoIs to allocate per frame.
+ * @param frame_pool Pool of the frames given to `visu_display` (they are referenced instead of copied). It needs
+ *                   `buff_size` more frames than the ones used by the caller. If NULL, a pool is allocated for the
+ *                   copies.
  * @param Number of skipped frames between two 'visu_display' calls (generally this is 0).
  * @return The allocated data.
  */
 visu_data_t* visu_alloc_init(const char* path, const size_t start, const size_t n_ffmpeg_threads,
                              const size_t img_height, const size_t img_width, const enum pixfmt_e pixfmt,
                              const enum video_codec_e codec_type, const uint8_t draw_track_id,
-                             const int win_play, const size_t buff_size, const size_t max_RoIs_size,
+                             const int win_play, const size_t buff_size, frame_pool_t* frame_pool,
                              const uint8_t skip_fra);
 
 /**
- * Display a frame. If the buffer is not fully filled: display nothing and just copy the current frame to the buffer.
+ * Display a frame. If the buffer is not fully filled: display nothing and just keep the current frame in the buffer.
+ * The frame is referenced if it comes from the pool of the visualization, otherwise it is copied in a frame of the
+ * pool. The caller should not modify a frame while it is shared (see `frame_is_shared`).
  * @param visu A pointer of previously allocated inner visu data.
- * @param img Input grayscale/RGB image (2D array \f$[\texttt{img\_height}][\texttt{img\_width}]\f$).
+ * @param frame Frame that contains `img` (NULL if `img` is not in a frame of the pool).
+ * @param img Input grayscale image (2D array \f$[\texttt{img\_height}][\texttt{img\_width}]\f$).
  * @param RoIs Last RoIs to bufferize.
  * @param n_RoIs Number of connected-components (= number of RoIs) in the 2D array of `labels`.
  * @param tracks A vector of tracks.
  * @param frame_id the current frame id.
  */
-void visu_display(visu_data_t* visu, const uint8_t** img, const RoI_t* RoIs, const size_t n_RoIs,
+void visu_display(visu_data_t* visu, frame_t* frame, const uint8_t** img, const RoI_t* RoIs, const size_t n_RoIs,
                   const vec_track_t tracks, const uint32_t frame_id);
 
+/**
+ * Frame id of the oldest frame in the buffer (the next one to be displayed). The tracks that ended before this frame
+ * are not needed anymore by the visualization (see `tracking_release_RoIs_id`).
+ * @param visu A pointer of previously allocated inner visu data.
+ * @return The oldest frame id, `UINT32_MAX` if the buffer is empty.
+ */
+uint32_t visu_get_oldest_frame_id(const visu_data_t* visu);
+
 /**
  * Display all the remaining frames (= flush the the buffer).
  * @param visu A pointer of previously allocated inner visu data.
@@ -8,6 +8,7 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "motion/frame_pool.h"
 #include "motion/video/video_struct.h"
 #include "motion/image/image_struct.h"
 #include "motion/features/features_struct.h"
@@ -20,8 +21,11 @@ typedef struct {
     size_t img_height; /*!< Images height. */
     size_t img_width; /*!< Images width. */
     img_data_t *img_data; /*!< Proxy data to draw bounding boxes. */
-    uint8_t ***I; /*!< Array of images (= buffer). */
+    frame_pool_t* frame_pool; /*!< Pool of the frames (shared with the pipeline or owned by the visualization). */
+    uint8_t own_pool; /*!< Boolean, 1 if `frame_pool` has been allocated by the visualization. */
+    frame_t **frames; /*!< Array of referenced frames (= buffer). */
     RoI_t **RoIs; /*!< Array of RoIs (= buffer). */
+    size_t *RoIs_size; /*!< Allocated number of RoIs in each element of `RoIs` (they grow with the number of RoIs). */
     uint32_t *frame_ids; /*!< RoIs corresponding frame ids. */
     size_t buff_size; /*!< Size of the bufferization. */
     size_t buff_id_read; /*!< Index of the current buffer to read. */
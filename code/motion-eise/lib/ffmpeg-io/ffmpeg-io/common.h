@@ -66,6 +66,7 @@ typedef struct ffmpeg_descriptor {
 } ffmpeg_descriptor;
 typedef struct ffmpeg_handle {
   FILE* pipe;
+  int eof; // the pipe is accessed through its file descriptor (no stdio buffering), `feof` can't be used
   ffmpeg_descriptor input, output;
   ffmpeg_error error;
 } ffmpeg_handle;
@@ -82,6 +83,8 @@ typedef struct ffmpeg_options {
   unsigned threads_output;
   unsigned start_number;
   unsigned vframes;
+  unsigned frame_step; // reader: keep one frame out of `frame_step` in ffmpeg (0 or 1: all the frames are kept)
+  unsigned pipe_size; // pipe buffer size in bytes (0: large enough for a whole frame, within the system limit)
   unsigned infinite_buffer:1;
   unsigned debug:1;
   unsigned force_input_framerate:1;
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Row i is at rows[i] when rows != NULL, at base + i * pitch otherwise. Contiguous rows are merged in a single
+// iovec, a whole frame is then transferred with a single readv/writev syscall (unless the pipe is too small).
+
+// Enlarge the pipe buffer to `size` bytes (or to the system limit), returns the new size or 0 if unsupported
+size_t ffmpeg_pipe_resize(FILE* pipe, size_t size);
+// Returns the number of bytes read, sets `*eof` if the write end has been closed
+size_t ffmpeg_pipe_read_rows(FILE* pipe, uint8_t* const* rows, uint8_t* base, size_t pitch, size_t n_rows,
+                             size_t row_size, int* eof);
+// Returns the number of bytes written
+size_t ffmpeg_pipe_write_rows(FILE* pipe, const uint8_t* const* rows, const uint8_t* base, size_t pitch,
+                              size_t n_rows, size_t row_size);
@@ -0,0 +1,97 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "pipe.h"
+
+#define FFMPEG_PIPE_IOV_CHUNK 64
+
+size_t ffmpeg_pipe_resize(FILE* pipe, size_t size) {
+#ifdef F_SETPIPE_SZ
+  int fd = fileno(pipe);
+  if (size > INT_MAX) size = INT_MAX;
+  if (fcntl(fd, F_SETPIPE_SZ, (int)size) < 0) {
+    // unprivileged processes are limited by /proc/sys/fs/pipe-max-size
+    long max = 0;
+    FILE* f = fopen("/proc/sys/fs/pipe-max-size", "r");
+    if (f != NULL) {
+      if (fscanf(f, "%ld", &max) != 1) max = 0;
+      fclose(f);
+    }
+    if (max <= 0 || fcntl(fd, F_SETPIPE_SZ, (int)max) < 0) return 0;
+  }
+  int cur = fcntl(fd, F_GETPIPE_SZ);
+  return cur < 0 ? 0 : (size_t)cur;
+#else
+  (void)pipe;
+  (void)size;
+  return 0;
+#endif
+}
+
+// Transfers all the iovecs, deals with partial transfers and interruptions
+static size_t transfer(int fd, int writing, struct iovec* iov, int n, int* eof) {
+  size_t total = 0;
+  while (n > 0) {
+    ssize_t r = writing ? writev(fd, iov, n) : readv(fd, iov, n);
+    if (r < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    if (r == 0) {
+      if (eof != NULL) *eof = 1;
+      break;
+    }
+    total += (size_t)r;
+    while (n > 0 && (size_t)r >= iov->iov_len) {
+      r -= iov->iov_len;
+      ++iov;
+      --n;
+    }
+    if (n > 0) {
+      iov->iov_base = (uint8_t*)iov->iov_base + r;
+      iov->iov_len -= r;
+    }
+  }
+  return total;
+}
+
+static size_t transfer_rows(FILE* pipe, int writing, uint8_t* const* rows, uint8_t* base, size_t pitch,
+                            size_t n_rows, size_t row_size, int* eof) {
+  int fd = fileno(pipe);
+  struct iovec iov[FFMPEG_PIPE_IOV_CHUNK];
+  int n = 0;
+  size_t total = 0, expected = 0;
+  for (size_t i = 0; i < n_rows; i++) {
+    uint8_t* row = rows != NULL ? rows[i] : base + i * pitch;
+    if (n > 0 && (uint8_t*)iov[n-1].iov_base + iov[n-1].iov_len == row) {
+      iov[n-1].iov_len += row_size;
+    } else {
+      if (n == FFMPEG_PIPE_IOV_CHUNK) {
+        total += transfer(fd, writing, iov, n, eof);
+        if (total != expected) return total;
+        n = 0;
+      }
+      iov[n].iov_base = row;
+      iov[n].iov_len = row_size;
+      n++;
+    }
+    expected += row_size;
+  }
+  if (n > 0) total += transfer(fd, writing, iov, n, eof);
+  return total;
+}
+
+size_t ffmpeg_pipe_read_rows(FILE* pipe, uint8_t* const* rows, uint8_t* base, size_t pitch, size_t n_rows,
+                             size_t row_size, int* eof) {
+  return transfer_rows(pipe, 0, rows, base, pitch, n_rows, row_size, eof);
+}
+
+size_t ffmpeg_pipe_write_rows(FILE* pipe, const uint8_t* const* rows, const uint8_t* base, size_t pitch,
+                              size_t n_rows, size_t row_size) {
+  // the buffers are not modified by writev
+  return transfer_rows(pipe, 1, (uint8_t* const*)rows, (uint8_t*)base, pitch, n_rows, row_size, NULL);
+}
@@ -4,6 +4,7 @@
 #include "constants.h"
 #include "cmd.h"
 #include "formatter.h"
+#include "pipe.h"
 #include "ffmpeg-io/player.h"
 
 
@@ -55,10 +56,14 @@ int ffmpeg_start_player(ffmpeg_handle* h, const ffmpeg_options* opts) {
   if (opts->debug) printf("cmd: %s\n", cmd.str);
 
   h->pipe = popen(cmd.str, "w");
+  h->eof = 0;
   int success = 1;
   if (!h->pipe) {
     h->error = ffmpeg_pipe_error;
     success = 0;
+  } else {
+    size_t frame_size = (size_t)width * height * ffmpeg_pixel_size(pixfmt);
+    ffmpeg_pipe_resize(h->pipe, opts->pipe_size ? opts->pipe_size : frame_size);
   }
   ffmpeg_formatter_fini(&cmd);
   return success;
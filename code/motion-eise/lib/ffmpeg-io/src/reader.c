@@ -5,6 +5,7 @@
 #include "constants.h"
 #include "cmd.h"
 #include "formatter.h"
+#include "pipe.h"
 #include "ffmpeg-io/reader.h"
 
 int ffmpeg_start_reader_cmd_raw(ffmpeg_handle* h, const char* command) {
@@ -13,6 +14,7 @@ int ffmpeg_start_reader_cmd_raw(ffmpeg_handle* h, const char* command) {
   ffmpeg_formatter_append(&cmd, "exec %s </dev/null", command);
 
   h->pipe = popen(cmd.str, "r");
+  h->eof = 0;
   int success = 1;
   if (!h->pipe) {
     h->error = ffmpeg_pipe_error;
@@ -103,6 +105,11 @@ int ffmpeg_start_reader(ffmpeg_handle* h, const char* filename, const ffmpeg_opt
   ffmpeg_formatter_append(&cmd, " -i '%s'", filename);
 
   const char* filter_prefix = " -filter:v ";
+  if (opts->frame_step > 1) {
+    // the dropped frames are neither converted nor sent through the pipe
+    ffmpeg_formatter_append(&cmd, "%s'select=not(mod(n\\,%u))'", filter_prefix, opts->frame_step);
+    filter_prefix = ",";
+  }
   if ((iframerate.num != oframerate.num || iframerate.den != oframerate.den) && oframerate.num > 0 && oframerate.den > 0) {
     ffmpeg_formatter_append(&cmd, "%sfps=fps=%d/%d", filter_prefix, oframerate.num, oframerate.den);
     filter_prefix = ",";
@@ -135,6 +142,10 @@ int ffmpeg_start_reader(ffmpeg_handle* h, const char* filename, const ffmpeg_opt
     if (opts->vframes) {
       ffmpeg_formatter_append(&cmd, " -frames:v %u", opts->vframes);
     }
+    if (opts->frame_step > 1) {
+      // no duplicated frames to keep a constant framerate
+      ffmpeg_formatter_append(&cmd, " -vsync 0");
+    }
     if (opts->extra_output_options != NULL) {
       ffmpeg_formatter_append(&cmd, " %s", opts->extra_output_options);
     }
@@ -144,10 +155,15 @@ int ffmpeg_start_reader(ffmpeg_handle* h, const char* filename, const ffmpeg_opt
   if (opts->debug) printf("cmd: %s\n", cmd.str);
 
   h->pipe = popen(cmd.str, "r");
+  h->eof = 0;
   int success = 1;
   if (!h->pipe) {
     h->error = ffmpeg_pipe_error;
     success = 0;
+  } else {
+    // a whole frame fits in the pipe: ffmpeg is not blocked in the middle of a frame
+    size_t frame_size = (size_t)width * height * ffmpeg_pixel_size(h->output.pixfmt);
+    ffmpeg_pipe_resize(h->pipe, opts->pipe_size ? opts->pipe_size : frame_size);
   }
   ffmpeg_formatter_fini(&cmd);
   return success;
@@ -160,13 +176,13 @@ int ffmpeg_read_raw(ffmpeg_handle* h, size_t size, size_t nmemb, void* out) {
     h->error = ffmpeg_closed_pipe;
     return 0;
   }
-  if (feof(pipe)) {
+  if (h->eof) {
     h->error = ffmpeg_eof_error;
     return 0;
   }
 
-  size_t n = fread(out, size, nmemb, pipe);
-  if (n == 0 && feof(pipe)) {
+  size_t n = ffmpeg_pipe_read_rows(pipe, NULL, (uint8_t*)out, 0, 1, size * nmemb, &h->eof) / (size ? size : 1);
+  if (n == 0 && h->eof) {
     h->error = ffmpeg_eof_error;
   } else if (n < nmemb) {
     h->error = ffmpeg_partial_read;
@@ -185,7 +201,7 @@ int ffmpeg_read1d(ffmpeg_handle* h, uint8_t* data, size_t pitch) {
     h->error = ffmpeg_closed_pipe;
     return 0;
   }
-  if (feof(pipe)) {
+  if (h->eof) {
     h->error = ffmpeg_eof_error;
     return 0;
   }
@@ -202,17 +218,15 @@ int ffmpeg_read1d(ffmpeg_handle* h, uint8_t* data, size_t pitch) {
     return 0;
   }
 
-  for (size_t i = 0; i < height; i++) {
-    size_t read = fread(data, elsize, width, pipe);
-    if (i == 0 && read == 0 && feof(pipe)) {
-      h->error = ffmpeg_eof_error;
-      return 0;
-    }
-    if (read < width) {
-      h->error = ffmpeg_partial_read;
-      return 0;
-    }
-    data += pitch;
+  // whole frame in one go, straight into the destination rows
+  size_t read = ffmpeg_pipe_read_rows(pipe, NULL, data, pitch, height, elsize * width, &h->eof);
+  if (read == 0 && h->eof) {
+    h->error = ffmpeg_eof_error;
+    return 0;
+  }
+  if (read < height * elsize * width) {
+    h->error = ffmpeg_partial_read;
+    return 0;
   }
   return 1;
 }
@@ -228,7 +242,7 @@ int ffmpeg_read2d(ffmpeg_handle* h, uint8_t** data) {
     h->error = ffmpeg_closed_pipe;
     return 0;
   }
-  if (feof(pipe)) {
+  if (h->eof) {
     h->error = ffmpeg_eof_error;
     return 0;
   }
@@ -245,16 +259,15 @@ int ffmpeg_read2d(ffmpeg_handle* h, uint8_t** data) {
     return 0;
   }
 
-  for (size_t i = 0; i < height; i++) {
-    size_t read = fread(data[i], elsize, width, pipe);
-    if (i == 0 && read == 0 && feof(pipe)) {
-      h->error = ffmpeg_eof_error;
-      return 0;
-    }
-    if (read < width) {
-      h->error = ffmpeg_partial_read;
-      return 0;
-    }
+  // whole frame in one go, straight into the destination rows
+  size_t read = ffmpeg_pipe_read_rows(pipe, data, NULL, 0, height, elsize * width, &h->eof);
+  if (read == 0 && h->eof) {
+    h->error = ffmpeg_eof_error;
+    return 0;
+  }
+  if (read < height * elsize * width) {
+    h->error = ffmpeg_partial_read;
+    return 0;
   }
   return 1;
 }
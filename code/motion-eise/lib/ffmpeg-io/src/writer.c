@@ -4,6 +4,7 @@
 #include "constants.h"
 #include "cmd.h"
 #include "formatter.h"
+#include "pipe.h"
 #include "ffmpeg-io/writer.h"
 
 
@@ -136,10 +137,14 @@ int ffmpeg_start_writer(ffmpeg_handle* h, const char* filename, const ffmpeg_opt
   if (opts->debug) printf("cmd: %s\n", cmd.str);
 
   h->pipe = popen(cmd.str, "w");
+  h->eof = 0;
   int success = 1;
   if (!h->pipe) {
     h->error = ffmpeg_pipe_error;
     success = 0;
+  } else {
+    size_t frame_size = (size_t)h->input.width * h->input.height * ffmpeg_pixel_size(h->input.pixfmt);
+    ffmpeg_pipe_resize(h->pipe, opts->pipe_size ? opts->pipe_size : frame_size);
   }
   ffmpeg_formatter_fini(&cmd);
   return success;
@@ -152,12 +157,7 @@ int ffmpeg_write_raw(ffmpeg_handle* h, size_t size, size_t nmemb, const void* in
     h->error = ffmpeg_closed_pipe;
     return 0;
   }
-  if (feof(pipe)) {
-    h->error = ffmpeg_eof_error;
-    return 0;
-  }
-
-  size_t n = fwrite(in, size, nmemb, pipe);
+  size_t n = ffmpeg_pipe_write_rows(pipe, NULL, (const uint8_t*)in, 0, 1, size * nmemb) / (size ? size : 1);
 
   return n;
 }
@@ -185,9 +185,9 @@ int ffmpeg_write1d(ffmpeg_handle* h, const uint8_t* data, size_t pitch) {
     return 0;
   }
 
-  for (size_t i = 0; i < height; i++) {
-    fwrite(data, elsize, width, pipe);
-    data += pitch;
+  if (ffmpeg_pipe_write_rows(pipe, NULL, data, pitch, height, elsize * width) < height * elsize * width) {
+    h->error = ffmpeg_pipe_error;
+    return 0;
   }
   return 1;
 }
@@ -216,8 +216,10 @@ int ffmpeg_write2d(ffmpeg_handle* h, uint8_t** data) {
     return 0;
   }
 
-  for (size_t i = 0; i < height; i++) {
-    fwrite(data[i], elsize, width, pipe);
+  if (ffmpeg_pipe_write_rows(pipe, (const uint8_t* const*)data, NULL, 0, height, elsize * width) <
+      height * elsize * width) {
+    h->error = ffmpeg_pipe_error;
+    return 0;
   }
   return 1;
 }
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <nrc2.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "motion/macros.h"
+#include "motion/video/video_io.h"
+#include "motion/tracking/tracking_struct.h"
+#include "motion/tracking/tracking_io.h"
+#include "motion/batch.h"
+
+#define BATCH_JOURNAL_NAME "journal.txt"
+#define BATCH_JOURNAL_FAILED "failed"
+
+static int _batch_cmp_str(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static void _batch_add_path(batch_t* batch, size_t* cap, const char* path) {
+    if (batch->n_files == *cap) {
+        *cap = *cap ? 2 * *cap : 64;
+        batch->paths = (char**)realloc(batch->paths, *cap * sizeof(char*));
+    }
+    batch->paths[batch->n_files++] = strdup(path);
+}
+
+static void _batch_list_dir(batch_t* batch, const char* dir_path) {
+    DIR* dir = opendir(dir_path);
+    if (!dir) {
+        fprintf(stderr, "(EE) can't open the directory %s\n", dir_path);
+        exit(1);
+    }
+    size_t cap = 0;
+    char path[2048];
+    struct dirent* entry;
+    while ((entry = readdir(dir))) {
+        if (entry->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir_path, entry->d_name);
+        struct stat st;
+        if (!stat(path, &st) && S_ISREG(st.st_mode))
+            _batch_add_path(batch, &cap, path);
+    }
+    closedir(dir);
+    // `readdir` order depends on the file system, the batch is always processed in the same order
+    qsort(batch->paths, batch->n_files, sizeof(char*), _batch_cmp_str);
+}
+
+static void _batch_list_file(batch_t* batch, const char* list_path) {
+    FILE* f = fopen(list_path, "r");
+    if (!f) {
+        fprintf(stderr, "(EE) can't open the list file %s\n", list_path);
+        exit(1);
+    }
+    size_t cap = 0;
+    char line[2048];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] && line[0] != '#')
+            _batch_add_path(batch, &cap, line);
+    }
+    fclose(f);
+}
+
+// the results file of a video is named after the video file, two videos can't have the same name
+static void _batch_set_names(batch_t* batch) {
+    batch->names = (char**)malloc(batch->n_files * sizeof(char*));
+    for (size_t f = 0; f < batch->n_files; f++) {
+        const char* slash = strrchr(batch->paths[f], '/');
+        const char* name = slash ? slash + 1 : batch->paths[f];
+        batch->names[f] = (char*)malloc(strlen(name) + 5);
+        sprintf(batch->names[f], "%s.txt", name);
+    }
+    char** sorted = (char**)malloc(batch->n_files * sizeof(char*));
+    memcpy(sorted, batch->names, batch->n_files * sizeof(char*));
+    qsort(sorted, batch->n_files, sizeof(char*), _batch_cmp_str);
+    for (size_t f = 1; f < batch->n_files; f++)
+        if (!strcmp(sorted[f - 1], sorted[f])) {
+            fprintf(stderr, "(EE) two videos of the batch have the same results file '%s'\n", sorted[f]);
+            exit(1);
+        }
+    free(sorted);
+}
+
+// journal line: "<results file name>\t<number of frames>\t<number of tracks>\t<video path>", the number of frames is
+// "failed" when the video can't be opened (there is no results file, the video is tried again on resume)
+static void _batch_load_journal(batch_t* batch) {
+    char path[2048 + 16];
+    snprintf(path, sizeof(path), "%s/%s", batch->out_path, BATCH_JOURNAL_NAME);
+    FILE* f = fopen(path, "r");
+    if (f) {
+        char line[4096 + 64];
+        while (fgets(line, sizeof(line), f)) {
+            char* tab = strchr(line, '\t');
+            if (!tab)
+                continue; // a line can be truncated if the batch has been killed during the write
+            *tab = '\0';
+            for (size_t v = 0; v < batch->n_files; v++)
+                if (!batch->done[v] && !strcmp(batch->names[v], line)) {
+                    // the results file is checked too: the journal entry is useless without it
+                    char res_path[2048 + 8];
+                    snprintf(res_path, sizeof(res_path), "%s/%s", batch->out_path, batch->names[v]);
+                    batch->done[v] = !access(res_path, F_OK);
+                    break;
+                }
+        }
+        fclose(f);
+    }
+    batch->journal = fopen(path, "a");
+    if (!batch->journal) {
+        fprintf(stderr, "(EE) can't open the journal %s\n", path);
+        exit(1);
+    }
+}
+
+batch_t* batch_alloc_init(const char* in_path, const char* out_path, const motion_params_t* params,
+                          const enum video_codec_e codec_type, const size_t n_threads) {
+    if (!n_threads) {
+        fprintf(stderr, "(EE) 'batch_alloc_init' needs at least one thread\n");
+        exit(1);
+    }
+    batch_t* batch = (batch_t*)calloc(1, sizeof(batch_t));
+    if (!batch) {
+        fprintf(stderr, "(EE) 'batch_alloc_init' failed\n");
+        exit(1);
+    }
+    struct stat st;
+    if (stat(in_path, &st)) {
+        fprintf(stderr, "(EE) can't find %s\n", in_path);
+        exit(1);
+    }
+    // the results files and the journal would be listed as videos (same inode: symbolic links and "./" included)
+    struct stat out_st;
+    if (S_ISDIR(st.st_mode) && !stat(out_path, &out_st) && out_st.st_dev == st.st_dev && out_st.st_ino == st.st_ino) {
+        fprintf(stderr, "(EE) the output directory can't be the directory of videos (%s)\n", out_path);
+        exit(1);
+    }
+    if (S_ISDIR(st.st_mode))
+        _batch_list_dir(batch, in_path);
+    else
+        _batch_list_file(batch, in_path);
+    if (!batch->n_files) {
+        fprintf(stderr, "(EE) there is no video in %s\n", in_path);
+        exit(1);
+    }
+    _batch_set_names(batch);
+
+    if (mkdir(out_path, 0755) && errno != EEXIST) {
+        fprintf(stderr, "(EE) can't create the directory %s\n", out_path);
+        exit(1);
+    }
+    batch->out_path = out_path;
+    batch->done = (uint8_t*)calloc(batch->n_files, sizeof(uint8_t));
+    _batch_load_journal(batch);
+    batch->n_todo = 0;
+    for (size_t f = 0; f < batch->n_files; f++)
+        batch->n_todo += !batch->done[f];
+
+    batch->params = *params;
+    batch->codec_type = codec_type;
+    // the videos are independent: as many workers as possible, the threads left go inside the videos
+    batch->n_workers = batch->n_todo < n_threads ? (batch->n_todo ? batch->n_todo : 1) : n_threads;
+    batch->n_inner_threads = n_threads / batch->n_workers;
+    batch->workers = (batch_worker_t*)calloc(batch->n_workers, sizeof(batch_worker_t));
+    for (size_t w = 0; w < batch->n_workers; w++) {
+        batch->workers[w].id = w;
+        batch->workers[w].batch = batch;
+    }
+    pthread_mutex_init(&batch->mutex, NULL);
+    return batch;
+}
+
+// index of the next video to process, -1 when there is no more video
+static long _batch_pick(batch_t* batch) {
+    long f = -1;
+    pthread_mutex_lock(&batch->mutex);
+    while (batch->next < batch->n_files && batch->done[batch->next])
+        batch->next++;
+    if (batch->next < batch->n_files)
+        f = (long)batch->next++;
+    pthread_mutex_unlock(&batch->mutex);
+    return f;
+}
+
+// the buffers of the previous video are kept when the frames size is the same
+static void _batch_worker_prepare(batch_worker_t* worker, const int i0, const int i1, const int j0, const int j1) {
+    if (worker->mp && worker->i0 == i0 && worker->i1 == i1 && worker->j0 == j0 && worker->j1 == j1) {
+        motion_pipeline_reset(worker->mp);
+        return;
+    }
+    if (worker->mp) {
+        motion_pipeline_free(worker->mp);
+        free_ui8matrix(worker->img, worker->i0, worker->i1, worker->j0, worker->j1);
+    }
+    worker->i0 = i0;
+    worker->i1 = i1;
+    worker->j0 = j0;
+    worker->j1 = j1;
+    worker->img = ui8matrix(i0, i1, j0, j1);
+    motion_params_t params = worker->batch->params;
+    params.width = (j1 - j0) + 1;
+    params.height = (i1 - i0) + 1;
+    worker->mp = motion_pipeline_create(&params);
+    if (!worker->mp)
+        exit(1);
+    worker->n_allocs++;
+}
+
+static void _batch_process(batch_worker_t* worker, const size_t f) {
+    batch_t* batch = worker->batch;
+    TIME_POINT(file_b);
+    // a bad input must not stop the batch: it is journaled as failed and the other videos are processed
+    if (!video_reader_probe(batch->paths[f], batch->codec_type, 0, 0)) {
+        pthread_mutex_lock(&batch->mutex);
+        fprintf(batch->journal, "%s\t%s\t0\t%s\n", batch->names[f], BATCH_JOURNAL_FAILED, batch->paths[f]);
+        fflush(batch->journal);
+        fsync(fileno(batch->journal));
+        batch->n_finished++;
+        batch->n_failed++;
+        fprintf(stderr, "(WW) [%lu/%lu] %s: can't open the video, it is skipped\n", (unsigned long)batch->n_finished,
+                (unsigned long)batch->n_todo, batch->paths[f]);
+        pthread_mutex_unlock(&batch->mutex);
+        return;
+    }
+    int i0, i1, j0, j1;
+    video_reader_t* video = video_reader_alloc_init(batch->paths[f], 0, 0, 0, VBUF_NONE, batch->n_inner_threads,
+                                                    batch->codec_type, VCDC_HWACCEL_NONE, 0, 0, NULL, &i0, &i1, &j0,
+                                                    &j1);
+    _batch_worker_prepare(worker, i0, i1, j0, j1);
+    size_t n_frames = 0;
+    const uint8_t** view;
+    int cur_fra;
+    while ((cur_fra = video_reader_get_frame_view(video, worker->img, &view)) != -1) {
+        motion_pipeline_push_view(worker->mp, view, cur_fra);
+        n_frames++;
+    }
+    video_reader_free(video);
+
+    // the results are written under a temporary name: a results file is always complete
+    char path[2048 + 8], tmp_path[2048 + 16];
+    snprintf(path, sizeof(path), "%s/%s", batch->out_path, batch->names[f]);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* res = fopen(tmp_path, "w");
+    if (!res) {
+        fprintf(stderr, "(EE) can't create the results file %s\n", tmp_path);
+        exit(1);
+    }
+    const track_t* tracks;
+    motion_pipeline_get_tracks(worker->mp, &tracks);
+    const size_t n_tracks = tracking_count_objects((const vec_track_t)tracks);
+    fprintf(res, "# video: %s\n", batch->paths[f]);
+    tracking_tracks_write(res, (const vec_track_t)tracks);
+    if (fclose(res) || rename(tmp_path, path)) {
+        fprintf(stderr, "(EE) can't write the results file %s\n", path);
+        exit(1);
+    }
+    TIME_POINT(file_e);
+    const double file_us = TIME_ELAPSED2_US(file_b, file_e);
+    worker->busy_us += file_us;
+    worker->n_files++;
+    worker->n_frames += n_frames;
+
+    // the video is journaled once its results file exists, the journal is synced to survive a crash
+    pthread_mutex_lock(&batch->mutex);
+    fprintf(batch->journal, "%s\t%lu\t%lu\t%s\n", batch->names[f], (unsigned long)n_frames, (unsigned long)n_tracks,
+            batch->paths[f]);
+    fflush(batch->journal);
+    fsync(fileno(batch->journal));
+    batch->n_finished++;
+    fprintf(stderr, "(II) [%lu/%lu] %s: %lu frame(s), %lu track(s) (%.3f s)\n", (unsigned long)batch->n_finished,
+            (unsigned long)batch->n_todo, batch->paths[f], (unsigned long)n_frames, (unsigned long)n_tracks,
+            file_us * 1e-6);
+    pthread_mutex_unlock(&batch->mutex);
+}
+
+static void* _batch_worker_thread(void* arg) {
+    batch_worker_t* worker = (batch_worker_t*)arg;
+#ifdef _OPENMP
+    omp_set_num_threads((int)worker->batch->n_inner_threads);
+#endif
+    long f;
+    while ((f = _batch_pick(worker->batch)) != -1)
+        _batch_process(worker, (size_t)f);
+    return NULL;
+}
+
+void batch_run(batch_t* batch) {
+    TIME_POINT(run_b);
+    for (size_t w = 0; w < batch->n_workers; w++)
+        if (pthread_create(&batch->workers[w].thread, NULL, _batch_worker_thread, &batch->workers[w])) {
+            fprintf(stderr, "(EE) 'pthread_create' failed for the worker %lu\n", (unsigned long)w);
+            exit(1);
+        }
+    for (size_t w = 0; w < batch->n_workers; w++)
+        pthread_join(batch->workers[w].thread, NULL);
+    TIME_POINT(run_e);
+    batch->run_us = TIME_ELAPSED2_US(run_b, run_e);
+}
+
+void batch_stats_print(FILE* f, const batch_t* batch) {
+    fprintf(f, "# Workers statistics:\n");
+    fprintf(f, "# -----||--------|--------|--------|--------|--------\n");
+    fprintf(f, "#   Id ||  Files | Frames |    FPS | Allocs |   Busy\n");
+    fprintf(f, "# -----||--------|--------|--------|--------|--------\n");
+    for (size_t w = 0; w < batch->n_workers; w++) {
+        const batch_worker_t* worker = &batch->workers[w];
+        fprintf(f, "# %4lu || %6lu | %6lu | %6.1f | %6lu | %5.1f%%\n", (unsigned long)worker->id,
+                (unsigned long)worker->n_files, (unsigned long)worker->n_frames,
+                worker->busy_us > 0. ? worker->n_frames / (worker->busy_us * 1e-6) : 0.,
+                (unsigned long)worker->n_allocs, batch->run_us > 0. ? 100. * worker->busy_us / batch->run_us : 0.);
+    }
+}
+
+void batch_free(batch_t* batch) {
+    for (size_t w = 0; w < batch->n_workers; w++) {
+        batch_worker_t* worker = &batch->workers[w];
+        if (worker->mp) {
+            motion_pipeline_free(worker->mp);
+            free_ui8matrix(worker->img, worker->i0, worker->i1, worker->j0, worker->j1);
+        }
+    }
+    for (size_t f = 0; f < batch->n_files; f++) {
+        free(batch->paths[f]);
+        free(batch->names[f]);
+    }
+    fclose(batch->journal);
+    pthread_mutex_destroy(&batch->mutex);
+    free(batch->paths);
+    free(batch->names);
+    free(batch->done);
+    free(batch->workers);
+    free(batch);
+}
@@ -163,6 +163,69 @@ void features_extract(const uint32_t** labels, const int i0, const int i1, const
 }
 
 
+void features_refine_upscaled(const uint8_t** img, const int i0, const int i1, const int j0, const int j1,
+                              const uint32_t** labels, const uint8_t** M, const uint8_t** V, RoI_t* RoIs,
+                              const size_t n_RoIs, const int factor) {
+    #pragma omp parallel for schedule(dynamic, 16)
+    for (size_t r = 0; r < n_RoIs; r++) {
+        if (!RoIs[r].id)
+            continue;
+        const uint32_t id = RoIs[r].id;
+        // bounding box in full resolution (the downscaled image starts at the same (i0, j0) indexes)
+        const int y0 = i0 + ((int)RoIs[r].ymin - i0) * factor;
+        const int y1 = MIN(i0 + ((int)RoIs[r].ymax - i0 + 1) * factor - 1, i1);
+        const int x0 = j0 + ((int)RoIs[r].xmin - j0) * factor;
+        const int x1 = MIN(j0 + ((int)RoIs[r].xmax - j0 + 1) * factor - 1, j1);
+
+        uint64_t S = 0, Sx = 0, Sy = 0;
+        int xmin = x1, xmax = x0, ymin = y1, ymax = y0;
+        for (int i = y0; i <= y1; i++) {
+            const int si = i0 + (i - i0) / factor;
+            const uint32_t* L = labels[si];
+            const uint8_t* Mi = M[si];
+            const uint8_t* Vi = V[si];
+            const uint8_t* Ii = img[i];
+            uint32_t n = 0;
+            // visit the downscaled pixels, then the `factor` full resolution pixels of the labeled ones
+            for (int sj = (int)RoIs[r].xmin; sj <= (int)RoIs[r].xmax; sj++) {
+                if (L[sj] != id)
+                    continue;
+                const int m = Mi[sj], v = Vi[sj];
+                const int jb = j0 + (sj - j0) * factor, je = MIN(jb + factor - 1, x1);
+                for (int j = jb; j <= je; j++) {
+                    const int d = (int)Ii[j] - m;
+                    if ((d < 0 ? -d : d) < v)
+                        continue;
+                    n++;
+                    Sx += j;
+                    if (j < xmin) xmin = j;
+                    if (j > xmax) xmax = j;
+                }
+            }
+            if (n) {
+                S += n;
+                Sy += (uint64_t)i * n;
+                if (i < ymin) ymin = i;
+                ymax = i;
+            }
+        }
+
+        if (S) {
+            RoIs[r].S = (uint32_t)S;
+            RoIs[r].x = (float)((double)Sx / S);
+            RoIs[r].y = (float)((double)Sy / S);
+            RoIs[r].xmin = xmin;
+            RoIs[r].xmax = xmax;
+            RoIs[r].ymin = ymin;
+            RoIs[r].ymax = ymax;
+        } else {
+            // no full resolution pixel is moving (the RoI comes from the averaging or from the morphology)
+            RoIs[r].id = 0;
+            RoIs[r].S = 0;
+        }
+    }
+}
+
 uint32_t features_filter_surface(const uint32_t** in_labels, uint32_t** out_labels, const int i0, const int i1,
                                  const int j0, const int j1, RoI_t* RoIs, const size_t n_RoIs, const uint32_t S_min,
                                  const uint32_t S_max) {
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <nrc2.h>
+
+#include "motion/frame_pool.h"
+
+frame_pool_t* frame_pool_alloc(const size_t n_frames, const int i0, const int i1, const int j0, const int j1) {
+    frame_pool_t* pool = (frame_pool_t*)malloc(sizeof(frame_pool_t));
+    if (!pool) {
+        fprintf(stderr, "(EE) 'frame_pool_alloc' failed\n");
+        exit(1);
+    }
+    pool->n_frames = n_frames;
+    pool->i0 = i0;
+    pool->i1 = i1;
+    pool->j0 = j0;
+    pool->j1 = j1;
+    pool->frames = (frame_t*)malloc(n_frames * sizeof(frame_t));
+    pool->free = (frame_t**)malloc(n_frames * sizeof(frame_t*));
+    for (size_t f = 0; f < n_frames; f++) {
+        pool->frames[f].img = ui8matrix(i0, i1, j0, j1);
+        pool->frames[f].refs = 0;
+        pool->frames[f].pool = pool;
+        pool->free[f] = &pool->frames[n_frames - 1 - f];
+    }
+    pool->n_free = n_frames;
+    pthread_mutex_init(&pool->mutex, NULL);
+    return pool;
+}
+
+frame_t* frame_pool_acquire(frame_pool_t* pool) {
+    pthread_mutex_lock(&pool->mutex);
+    if (!pool->n_free) {
+        fprintf(stderr, "(EE) all the %lu frames of the pool are referenced\n", (unsigned long)pool->n_frames);
+        exit(1);
+    }
+    frame_t* frame = pool->free[--pool->n_free];
+    pthread_mutex_unlock(&pool->mutex);
+    __atomic_store_n(&frame->refs, 1, __ATOMIC_RELAXED);
+    return frame;
+}
+
+void frame_retain(frame_t* frame) {
+    __atomic_add_fetch(&frame->refs, 1, __ATOMIC_RELAXED);
+}
+
+void frame_release(frame_t* frame) {
+    // the last reference publishes all the previous writes in the frame before it is reused
+    if (__atomic_sub_fetch(&frame->refs, 1, __ATOMIC_ACQ_REL))
+        return;
+    frame_pool_t* pool = frame->pool;
+    pthread_mutex_lock(&pool->mutex);
+    pool->free[pool->n_free++] = frame;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+int frame_is_shared(const frame_t* frame) {
+    return __atomic_load_n(&frame->refs, __ATOMIC_ACQUIRE) > 1;
+}
+
+void frame_pool_free(frame_pool_t* pool) {
+    if (pool->n_free != pool->n_frames)
+        fprintf(stderr, "(WW) %lu frame(s) of the pool are still referenced\n",
+                (unsigned long)(pool->n_frames - pool->n_free));
+    for (size_t f = 0; f < pool->n_frames; f++)
+        free_ui8matrix(pool->frames[f].img, pool->i0, pool->i1, pool->j0, pool->j1);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->frames);
+    free(pool->free);
+    free(pool);
+}
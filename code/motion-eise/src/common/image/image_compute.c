@@ -11,6 +11,9 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 #endif
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
 #include <ffmpeg-io/reader.h>
 #include <ffmpeg-io/writer.h>
 #include <nrc2.h>
@@ -23,6 +26,16 @@
 
 #define DELTA_BB 5 // extra pixel size for bounding boxes
 
+/**
+ *  State of a color image between two `image_color_draw_BBs` calls: the gray pixels already expanded in the color
+ *  image and the rows where something has been drawn over them.
+ */
+typedef struct {
+    uint8_t** gray; /**< Copy of the last gray image. */
+    uint8_t* dirty; /**< Rows where BBs have been drawn (they have to be expanded again). */
+    int valid; /**< Boolean, 0 if the whole color image has to be expanded again. */
+} _image_color_cache_t;
+
 rgb8_t image_get_color(enum color_e color) {
     rgb8_t gray;
     gray.g = 125;
@@ -87,6 +100,29 @@ rgb8_t image_get_color(enum color_e color) {
     return red;
 }
 
+// fill `n` consecutive pixels with the same color, by 16 pixels (= 48 bytes = 3 vectors of the repeated color)
+static void _image_fill_span(rgb8_t* row, const int n, const rgb8_t color) {
+    int j = 0;
+#ifdef __SSSE3__
+    if (n >= 16) {
+        uint8_t pattern[48];
+        for (int k = 0; k < 16; k++)
+            memcpy(pattern + 3 * k, &color, 3);
+        const __m128i p0 = _mm_loadu_si128((const __m128i*)(pattern + 0));
+        const __m128i p1 = _mm_loadu_si128((const __m128i*)(pattern + 16));
+        const __m128i p2 = _mm_loadu_si128((const __m128i*)(pattern + 32));
+        for (; j + 16 <= n; j += 16) {
+            uint8_t* out = (uint8_t*)(row + j);
+            _mm_storeu_si128((__m128i*)(out + 0), p0);
+            _mm_storeu_si128((__m128i*)(out + 16), p1);
+            _mm_storeu_si128((__m128i*)(out + 32), p2);
+        }
+    }
+#endif
+    for (; j < n; j++)
+        row[j] = color;
+}
+
 void image_plot_bounding_box(rgb8_t** img, int ymin, int ymax, int xmin, int xmax, int border, rgb8_t color,
                              int is_dashed) {
     for (int b = 0; b < border; b++) {
@@ -114,6 +150,13 @@ void image_plot_bounding_box(rgb8_t** img, int ymin, int ymax, int xmin, int xma
             }
         }
 
+        // the plain horizontal edges are whole spans
+        if (!is_dashed) {
+            _image_fill_span(img[ymin] + xmin, xmax - xmin + 1, color);
+            _image_fill_span(img[ymax] + xmin, xmax - xmin + 1, color);
+            continue;
+        }
+
         counter = b % limit;
         draw = 1;
         for (int j = xmin; j <= xmax; j++) {
@@ -223,7 +266,9 @@ void _image_draw_RoIs_id(cv::Mat& cv_img, const RoI_t* RoIs, const size_t n_RoIs
 }
 #endif
 
-void image_draw_BBs(rgb8_t** I_bb, const BB_t* BBs, const enum color_e* BBs_color, int n_BBs, int w, int h) {
+// draw the BBs and mark the rows where they are drawn in `dirty` (if not NULL)
+static void _image_draw_BBs(rgb8_t** I_bb, const BB_t* BBs, const enum color_e* BBs_color, int n_BBs, int w, int h,
+                            uint8_t* dirty) {
     int border = 2;
     for (int i = 0; i < n_BBs; i++) {
         int ymin = BBs[i].bb_y - (BBs[i].ry + DELTA_BB);
@@ -238,9 +283,15 @@ void image_draw_BBs(rgb8_t** I_bb, const BB_t* BBs, const enum color_e* BBs_colo
 
         image_plot_bounding_box(I_bb, ymin_fix, ymax_fix, xmin_fix, xmax_fix, border, image_get_color(BBs_color[i]),
                                 BBs[i].is_extrapolated);
+        if (dirty)
+            memset(dirty + ymin_fix, 1, ymax_fix - ymin_fix + 1);
     }
 }
 
+void image_draw_BBs(rgb8_t** I_bb, const BB_t* BBs, const enum color_e* BBs_color, int n_BBs, int w, int h) {
+    _image_draw_BBs(I_bb, BBs, BBs_color, n_BBs, w, h, NULL);
+}
+
 rgb8_t** image_color_load(const char* filename, long* i0, long* i1, long* j0, long* j1) {
     VERBOSE(printf("%s\n", filename););
     ffmpeg_handle reader;
@@ -272,6 +323,7 @@ img_data_t* image_gs_alloc(const size_t img_height, const size_t img_width) {
     img_data_t* img_data = (img_data_t*)malloc(sizeof(img_data_t));
     img_data->width = img_width;
     img_data->height = img_height;
+    img_data->cache = NULL;
 #ifdef MOTION_OPENCV_LINK
     img_data->pixels = (void*) new cv::Mat(img_data->height, img_data->width, CV_8U, cv::Scalar(255));
     uint8_t** container_2d = (uint8_t**) malloc(sizeof(uint8_t*) * img_data->height);
@@ -364,10 +416,68 @@ void image_gs_free(img_data_t* img_data) {
     free(img_data);
 }
 
+void image_downscale(const uint8_t** img_in, const int i0, const int i1, const int j0, const int j1,
+                     uint8_t** img_out, const int factor) {
+    const int h = (i1 - i0 + 1) / factor, w = (j1 - j0 + 1) / factor;
+    const int area = factor * factor, round = area / 2;
+
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < h; i++) {
+        const uint8_t* in = img_in[i0 + i * factor] + j0;
+        uint8_t* out = img_out[i0 + i] + j0;
+        int j = 0;
+#ifdef __AVX2__
+        const __m256i ones8 = _mm256_set1_epi8(1);
+        if (factor == 2) {
+            const uint8_t* in1 = img_in[i0 + i * factor + 1] + j0;
+            // 32 input pixels -> 16 output pixels: horizontal pairs with `maddubs`, then vertical add
+            const __m256i vround = _mm256_set1_epi16(2);
+            for (; j + 16 <= w; j += 16) {
+                __m256i s0 = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in + 2 * j)), ones8);
+                __m256i s1 = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in1 + 2 * j)), ones8);
+                __m256i s = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(s0, s1), vround), 2);
+                s = _mm256_permute4x64_epi64(_mm256_packus_epi16(s, s), 0xD8);
+                _mm_storeu_si128((__m128i*)(out + j), _mm256_castsi256_si128(s));
+            }
+        } else if (factor == 4) {
+            // 32 input pixels -> 8 output pixels: pairs with `maddubs`, 4 rows add, then pairs of pairs with `madd`
+            const uint8_t* in1 = img_in[i0 + i * factor + 1] + j0;
+            const uint8_t* in2 = img_in[i0 + i * factor + 2] + j0;
+            const uint8_t* in3 = img_in[i0 + i * factor + 3] + j0;
+            const __m256i ones16 = _mm256_set1_epi16(1);
+            const __m256i vround = _mm256_set1_epi32(8);
+            for (; j + 8 <= w; j += 8) {
+                __m256i s = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in + 4 * j)), ones8);
+                s = _mm256_add_epi16(s, _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in1 + 4 * j)), ones8));
+                s = _mm256_add_epi16(s, _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in2 + 4 * j)), ones8));
+                s = _mm256_add_epi16(s, _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in3 + 4 * j)), ones8));
+                __m256i d = _mm256_srli_epi32(_mm256_add_epi32(_mm256_madd_epi16(s, ones16), vround), 4);
+                d = _mm256_packus_epi16(_mm256_packus_epi32(d, d), d);
+                const int32_t lo = _mm256_cvtsi256_si32(d), hi = _mm256_extract_epi32(d, 4);
+                memcpy(out + j, &lo, 4);
+                memcpy(out + j + 4, &hi, 4);
+            }
+        }
+#endif
+        for (; j < w; j++) {
+            unsigned sum = 0;
+            for (int k = 0; k < factor; k++)
+                for (int l = 0; l < factor; l++)
+                    sum += img_in[i0 + i * factor + k][j0 + j * factor + l];
+            out[j] = (uint8_t)((sum + round) / area);
+        }
+    }
+}
+
 img_data_t* image_color_alloc(const size_t img_height, const size_t img_width) {
     img_data_t* img_data = (img_data_t*)malloc(sizeof(img_data_t));
     img_data->width = img_width;
     img_data->height = img_height;
+    _image_color_cache_t* cache = (_image_color_cache_t*)malloc(sizeof(_image_color_cache_t));
+    cache->gray = ui8matrix(0, img_data->height - 1, 0, img_data->width - 1);
+    cache->dirty = (uint8_t*)calloc(img_data->height, sizeof(uint8_t));
+    cache->valid = 0;
+    img_data->cache = (void*)cache;
 #ifdef MOTION_OPENCV_LINK
     img_data->pixels = (void*) new cv::Mat(img_data->height, img_data->width, CV_8UC3, cv::Scalar(255, 255, 255));
     rgb8_t** container_2d = (rgb8_t**) malloc(sizeof(rgb8_t*) * img_data->height);
@@ -381,32 +491,54 @@ img_data_t* image_color_alloc(const size_t img_height, const size_t img_width) {
     return img_data;
 }
 
+// expand a row of gray pixels in RGB (or BGR, this is the same), the pixels equal to the ones in `prev` are skipped
+// when `skip` is set, `prev` is updated with the new pixels
+static void _image_gray_to_rgb_row(const uint8_t* in, uint8_t* prev, rgb8_t* out_rgb, const size_t n, const int skip) {
+    uint8_t* out = (uint8_t*)out_rgb;
+    size_t j = 0;
+#ifdef __SSSE3__
+    // 16 gray pixels -> 48 bytes: each output vector is a byte shuffle of the input vector (3-way interleave)
+    const __m128i m0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    const __m128i m1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    const __m128i m2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+    for (; j + 16 <= n; j += 16) {
+        const __m128i g = _mm_loadu_si128((const __m128i*)(in + j));
+        if (skip && _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_loadu_si128((const __m128i*)(prev + j)))) == 0xFFFF)
+            continue;
+        _mm_storeu_si128((__m128i*)(prev + j), g);
+        _mm_storeu_si128((__m128i*)(out + 3 * j + 0), _mm_shuffle_epi8(g, m0));
+        _mm_storeu_si128((__m128i*)(out + 3 * j + 16), _mm_shuffle_epi8(g, m1));
+        _mm_storeu_si128((__m128i*)(out + 3 * j + 32), _mm_shuffle_epi8(g, m2));
+    }
+#endif
+    for (; j < n; j++) {
+        if (skip && in[j] == prev[j])
+            continue;
+        prev[j] = in[j];
+        out[3 * j + 0] = in[j];
+        out[3 * j + 1] = in[j];
+        out[3 * j + 2] = in[j];
+    }
+}
+
 void image_color_draw_BBs(img_data_t* img_data, const uint8_t** img, const BB_t* BBs,
                           const enum color_e* BBs_color, const size_t n_BBs, const uint8_t show_id,
                           const uint8_t is_gt) {
-#ifdef MOTION_OPENCV_LINK
-    cv::Mat* pixels = (cv::Mat*)img_data->pixels;
-    for (size_t i = 0; i < (size_t)pixels->rows; i++) {
-        for (size_t j = 0; j < (size_t)pixels->cols; j++) {
-            pixels->at<cv::Vec3b>(i, j)[2] = img[i][j];
-            pixels->at<cv::Vec3b>(i, j)[1] = img[i][j];
-            pixels->at<cv::Vec3b>(i, j)[0] = img[i][j];
-        }
-    }
-#else
-    rgb8_t** pixels = (rgb8_t**)img_data->pixels;
+    // the color image is kept between two calls: only the gray pixels that changed and the rows where BBs have been
+    // drawn are expanded again
+    _image_color_cache_t* cache = (_image_color_cache_t*)img_data->cache;
+    rgb8_t** pixels = image_color_get_pixels_2d(img_data);
     for (size_t i = 0; i < img_data->height; i++) {
-        for (size_t j = 0; j < img_data->width; j++) {
-            pixels[i][j].r = img[i][j];
-            pixels[i][j].g = img[i][j];
-            pixels[i][j].b = img[i][j];
-        }
+        _image_gray_to_rgb_row(img[i], cache->gray[i], pixels[i], img_data->width, cache->valid && !cache->dirty[i]);
+        cache->dirty[i] = 0;
     }
-#endif
-    image_draw_BBs(image_color_get_pixels_2d(img_data), BBs, BBs_color, n_BBs, img_data->width,
-                   img_data->height);
+    cache->valid = 1;
+    _image_draw_BBs(pixels, BBs, BBs_color, n_BBs, img_data->width, img_data->height, cache->dirty);
 #ifdef MOTION_OPENCV_LINK
     image_draw_text(img_data, BBs, BBs_color, n_BBs, is_gt, show_id);
+    // the texts (ids, legend) are anti-aliased and can be anywhere in the image: their rows are not tracked, the
+    // cache is bypassed when OpenCV draws
+    cache->valid = 0;
 #endif
 }
 
@@ -426,6 +558,7 @@ void image_color_draw_frame_id(img_data_t* img_data, const size_t frame_id) {
                 cv::Scalar(gray.r, gray.g, gray.b), // color
                 1,                                  // ?
                 cv::LINE_AA);                       // ?
+    ((_image_color_cache_t*)img_data->cache)->valid = 0;
 #endif
 }
 
@@ -454,5 +587,9 @@ void image_color_free(img_data_t* img_data) {
     rgb8_t** pixels = (rgb8_t**)img_data->pixels;
     free_rgb8matrix((rgb8**)pixels, 0, img_data->height -1, 0, img_data->width -1);
 #endif
+    _image_color_cache_t* cache = (_image_color_cache_t*)img_data->cache;
+    free_ui8matrix(cache->gray, 0, img_data->height - 1, 0, img_data->width - 1);
+    free(cache->dirty);
+    free(cache);
     free(img_data);
 }
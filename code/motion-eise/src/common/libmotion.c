@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <vec.h>
+
+#include "motion/pipeline/pipeline_compute.h"
+#include "motion/pipeline/pipeline_io.h"
+#include "motion/tracking/tracking_struct.h"
+#include "motion/libmotion.h"
+
+void motion_params_default(motion_params_t* params, const int width, const int height) {
+    params->width = width;
+    params->height = height;
+    params->chain.i0 = 0;
+    params->chain.i1 = height - 1;
+    params->chain.j0 = 0;
+    params->chain.j1 = width - 1;
+    params->chain.sd_scale = 1;
+    params->chain.sd_n = 2;
+    params->chain.cca_roi_max1 = 65536;
+    params->chain.cca_roi_max2 = 8192;
+    params->chain.flt_s_min = 50;
+    params->chain.flt_s_max = 100000;
+    params->chain.knn_k = 3;
+    params->chain.knn_d = 10;
+    params->chain.knn_s = 0.125f;
+    params->chain.trk_ext_d = 5;
+    params->chain.trk_obj_min = 2;
+    params->chain.trk_ext_o = 3;
+    params->chain.trk_save_RoIs_id = 0;
+    params->chain.with_L2 = 0;
+    params->chain.external = 0;
+    params->stages = NULL;
+}
+
+motion_pipeline_t* motion_pipeline_create(const motion_params_t* params) {
+    if (params->width <= 0 || params->height <= 0) {
+        fprintf(stderr, "(EE) 'motion_pipeline_create' needs a positive frame size (%dx%d)\n", params->width,
+                params->height);
+        return NULL;
+    }
+    motion_pipeline_t* mp = (motion_pipeline_t*)malloc(sizeof(motion_pipeline_t));
+    if (!mp) {
+        fprintf(stderr, "(EE) 'motion_pipeline_create' failed\n");
+        return NULL;
+    }
+    pipeline_params_t chain = params->chain;
+    chain.i0 = 0;
+    chain.i1 = params->height - 1;
+    chain.j0 = 0;
+    chain.j1 = params->width - 1;
+    mp->pip = pipeline_alloc(&chain, params->stages);
+    mp->rows = (const uint8_t**)malloc(params->height * sizeof(const uint8_t*));
+    mp->height = params->height;
+    mp->n_frames = 0;
+    return mp;
+}
+
+uint32_t motion_pipeline_push_view(motion_pipeline_t* mp, const uint8_t** img, const int frame) {
+    if (!mp->n_frames++) {
+        pipeline_init(mp->pip, img);
+        return 0;
+    }
+    // the RoIs at t become the ones at t - 1
+    pipeline_swap_RoIs(mp->pip);
+    pipeline_detect(mp->pip, 1, img);
+    pipeline_associate(mp->pip, frame);
+    return mp->pip->frames[1].n_RoIs;
+}
+
+void motion_pipeline_drop_view(motion_pipeline_t* mp, const uint8_t** img) {
+    if (!mp->n_frames) {
+        if (!img) {
+            fprintf(stderr, "(EE) 'motion_pipeline_drop_view' needs the rows of the first frame (background model)\n");
+            exit(1);
+        }
+        motion_pipeline_push_view(mp, img, 0);
+        return;
+    }
+    pipeline_drop(mp->pip, 1, img);
+    mp->n_frames++;
+}
+
+uint32_t motion_pipeline_push_frame(motion_pipeline_t* mp, const uint8_t* luma, const size_t stride) {
+    for (int i = 0; i < mp->height; i++)
+        mp->rows[i] = luma + i * stride;
+    return motion_pipeline_push_view(mp, mp->rows, (int)mp->n_frames);
+}
+
+uint32_t motion_pipeline_get_RoIs(const motion_pipeline_t* mp, const RoI_t** RoIs) {
+    *RoIs = mp->pip->frames[1].RoIs;
+    return mp->pip->frames[1].n_RoIs;
+}
+
+size_t motion_pipeline_get_tracks(const motion_pipeline_t* mp, const track_t** tracks) {
+    const tracking_data_t* tracking_data = (const tracking_data_t*)mp->pip->data[PIP_TRK];
+    *tracks = tracking_data->tracks;
+    return vector_size(tracking_data->tracks);
+}
+
+void motion_pipeline_reset(motion_pipeline_t* mp) {
+    pipeline_reset(mp->pip);
+    mp->n_frames = 0;
+}
+
+int motion_pipeline_save(const motion_pipeline_t* mp, const char* path) {
+    char tmp_path[2048 + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "(EE) can't create the checkpoint %s\n", tmp_path);
+        return -1;
+    }
+    pipeline_checkpoint_write(f, mp->pip);
+    const uint64_t n_frames = mp->n_frames;
+    fwrite(&n_frames, sizeof(n_frames), 1, f);
+    // synced before the rename: after a crash, the checkpoint is the previous one or the new one
+    if (fflush(f) || fsync(fileno(f)) || fclose(f) || rename(tmp_path, path)) {
+        fprintf(stderr, "(EE) can't write the checkpoint %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int motion_pipeline_load(motion_pipeline_t* mp, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "(EE) can't open the checkpoint %s\n", path);
+        return -1;
+    }
+    uint64_t n_frames;
+    int err = pipeline_checkpoint_read(f, mp->pip);
+    if (!err && fread(&n_frames, sizeof(n_frames), 1, f) != 1) {
+        fprintf(stderr, "(EE) the checkpoint %s is truncated\n", path);
+        err = -1;
+    }
+    fclose(f);
+    if (err) {
+        // the checkpoint may have been partially restored
+        motion_pipeline_reset(mp);
+        return -1;
+    }
+    mp->n_frames = (size_t)n_frames;
+    return 0;
+}
+
+void motion_pipeline_free(motion_pipeline_t* mp) {
+    pipeline_free(mp->pip);
+    free(mp->rows);
+    free(mp);
+}
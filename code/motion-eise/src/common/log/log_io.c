@@ -0,0 +1,755 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "vec.h"
+
+#include "motion/macros.h"
+#include "motion/tools.h"
+#include "motion/log/log_io.h"
+
+static void _log_backoff(unsigned* n_tries) {
+    if ((*n_tries)++ < 64)
+        sched_yield();
+    else
+        usleep(50);
+}
+
+static void* _log_buffer_write(void* arg) {
+    log_buffer_t* buf = (log_buffer_t*)arg;
+    while (1) {
+        void* item;
+        unsigned n_tries = 0;
+        while (!spsc_queue_pop(buf->filled, &item))
+            _log_backoff(&n_tries);
+        log_chunk_t* chunk = (log_chunk_t*)item;
+        if (chunk->size && fwrite(chunk->data, 1, chunk->size, buf->file) != chunk->size) {
+            fprintf(stderr, "(EE) error while writing a binary log\n");
+            exit(1);
+        }
+        chunk->size = 0;
+        if (chunk->last)
+            break;
+        // cannot fail: the queue capacity is higher or equal to the number of chunks
+        spsc_queue_push(buf->empty, item);
+    }
+    return NULL;
+}
+
+log_buffer_t* log_buffer_alloc_init(const char* path, const size_t chunk_size, const size_t n_chunks) {
+    assert(chunk_size > 0 && n_chunks >= 2);
+    log_buffer_t* buf = (log_buffer_t*)calloc(1, sizeof(log_buffer_t));
+    if (!buf) {
+        fprintf(stderr, "(EE) 'log_buffer_alloc_init' failed\n");
+        exit(1);
+    }
+    buf->file = fopen(path, "wb");
+    if (buf->file == NULL) {
+        fprintf(stderr, "(EE) error while opening '%s'\n", path);
+        exit(1);
+    }
+    buf->n_chunks = n_chunks;
+    buf->chunks = (log_chunk_t*)calloc(n_chunks, sizeof(log_chunk_t));
+    buf->filled = spsc_queue_alloc(n_chunks);
+    buf->empty = spsc_queue_alloc(n_chunks);
+    for (size_t c = 0; c < n_chunks; c++) {
+        buf->chunks[c].data = (uint8_t*)malloc(chunk_size);
+        buf->chunks[c].capacity = chunk_size;
+        if (c)
+            spsc_queue_push(buf->empty, &buf->chunks[c]);
+    }
+    buf->cur = &buf->chunks[0];
+    if (pthread_create(&buf->thread, NULL, _log_buffer_write, buf)) {
+        fprintf(stderr, "(EE) Unable to create the log writer thread.\n");
+        exit(1);
+    }
+    return buf;
+}
+
+uint8_t* log_buffer_reserve(log_buffer_t* buf, const size_t size) {
+    log_chunk_t* chunk = buf->cur;
+    if (chunk->size + size > chunk->capacity) {
+        if (chunk->size) {
+            spsc_queue_push(buf->filled, chunk);
+            void* item;
+            if (!spsc_queue_pop(buf->empty, &item)) {
+                unsigned n_tries = 0;
+                TIME_POINT(stall_b);
+                while (!spsc_queue_pop(buf->empty, &item))
+                    _log_backoff(&n_tries);
+                TIME_POINT(stall_e);
+                buf->stall_us += TIME_ELAPSED2_US(stall_b, stall_e);
+            }
+            chunk = buf->cur = (log_chunk_t*)item;
+        }
+        if (size > chunk->capacity) {
+            chunk->data = (uint8_t*)realloc(chunk->data, size);
+            chunk->capacity = size;
+        }
+    }
+    return chunk->data + chunk->size;
+}
+
+void log_buffer_commit(log_buffer_t* buf, const size_t size) {
+    assert(buf->cur->size + size <= buf->cur->capacity);
+    buf->cur->size += size;
+    buf->n_bytes += size;
+}
+
+void log_buffer_free(log_buffer_t* buf) {
+    buf->cur->last = 1;
+    spsc_queue_push(buf->filled, buf->cur);
+    pthread_join(buf->thread, NULL);
+    fclose(buf->file);
+    for (size_t c = 0; c < buf->n_chunks; c++)
+        free(buf->chunks[c].data);
+    free(buf->chunks);
+    spsc_queue_free(buf->filled);
+    spsc_queue_free(buf->empty);
+    free(buf);
+}
+
+log_writer_t* log_writer_alloc_init(const char* path, const size_t chunk_size, const size_t n_chunks) {
+    log_writer_t* log = (log_writer_t*)calloc(1, sizeof(log_writer_t));
+    if (!log) {
+        fprintf(stderr, "(EE) 'log_writer_alloc_init' failed\n");
+        exit(1);
+    }
+    log->buffer = log_buffer_alloc_init(path, chunk_size, n_chunks);
+    log_file_header_t* header = (log_file_header_t*)log_buffer_reserve(log->buffer, sizeof(log_file_header_t));
+    memset(header, 0, sizeof(log_file_header_t));
+    memcpy(header->magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+    header->version = LOG_VERSION;
+    header->header_size = sizeof(log_file_header_t);
+    log_buffer_commit(log->buffer, sizeof(log_file_header_t));
+    return log;
+}
+
+// Computes the track id of each RoI (same result as `find_corresponding_track` but in a single pass on the tracks)
+static void _log_track_ids(log_state_t* state, const int frame, const vec_track_t tracks, const RoI_t* RoIs,
+                           const size_t n_RoIs, const unsigned age) {
+    if (state->max_track_ids < n_RoIs + 1) {
+        state->max_track_ids = 2 * (n_RoIs + 1);
+        state->track_ids = (uint32_t*)realloc(state->track_ids, state->max_track_ids * sizeof(uint32_t));
+    }
+    memset(state->track_ids, 0, (n_RoIs + 1) * sizeof(uint32_t));
+    const size_t n_tracks = vector_size(tracks);
+    for (size_t t = 0; t < n_tracks; t++) {
+        if (!tracks[t].id || tracks[t].end.frame != (uint32_t)(frame + age))
+            continue;
+        uint32_t RoI_id;
+        if (age == 0)
+            RoI_id = tracks[t].end.r.id;
+        else {
+            if (tracks[t].end.r.prev_id == 0)
+                continue;
+            RoI_id = RoIs[tracks[t].end.r.prev_id - 1].id;
+        }
+        // the first track wins
+        if (RoI_id && RoI_id <= n_RoIs && !state->track_ids[RoI_id])
+            state->track_ids[RoI_id] = tracks[t].id;
+    }
+}
+
+static uint32_t _log_write_RoIs(log_state_t* state, log_RoI_t* recs, const int frame, const vec_track_t tracks,
+                                const RoI_t* RoIs, const size_t n_RoIs, const unsigned age) {
+    _log_track_ids(state, frame, tracks, RoIs, n_RoIs, age);
+    uint32_t n = 0;
+    for (size_t i = 0; i < n_RoIs; i++) {
+        if (RoIs[i].id == 0)
+            continue;
+        log_RoI_t* rec = &recs[n++];
+        rec->id = RoIs[i].id;
+        rec->track_id = RoIs[i].id <= n_RoIs ? state->track_ids[RoIs[i].id] : 0;
+        rec->xmin = RoIs[i].xmin;
+        rec->xmax = RoIs[i].xmax;
+        rec->ymin = RoIs[i].ymin;
+        rec->ymax = RoIs[i].ymax;
+        rec->S = RoIs[i].S;
+        rec->x = RoIs[i].x;
+        rec->y = RoIs[i].y;
+    }
+    return n;
+}
+
+// Writes the tracks that changed since the previous call (at most `vector_size(tracks)` records)
+static uint32_t _log_write_tracks(log_state_t* state, log_track_t* recs, const vec_track_t tracks) {
+    const size_t n_tracks = vector_size(tracks);
+    if (state->max_tracks < n_tracks) {
+        state->max_tracks = 2 * n_tracks;
+        state->tracks = (log_track_t*)realloc(state->tracks, state->max_tracks * sizeof(log_track_t));
+    }
+    uint32_t n = 0;
+    for (size_t t = 0; t < n_tracks; t++) {
+        log_track_t rec;
+        rec.index = t;
+        rec.id = tracks[t].id;
+        rec.begin_frame = tracks[t].begin.frame;
+        rec.begin_x = tracks[t].begin.r.x;
+        rec.begin_y = tracks[t].begin.r.y;
+        rec.end_frame = tracks[t].end.frame;
+        rec.end_x = tracks[t].end.r.x;
+        rec.end_y = tracks[t].end.r.y;
+        rec.state = (uint32_t)tracks[t].state;
+        if (t >= state->n_tracks || memcmp(&rec, &state->tracks[t], sizeof(log_track_t))) {
+            state->tracks[t] = rec;
+            recs[n++] = rec;
+        }
+    }
+    state->n_tracks = n_tracks;
+    return n;
+}
+
+static void _log_state_free(log_state_t* state) {
+    free(state->tracks);
+    free(state->track_ids);
+}
+
+void log_writer_write_frame(log_writer_t* log, const int prev_frame, const int cur_frame, const RoI_t* RoIs0,
+                            const size_t n_RoIs0, const RoI_t* RoIs1, const size_t n_RoIs1,
+                            const kNN_data_t* kNN_data, const vec_track_t tracks) {
+    const size_t n_tracks = vector_size(tracks);
+    // upper bound of the frame record size (the conflicts are counted exactly)
+    size_t n_conflict_recs = 0;
+    if (kNN_data && kNN_data->conflicts)
+        for (size_t j = 0; j < n_RoIs1; j++)
+            if (kNN_data->conflicts[j] > 1) {
+                n_conflict_recs++;
+                for (size_t i = 0; i < n_RoIs0; i++)
+                    n_conflict_recs += kNN_data->nearest[i][j] == 1;
+            }
+    const size_t max_size = sizeof(log_frame_t) + (n_RoIs0 + n_RoIs1) * sizeof(log_RoI_t) +
+                            n_RoIs0 * sizeof(log_asso_t) + n_conflict_recs * sizeof(log_conflict_t) +
+                            n_tracks * sizeof(log_track_t);
+    uint8_t* ptr = log_buffer_reserve(log->buffer, max_size);
+
+    log_frame_t* frame = (log_frame_t*)ptr;
+    memset(frame, 0, sizeof(log_frame_t));
+    frame->tag = LOG_FRAME_TAG;
+    frame->prev_frame = prev_frame;
+    frame->cur_frame = cur_frame;
+    frame->flags = kNN_data ? LOG_FRAME_ASSOS : 0;
+    frame->n_conflicts = LOG_NO_CONFLICTS;
+    frame->n_tracks = n_tracks;
+    ptr += sizeof(log_frame_t);
+
+    if (prev_frame >= 0)
+        frame->n_RoIs0 = _log_write_RoIs(&log->state, (log_RoI_t*)ptr, prev_frame, tracks, RoIs0, n_RoIs0, 1);
+    ptr += frame->n_RoIs0 * sizeof(log_RoI_t);
+    frame->n_RoIs1 = _log_write_RoIs(&log->state, (log_RoI_t*)ptr, cur_frame, tracks, RoIs1, n_RoIs1, 0);
+    ptr += frame->n_RoIs1 * sizeof(log_RoI_t);
+
+    if (kNN_data) {
+        log_asso_t* assos = (log_asso_t*)ptr;
+        for (size_t i = 0; i < n_RoIs0; i++) {
+            if (!RoIs0[i].next_id)
+                continue;
+            frame->n_assos_tot++;
+            if (RoIs0[i].id == 0)
+                continue;
+            const size_t j = (size_t)(RoIs0[i].next_id - 1);
+            log_asso_t* rec = &assos[frame->n_assos++];
+            rec->id0 = RoIs0[i].id;
+            rec->id1 = RoIs0[i].next_id;
+            rec->dist = sqrtf(kNN_data->distances[i][j]);
+            rec->rank = kNN_data->nearest[i][j];
+        }
+        ptr += frame->n_assos * sizeof(log_asso_t);
+
+        if (kNN_data->conflicts) {
+            log_conflict_t* conflicts = (log_conflict_t*)ptr;
+            frame->n_conflicts = 0;
+            for (size_t j = 0; j < n_RoIs1; j++) {
+                if (kNN_data->conflicts[j] <= 1)
+                    continue;
+                frame->n_conflicts++;
+                log_conflict_t* rec = &conflicts[frame->n_conflict_recs++];
+                rec->id1 = j + 1;
+                rec->id0 = 0;
+                rec->dist = 0.f;
+                for (size_t i = 0; i < n_RoIs0; i++)
+                    if (kNN_data->nearest[i][j] == 1) {
+                        rec = &conflicts[frame->n_conflict_recs++];
+                        rec->id1 = j + 1;
+                        rec->id0 = i + 1;
+                        rec->dist = sqrtf(kNN_data->distances[i][j]);
+                    }
+            }
+            ptr += frame->n_conflict_recs * sizeof(log_conflict_t);
+        }
+    }
+
+    frame->n_track_deltas = _log_write_tracks(&log->state, (log_track_t*)ptr, tracks);
+    ptr += frame->n_track_deltas * sizeof(log_track_t);
+
+    log_buffer_commit(log->buffer, ptr - (uint8_t*)frame);
+    log->n_frames++;
+}
+
+void log_writer_free(log_writer_t* log) {
+    log_buffer_free(log->buffer);
+    _log_state_free(&log->state);
+    free(log);
+}
+
+// Same format as `features_RoIs_write` (with tracks)
+static void _log_RoIs_text(FILE* f, const log_RoI_t* RoIs, const size_t n_RoIs) {
+    fprintf(f, "Regions of interest (RoI) [%d]: \n", (int)n_RoIs);
+    fprintf(f, "# ------||-------||---------------------------||---------||-------------------\n");
+    fprintf(f, "#   RoI || Track ||        Bounding Box       || Surface ||      Center       \n");
+    fprintf(f, "# ------||-------||---------------------------||---------||-------------------\n");
+    fprintf(f, "# ------||-------||------|------|------|------||---------||---------|---------\n");
+    fprintf(f, "#    ID ||    ID || xmin | xmax | ymin | ymax ||       S ||       x |       y \n");
+    fprintf(f, "# ------||-------||------|------|------|------||---------||---------|---------\n");
+    for (size_t i = 0; i < n_RoIs; i++) {
+        char track_id_str[16];
+        if (RoIs[i].track_id == 0)
+            strcpy(track_id_str, "    -");
+        else
+            snprintf(track_id_str, sizeof(track_id_str), "%5u", RoIs[i].track_id);
+        fprintf(f, "   %4u || %s || %4u | %4u | %4u | %4u || %7u || %7.1f | %7.1f \n", RoIs[i].id, track_id_str,
+                RoIs[i].xmin, RoIs[i].xmax, RoIs[i].ymin, RoIs[i].ymax, RoIs[i].S, RoIs[i].x, RoIs[i].y);
+    }
+}
+
+// Same format as `kNN_asso_conflicts_write`
+static void _log_assos_text(FILE* f, const log_frame_t* frame, const log_asso_t* assos,
+                            const log_conflict_t* conflicts) {
+    fprintf(f, "# Associations [%d]:\n", (int)frame->n_assos_tot);
+    if (frame->n_assos_tot) {
+        fprintf(f, "# ------------||---------------\n");
+        fprintf(f, "#    RoI ID   ||    Distance   \n");
+        fprintf(f, "# ------------||---------------\n");
+        fprintf(f, "# -----|------||--------|------\n");
+        fprintf(f, "#  t-1 |    t || pixels | rank \n");
+        fprintf(f, "# -----|------||--------|------\n");
+    }
+    for (size_t a = 0; a < frame->n_assos; a++)
+        fprintf(f, "  %4u | %4u || %6.3f | %4d \n", assos[a].id0, assos[a].id1, assos[a].dist, (int)assos[a].rank);
+
+    if (frame->n_conflicts == LOG_NO_CONFLICTS)
+        return;
+    fprintf(f, "#\n");
+    if (!frame->n_conflicts) {
+        fprintf(f, "# No conflict found\n");
+        return;
+    }
+    fprintf(f, "# Association conflicts [%d]:\n", (int)frame->n_conflicts);
+    for (size_t c = 0; c < frame->n_conflict_recs; c++) {
+        if (conflicts[c].id0 == 0) {
+            if (c)
+                fprintf(f, " }\n");
+            fprintf(f, "RoI ID (t) = %d, list of possible RoI IDs (t-1): { ", (int)conflicts[c].id1);
+        } else {
+            if (conflicts[c - 1].id0 != 0)
+                fprintf(f, ", ");
+            fprintf(f, "%d [dist = %2.2f]", (int)conflicts[c].id0, conflicts[c].dist);
+        }
+    }
+    fprintf(f, " }\n");
+}
+
+// Same format as `tracking_tracks_write_full`
+static void _log_tracks_text(FILE* f, const log_track_t* tracks, const size_t n_tracks) {
+    size_t real_n_tracks = 0;
+    for (size_t i = 0; i < n_tracks; i++)
+        if (tracks[i].id)
+            real_n_tracks++;
+
+    fprintf(f, "# Tracks [%lu]:\n", (unsigned long)real_n_tracks);
+    fprintf(f, "# -------||---------------------------||---------------------------||-------\n");
+    fprintf(f, "#  Track ||           Begin           ||            End            || State \n");
+    fprintf(f, "# -------||---------------------------||---------------------------||-------\n");
+    fprintf(f, "# -------||---------|--------|--------||---------|--------|--------||-------\n");
+    fprintf(f, "#     Id || Frame # |      x |      y || Frame # |      x |      y ||       \n");
+    fprintf(f, "# -------||---------|--------|--------||---------|--------|--------||-------\n");
+
+    const char* str_states[N_STATES] = {"  UKN", "  UPD", "  LST", "  FNS"};
+    for (size_t i = 0; i < n_tracks; i++)
+        if (tracks[i].id) {
+            const char* str_state = tracks[i].state < N_STATES ? str_states[tracks[i].state] : "  ???";
+            fprintf(f, "   %5d || %7u | %6.1f | %6.1f || %7u | %6.1f | %6.1f || %s \n", (int)tracks[i].id,
+                    tracks[i].begin_frame, tracks[i].begin_x, tracks[i].begin_y, tracks[i].end_frame,
+                    tracks[i].end_x, tracks[i].end_y, str_state);
+        }
+}
+
+static void _log_read(void* ptr, const size_t size, FILE* f, const char* path) {
+    if (size && fread(ptr, size, 1, f) != 1) {
+        fprintf(stderr, "(EE) '%s' is truncated\n", path);
+        exit(1);
+    }
+}
+
+size_t log_convert_text(const char* bin_path, const char* folder_path) {
+    FILE* bin = fopen(bin_path, "rb");
+    if (bin == NULL) {
+        fprintf(stderr, "(EE) error while opening '%s'\n", bin_path);
+        exit(1);
+    }
+    log_file_header_t header;
+    _log_read(&header, sizeof(header), bin, bin_path);
+    if (memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) || header.version != LOG_VERSION ||
+        header.header_size != sizeof(log_file_header_t)) {
+        fprintf(stderr, "(EE) '%s' is not a binary log (version %d expected)\n", bin_path, LOG_VERSION);
+        exit(1);
+    }
+    tools_create_folder(folder_path);
+
+    log_track_t* tracks = NULL;
+    size_t max_tracks = 0;
+    uint8_t* buf = NULL;
+    size_t max_buf = 0;
+    size_t n_frames = 0;
+    log_frame_t frame;
+    while (fread(&frame, sizeof(frame), 1, bin) == 1) {
+        if (frame.tag != LOG_FRAME_TAG) {
+            fprintf(stderr, "(EE) '%s' is corrupted (frame record n°%lu)\n", bin_path, (unsigned long)n_frames);
+            exit(1);
+        }
+        const size_t n_conflict_recs = frame.n_conflicts == LOG_NO_CONFLICTS ? 0 : frame.n_conflict_recs;
+        const size_t size = (frame.n_RoIs0 + frame.n_RoIs1) * sizeof(log_RoI_t) + frame.n_assos * sizeof(log_asso_t) +
+                            n_conflict_recs * sizeof(log_conflict_t) + frame.n_track_deltas * sizeof(log_track_t);
+        if (max_buf < size) {
+            max_buf = size;
+            buf = (uint8_t*)realloc(buf, max_buf);
+        }
+        _log_read(buf, size, bin, bin_path);
+        const log_RoI_t* RoIs0 = (const log_RoI_t*)buf;
+        const log_RoI_t* RoIs1 = RoIs0 + frame.n_RoIs0;
+        const log_asso_t* assos = (const log_asso_t*)(RoIs1 + frame.n_RoIs1);
+        const log_conflict_t* conflicts = (const log_conflict_t*)(assos + frame.n_assos);
+        const log_track_t* deltas = (const log_track_t*)(conflicts + n_conflict_recs);
+
+        if (max_tracks < frame.n_tracks) {
+            tracks = (log_track_t*)realloc(tracks, frame.n_tracks * sizeof(log_track_t));
+            memset(tracks + max_tracks, 0, (frame.n_tracks - max_tracks) * sizeof(log_track_t));
+            max_tracks = frame.n_tracks;
+        }
+        for (size_t d = 0; d < frame.n_track_deltas; d++) {
+            if (deltas[d].index >= frame.n_tracks) {
+                fprintf(stderr, "(EE) '%s' is corrupted (frame record n°%lu)\n", bin_path, (unsigned long)n_frames);
+                exit(1);
+            }
+            tracks[deltas[d].index] = deltas[d];
+        }
+
+        char filename[1024];
+        snprintf(filename, sizeof(filename), "%s/%05d.txt", folder_path, frame.cur_frame);
+        FILE* f = fopen(filename, "w");
+        if (f == NULL) {
+            fprintf(stderr, "(EE) error while opening '%s'\n", filename);
+            exit(1);
+        }
+        if (frame.prev_frame >= 0) {
+            fprintf(f, "# Frame n°%05d (t-1) -- ", frame.prev_frame);
+            _log_RoIs_text(f, RoIs0, frame.n_RoIs0);
+            fprintf(f, "#\n");
+        }
+        fprintf(f, "# Frame n°%05d (t) -- ", frame.cur_frame);
+        _log_RoIs_text(f, RoIs1, frame.n_RoIs1);
+        if (frame.flags & LOG_FRAME_ASSOS) {
+            fprintf(f, "#\n");
+            _log_assos_text(f, &frame, assos, conflicts);
+            fprintf(f, "#\n");
+            _log_tracks_text(f, tracks, frame.n_tracks);
+        }
+        fclose(f);
+        n_frames++;
+    }
+    free(buf);
+    free(tracks);
+    fclose(bin);
+    return n_frames;
+}
+
+log_shm_writer_t* log_shm_writer_alloc_init(const char* path, const size_t capacity) {
+    size_t cap = 4096;
+    while (cap < capacity)
+        cap <<= 1;
+    log_shm_writer_t* shm = (log_shm_writer_t*)calloc(1, sizeof(log_shm_writer_t));
+    if (!shm) {
+        fprintf(stderr, "(EE) 'log_shm_writer_alloc_init' failed\n");
+        exit(1);
+    }
+    shm->map_size = LOG_SHM_HEADER_SIZE + cap;
+
+    // the ring is created under a temporary name and renamed once its header is complete
+    char tmp_path[2048 + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1 || ftruncate(fd, shm->map_size)) {
+        fprintf(stderr, "(EE) can't create the shared-memory ring %s\n", tmp_path);
+        exit(1);
+    }
+    void* map = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "(EE) can't map the shared-memory ring %s\n", tmp_path);
+        exit(1);
+    }
+    shm->header = (log_shm_header_t*)map;
+    memcpy(shm->header->magic, LOG_SHM_MAGIC, 8);
+    shm->header->version = LOG_SHM_VERSION;
+    shm->header->capacity = cap;
+    if (rename(tmp_path, path)) {
+        fprintf(stderr, "(EE) can't rename %s into %s\n", tmp_path, path);
+        exit(1);
+    }
+    return shm;
+}
+
+void log_shm_writer_write_frame(log_shm_writer_t* shm, const int frame, const RoI_t* RoIs, const size_t n_RoIs,
+                                const vec_track_t tracks) {
+    log_shm_header_t* header = shm->header;
+    uint8_t* data = (uint8_t*)header + LOG_SHM_HEADER_SIZE;
+    const uint64_t cap = header->capacity;
+    // upper bound of the record size (the number of updated tracks is not known yet)
+    const size_t max_size = (sizeof(log_shm_record_t) + n_RoIs * sizeof(log_RoI_t) +
+                             vector_size(tracks) * sizeof(log_track_t) + 7) & ~(size_t)7;
+    if (max_size > cap / 2) {
+        shm->n_dropped++;
+        // the next record has to contain all the tracks
+        shm->state.n_tracks = 0;
+        return;
+    }
+
+    uint64_t pos = header->write_pos; // only written by this process
+    const uint64_t pad = (pos % cap) + max_size > cap ? cap - (pos % cap) : 0;
+    __atomic_store_n(&header->reserve_pos, pos + pad + max_size, __ATOMIC_RELAXED);
+    // the consumers have to see the new reserved area before the overwritten records
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (pad) {
+        log_shm_record_t* rec = (log_shm_record_t*)(data + (pos % cap));
+        rec->tag = LOG_SHM_PAD_TAG;
+        rec->size = pad;
+        pos += pad;
+    }
+
+    log_shm_record_t* rec = (log_shm_record_t*)(data + (pos % cap));
+    rec->tag = LOG_FRAME_TAG;
+    rec->seq = header->n_records;
+    rec->frame = frame;
+    rec->_pad = 0;
+    log_RoI_t* RoIs_recs = (log_RoI_t*)(rec + 1);
+    rec->n_RoIs = _log_write_RoIs(&shm->state, RoIs_recs, frame, tracks, RoIs, n_RoIs, 0);
+    rec->n_tracks = _log_write_tracks(&shm->state, (log_track_t*)(RoIs_recs + rec->n_RoIs), tracks);
+    rec->size = (sizeof(log_shm_record_t) + rec->n_RoIs * sizeof(log_RoI_t) + rec->n_tracks * sizeof(log_track_t) +
+                 7) & ~(size_t)7;
+
+    __atomic_store_n(&header->n_records, header->n_records + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->write_pos, pos + rec->size, __ATOMIC_RELEASE);
+}
+
+void log_shm_writer_free(log_shm_writer_t* shm) {
+    __atomic_store_n(&shm->header->eos, 1, __ATOMIC_RELEASE);
+    munmap(shm->header, shm->map_size);
+    _log_state_free(&shm->state);
+    free(shm);
+}
+
+log_shm_reader_t* log_shm_reader_alloc_init(const char* path) {
+    log_shm_reader_t* shm = (log_shm_reader_t*)calloc(1, sizeof(log_shm_reader_t));
+    if (!shm) {
+        fprintf(stderr, "(EE) 'log_shm_reader_alloc_init' failed\n");
+        exit(1);
+    }
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) || (size_t)st.st_size < LOG_SHM_HEADER_SIZE) {
+        fprintf(stderr, "(EE) can't open the shared-memory ring %s\n", path);
+        exit(1);
+    }
+    shm->map_size = st.st_size;
+    void* map = mmap(NULL, shm->map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "(EE) can't map the shared-memory ring %s\n", path);
+        exit(1);
+    }
+    shm->header = (const log_shm_header_t*)map;
+    const uint64_t cap = shm->header->capacity;
+    if (memcmp(shm->header->magic, LOG_SHM_MAGIC, 8) || shm->header->version != LOG_SHM_VERSION || !cap ||
+        (cap & (cap - 1)) || shm->map_size < LOG_SHM_HEADER_SIZE + cap) {
+        fprintf(stderr, "(EE) %s is not a valid shared-memory records ring (version %u expected)\n", path,
+                LOG_SHM_VERSION);
+        exit(1);
+    }
+    // start with the next published record
+    shm->pos = __atomic_load_n(&shm->header->write_pos, __ATOMIC_ACQUIRE);
+    shm->seq = __atomic_load_n(&shm->header->n_records, __ATOMIC_ACQUIRE);
+    shm->cur_pos = shm->pos;
+    return shm;
+}
+
+int log_shm_reader_next(log_shm_reader_t* shm, const log_shm_record_t** record) {
+    const log_shm_header_t* header = shm->header;
+    const uint8_t* data = (const uint8_t*)header + LOG_SHM_HEADER_SIZE;
+    const uint64_t cap = header->capacity;
+    while (1) {
+        // `eos` is loaded first: `write_pos` is final when `eos` is set
+        const uint32_t eos = __atomic_load_n(&header->eos, __ATOMIC_ACQUIRE);
+        const uint64_t write_pos = __atomic_load_n(&header->write_pos, __ATOMIC_ACQUIRE);
+        if (shm->pos == write_pos)
+            return eos ? -1 : 0;
+        const log_shm_record_t* rec = (const log_shm_record_t*)(data + (shm->pos % cap));
+        const uint32_t tag = rec->tag, size = rec->size;
+        const uint64_t seq = rec->seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&header->reserve_pos, __ATOMIC_RELAXED) > shm->pos + cap ||
+            size < 8 || size % 8 || size > cap) {
+            // overwritten before being read: jump to the last published position
+            shm->pos = write_pos;
+            continue;
+        }
+        if (tag == LOG_SHM_PAD_TAG) {
+            shm->pos += size;
+            continue;
+        }
+        if (seq > shm->seq)
+            shm->n_lost += seq - shm->seq;
+        shm->seq = seq + 1;
+        shm->cur_pos = shm->pos;
+        shm->pos += size;
+        *record = rec;
+        return 1;
+    }
+}
+
+int log_shm_reader_check(const log_shm_reader_t* shm) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&shm->header->reserve_pos, __ATOMIC_RELAXED) <= shm->cur_pos + shm->header->capacity;
+}
+
+void log_shm_reader_free(log_shm_reader_t* shm) {
+    munmap((void*)shm->header, shm->map_size);
+    free(shm);
+}
+
+log_runs_writer_t* log_runs_writer_alloc_init(const char* path, const size_t width, const size_t height,
+                                              const int start) {
+    if (width > 65536 || height > 65536) {
+        fprintf(stderr, "(EE) the runs format is limited to 65536x65536 frames\n");
+        exit(1);
+    }
+    log_runs_writer_t* runs = (log_runs_writer_t*)calloc(1, sizeof(log_runs_writer_t));
+    if (!runs) {
+        fprintf(stderr, "(EE) 'log_runs_writer_alloc_init' failed\n");
+        exit(1);
+    }
+    runs->buffer = log_buffer_alloc_init(path, 1 << 20, 4);
+    log_runs_header_t* header = (log_runs_header_t*)log_buffer_reserve(runs->buffer, sizeof(log_runs_header_t));
+    memset(header, 0, sizeof(log_runs_header_t));
+    memcpy(header->magic, LOG_RUNS_MAGIC, 8);
+    header->version = LOG_RUNS_VERSION;
+    header->header_size = sizeof(log_runs_header_t);
+    header->width = width;
+    header->height = height;
+    header->start = start;
+    log_buffer_commit(runs->buffer, sizeof(log_runs_header_t));
+    return runs;
+}
+
+void log_runs_writer_write_frame(log_runs_writer_t* runs, const int frame, const CCL_data_t* CCL_data,
+                                 const RoI_t* RoIs, const size_t n_RoIs) {
+    // final labels, in the same order as `features_filter_surface`
+    if (runs->max_labels < n_RoIs + 1) {
+        runs->max_labels = 2 * (n_RoIs + 1);
+        runs->labels = (uint32_t*)realloc(runs->labels, runs->max_labels * sizeof(uint32_t));
+    }
+    uint32_t n_labels = 0;
+    runs->labels[0] = 0;
+    for (size_t r = 0; r < n_RoIs; r++)
+        runs->labels[r + 1] = RoIs[r].id ? ++n_labels : 0;
+    if (n_labels > 65535) {
+        fprintf(stderr, "(EE) the runs format is limited to 65535 labels per frame\n");
+        exit(1);
+    }
+
+    size_t max_runs = 0;
+    for (int i = CCL_data->i0; i <= CCL_data->i1; i++)
+        max_runs += CCL_data->ner[i] / 2;
+    uint8_t* ptr = log_buffer_reserve(runs->buffer, sizeof(log_runs_frame_t) + max_runs * sizeof(log_run_t));
+    log_runs_frame_t* header = (log_runs_frame_t*)ptr;
+    header->tag = LOG_FRAME_TAG;
+    header->frame = frame;
+    header->n_labels = n_labels;
+    log_run_t* run = (log_run_t*)(header + 1);
+    uint32_t n_runs = 0;
+    for (int i = CCL_data->i0; i <= CCL_data->i1; i++) {
+        const uint32_t* rlc = CCL_data->rlc[i];
+        for (uint32_t k = 0; k < CCL_data->ner[i]; k += 2) {
+            // same label as `_LSL_compute_final_image_labeling`
+            const uint32_t label = CCL_data->eq[CCL_data->era[i][CCL_data->er[i][rlc[k]]]] + 1;
+            if (label > n_RoIs || !runs->labels[label])
+                continue;
+            run[n_runs].row = i;
+            run[n_runs].start = rlc[k];
+            run[n_runs].end = rlc[k + 1];
+            run[n_runs].label = runs->labels[label];
+            n_runs++;
+        }
+    }
+    header->n_runs = n_runs;
+    log_buffer_commit(runs->buffer, sizeof(log_runs_frame_t) + n_runs * sizeof(log_run_t));
+    runs->n_frames++;
+}
+
+void log_runs_writer_free(log_runs_writer_t* runs) {
+    log_buffer_free(runs->buffer);
+    free(runs->labels);
+    free(runs);
+}
+
+log_runs_reader_t* log_runs_reader_alloc_init(const char* path) {
+    log_runs_reader_t* runs = (log_runs_reader_t*)calloc(1, sizeof(log_runs_reader_t));
+    if (!runs) {
+        fprintf(stderr, "(EE) 'log_runs_reader_alloc_init' failed\n");
+        exit(1);
+    }
+    runs->file = fopen(path, "rb");
+    if (runs->file == NULL) {
+        fprintf(stderr, "(EE) error while opening '%s'\n", path);
+        exit(1);
+    }
+    log_runs_header_t header;
+    _log_read(&header, sizeof(header), runs->file, path);
+    if (memcmp(header.magic, LOG_RUNS_MAGIC, 8) || header.version != LOG_RUNS_VERSION ||
+        header.header_size != sizeof(log_runs_header_t)) {
+        fprintf(stderr, "(EE) '%s' is not a runs file (version %d expected)\n", path, LOG_RUNS_VERSION);
+        exit(1);
+    }
+    runs->width = header.width;
+    runs->height = header.height;
+    runs->start = header.start;
+    return runs;
+}
+
+int log_runs_reader_next(log_runs_reader_t* runs, log_runs_frame_t* frame) {
+    if (fread(frame, sizeof(log_runs_frame_t), 1, runs->file) != 1)
+        return 0;
+    if (frame->tag != LOG_FRAME_TAG) {
+        fprintf(stderr, "(EE) the runs file is corrupted (frame n°%d)\n", frame->frame);
+        exit(1);
+    }
+    if (runs->max_runs < frame->n_runs) {
+        runs->max_runs = 2 * frame->n_runs;
+        runs->runs = (log_run_t*)realloc(runs->runs, runs->max_runs * sizeof(log_run_t));
+    }
+    _log_read(runs->runs, frame->n_runs * sizeof(log_run_t), runs->file, "the runs file");
+    return 1;
+}
+
+void log_runs_reader_free(log_runs_reader_t* runs) {
+    fclose(runs->file);
+    free(runs->runs);
+    free(runs);
+}
@@ -0,0 +1,622 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <nrc2.h>
+
+#include "motion/macros.h"
+#include "motion/tools.h"
+#include "motion/sigma_delta/sigma_delta_compute.h"
+#include "motion/sigma_delta/sigma_delta_io.h"
+#include "motion/morpho/morpho_compute.h"
+#include "motion/CCL/CCL_compute.h"
+#include "motion/features/features_compute.h"
+#include "motion/kNN/kNN_compute.h"
+#include "motion/tracking/tracking_compute.h"
+#include "motion/tracking/tracking_io.h"
+#include "motion/image/image_compute.h"
+
+#include "motion/pipeline/pipeline_compute.h"
+
+// ------------------------------------------------------------------------------------------------------- SIGMA-DELTA
+
+static void* _sd_alloc(const pipeline_t* pip) {
+    return (void*)sigma_delta_alloc_data(pip->si0, pip->si1, pip->sj0, pip->sj1, 1, 254);
+}
+
+// the detection image (downscaled if `p.sd_scale` > 1)
+static const uint8_t** _sd_input(const pipeline_t* pip, const uint8_t** img) {
+    if (!pip->IS)
+        return img;
+    image_downscale(img, pip->p.i0, pip->p.i1, pip->p.j0, pip->p.j1, pip->IS, pip->p.sd_scale);
+    return (const uint8_t**)pip->IS;
+}
+
+static void _sd_init(void* data, const pipeline_t* pip, pipeline_frame_t* fra) {
+    sigma_delta_data_t* sd_data = (sigma_delta_data_t*)data;
+    sigma_delta_init_data(sd_data, _sd_input(pip, fra->IG), pip->si0, pip->si1, pip->sj0, pip->sj1);
+    fra->M = (const uint8_t**)sd_data->M;
+    fra->V = (const uint8_t**)sd_data->V;
+}
+
+static void _sd_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    sigma_delta_data_t* sd_data = (sigma_delta_data_t*)data;
+    sigma_delta_compute(sd_data, _sd_input(pip, fra->IG), fra->IB, pip->si0, pip->si1, pip->sj0, pip->sj1,
+                        pip->p.sd_n);
+    fra->M = (const uint8_t**)sd_data->M;
+    fra->V = (const uint8_t**)sd_data->V;
+}
+
+static void _sd_free(void* data) {
+    sigma_delta_free_data((sigma_delta_data_t*)data);
+}
+
+static void _sd_save(const void* data, FILE* f) {
+    sigma_delta_data_write(f, (const sigma_delta_data_t*)data);
+}
+
+static int _sd_load(void* data, const pipeline_t* pip, pipeline_frame_t* fra, FILE* f) {
+    (void)pip;
+    sigma_delta_data_t* sd_data = (sigma_delta_data_t*)data;
+    fra->M = (const uint8_t**)sd_data->M;
+    fra->V = (const uint8_t**)sd_data->V;
+    return sigma_delta_data_read(f, sd_data);
+}
+
+// -------------------------------------------------------------------------------------------------------- MORPHOLOGY
+
+static void* _mrp_alloc(const pipeline_t* pip) {
+    morpho_data_t* morpho_data = morpho_alloc_data(pip->si0, pip->si1, pip->sj0, pip->sj1);
+    morpho_init_data(morpho_data);
+    return (void*)morpho_data;
+}
+
+static void _mrp_open_close3_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    morpho_data_t* morpho_data = (morpho_data_t*)data;
+    morpho_compute_opening3(morpho_data, (const uint8_t**)fra->IB, fra->IB, pip->si0, pip->si1, pip->sj0, pip->sj1);
+    morpho_compute_closing3(morpho_data, (const uint8_t**)fra->IB, fra->IB, pip->si0, pip->si1, pip->sj0, pip->sj1);
+}
+
+static void _mrp_open3_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    morpho_data_t* morpho_data = (morpho_data_t*)data;
+    morpho_compute_opening3(morpho_data, (const uint8_t**)fra->IB, fra->IB, pip->si0, pip->si1, pip->sj0, pip->sj1);
+}
+
+static void _mrp_none_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    (void)data;
+    (void)pip;
+    (void)fra;
+}
+
+static void _mrp_free(void* data) {
+    morpho_free_data((morpho_data_t*)data);
+}
+
+// --------------------------------------------------------------------------------------------------------------- CCL
+
+static void* _ccl_alloc(const pipeline_t* pip) {
+    CCL_data_t* CCL_data = CCL_LSL_alloc_data(pip->si0, pip->si1, pip->sj0, pip->sj1);
+    CCL_LSL_init_data(CCL_data);
+    return (void*)CCL_data;
+}
+
+static void _ccl_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    fra->n_RoIs_tmp = CCL_LSL_apply((CCL_data_t*)data, (const uint8_t**)fra->IB, fra->L1, 0);
+    assert(fra->n_RoIs_tmp <= (uint32_t)pip->p.cca_roi_max1);
+}
+
+static void _ccl_free(void* data) {
+    CCL_LSL_free_data((CCL_data_t*)data);
+}
+
+// --------------------------------------------------------------------------------------------------------------- CCA
+
+static void _cca_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    (void)data;
+    features_extract((const uint32_t**)fra->L1, pip->si0, pip->si1, pip->sj0, pip->sj1, fra->RoIs_tmp,
+                     fra->n_RoIs_tmp);
+    if (pip->IS) { // back to full resolution, for the RoIs that can reach the minimum surface
+        features_filter_surface((const uint32_t**)fra->L1, NULL, pip->si0, pip->si1, pip->sj0, pip->sj1,
+                                fra->RoIs_tmp, fra->n_RoIs_tmp, pip->sd_s_min, UINT32_MAX);
+        features_refine_upscaled(fra->IG, pip->p.i0, pip->p.i1, pip->p.j0, pip->p.j1, (const uint32_t**)fra->L1,
+                                 fra->M, fra->V, fra->RoIs_tmp, fra->n_RoIs_tmp, pip->p.sd_scale);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------- SURFACE FILTERING
+
+static void _flt_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    (void)data;
+    fra->n_RoIs = features_filter_surface((const uint32_t**)fra->L1, fra->L2, pip->si0, pip->si1, pip->sj0,
+                                          pip->sj1, fra->RoIs_tmp, fra->n_RoIs_tmp, pip->p.flt_s_min,
+                                          pip->p.flt_s_max);
+    assert(fra->n_RoIs <= (uint32_t)pip->p.cca_roi_max2);
+    features_shrink_basic(fra->RoIs_tmp, fra->n_RoIs_tmp, fra->RoIs);
+}
+
+// -------------------------------------------------------------------------------------------------------------- k-NN
+
+static void* _knn_alloc(const pipeline_t* pip) {
+    kNN_data_t* kNN_data = kNN_alloc_data(pip->p.cca_roi_max2);
+    kNN_init_data(kNN_data);
+    return (void*)kNN_data;
+}
+
+static void _knn_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    (void)fra;
+    // the objects move further when frames have been dropped in between
+    kNN_match((kNN_data_t*)data, pip->frames[0].RoIs, pip->frames[0].n_RoIs, pip->frames[1].RoIs,
+              pip->frames[1].n_RoIs, pip->p.knn_k, pip->p.knn_d * (pip->n_dropped + 1), pip->p.knn_s);
+}
+
+static void _knn_free(void* data) {
+    kNN_free_data((kNN_data_t*)data);
+}
+
+// ---------------------------------------------------------------------------------------------------------- TRACKING
+
+static void* _trk_alloc(const pipeline_t* pip) {
+    tracking_data_t* tracking_data = tracking_alloc_data(MAX(pip->p.trk_obj_min, pip->p.trk_ext_o) + 1,
+                                                         pip->p.cca_roi_max2);
+    tracking_init_data(tracking_data);
+    return (void*)tracking_data;
+}
+
+static void _trk_process(void* data, pipeline_t* pip, pipeline_frame_t* fra) {
+    tracking_perform((tracking_data_t*)data, fra->RoIs, fra->n_RoIs, pip->cur_fra, pip->n_dropped + 1,
+                     pip->p.trk_ext_d, pip->p.trk_obj_min, pip->p.trk_save_RoIs_id, pip->p.trk_ext_o, pip->p.knn_s);
+}
+
+static void _trk_free(void* data) {
+    tracking_free_data((tracking_data_t*)data);
+}
+
+static void _trk_save(const void* data, FILE* f) {
+    tracking_data_write(f, (const tracking_data_t*)data);
+}
+
+static int _trk_load(void* data, const pipeline_t* pip, pipeline_frame_t* fra, FILE* f) {
+    (void)pip;
+    (void)fra;
+    return tracking_data_read(f, (tracking_data_t*)data);
+}
+
+// ---------------------------------------------------------------------------------------------------------- REGISTRY
+
+// the first stage of each step is the default one, the data of the CCL, k-NN and tracking stages have to be
+// `CCL_data_t`, `kNN_data_t` and `tracking_data_t` (they are read by the logs and the visualization)
+static const pipeline_stage_t _pipeline_registry[] = {
+    {PIP_SD, "sigma-delta", "Sigma-Delta (+ downscale if --sd-scale > 1)", PIP_BUF_IG, PIP_BUF_IB | PIP_BUF_BG, 1, 0,
+     _sd_alloc, _sd_init, _sd_process, _sd_free, _sd_save, _sd_load},
+    {PIP_MRP, "open-close3", "3x3 opening then 3x3 closing", PIP_BUF_IB, PIP_BUF_IB, 1, 0,
+     _mrp_alloc, NULL, _mrp_open_close3_process, _mrp_free, NULL, NULL},
+    {PIP_MRP, "open3", "3x3 opening only", PIP_BUF_IB, PIP_BUF_IB, 1, 0,
+     _mrp_alloc, NULL, _mrp_open3_process, _mrp_free, NULL, NULL},
+    {PIP_MRP, "none", "no morphology", PIP_BUF_IB, PIP_BUF_IB, 0, 0,
+     NULL, NULL, _mrp_none_process, NULL, NULL, NULL},
+    {PIP_CCL, "lsl", "Light Speed Labeling", PIP_BUF_IB, PIP_BUF_L1, 1, 0,
+     _ccl_alloc, NULL, _ccl_process, _ccl_free, NULL, NULL},
+    {PIP_CCA, "features", "bounding boxes, surfaces and centroids (+ full resolution refinement)",
+     PIP_BUF_IG | PIP_BUF_BG | PIP_BUF_L1, PIP_BUF_RT, 0, 0, NULL, NULL, _cca_process, NULL, NULL, NULL},
+    {PIP_FLT, "surface", "minimum and maximum surfaces", PIP_BUF_L1 | PIP_BUF_RT, PIP_BUF_RO, 0, 0,
+     NULL, NULL, _flt_process, NULL, NULL, NULL},
+    {PIP_KNN, "knn", "k-Nearest Neighbors matching", PIP_BUF_RO, PIP_BUF_AS, 0, 0,
+     _knn_alloc, NULL, _knn_process, _knn_free, NULL, NULL},
+    {PIP_TRK, "tracking", "tracks creation, extrapolation and classification", PIP_BUF_RO | PIP_BUF_AS,
+     PIP_BUF_TR, 0, 1, _trk_alloc, NULL, _trk_process, _trk_free, _trk_save, _trk_load},
+};
+
+static const size_t _pipeline_registry_size = sizeof(_pipeline_registry) / sizeof(_pipeline_registry[0]);
+
+static const char* _pipeline_step_names[PIP_N_STAGES] = {"sd", "mrp", "ccl", "cca", "flt", "knn", "trk"};
+static const char* _pipeline_step_labels[PIP_N_STAGES] = {"Sigma-Delta", "Morphology", "CC Labeling", "CC Analysis",
+                                                           "Filtering", "k-NN", "Tracking"};
+
+const char* pipeline_step_name(const enum pipeline_stage_e step) {
+    return _pipeline_step_names[step];
+}
+
+void pipeline_registry_print(FILE* f) {
+    for (size_t s = 0; s < _pipeline_registry_size; s++) {
+        const pipeline_stage_t* stage = &_pipeline_registry[s];
+        const int is_default = !s || _pipeline_registry[s - 1].step != stage->step;
+        fprintf(f, "  %-4s %-12s %s%s\n", pipeline_step_name(stage->step), stage->name, stage->desc,
+                is_default ? " [default]" : "");
+    }
+}
+
+static const pipeline_stage_t* _pipeline_stage_find(const enum pipeline_stage_e step, const char* name,
+                                                     const size_t name_len) {
+    for (size_t s = 0; s < _pipeline_registry_size; s++) {
+        const pipeline_stage_t* stage = &_pipeline_registry[s];
+        if (stage->step == step && (!name || (strlen(stage->name) == name_len && !strncmp(stage->name, name,
+                                                                                           name_len))))
+            return stage;
+    }
+    return NULL;
+}
+
+// `stages` = "step=name,step=name,..."
+static void _pipeline_select(pipeline_t* pip, const char* stages) {
+    for (int s = 0; s < PIP_N_STAGES; s++)
+        pip->stages[s] = _pipeline_stage_find((enum pipeline_stage_e)s, NULL, 0);
+    // on a downscaled image the 3x3 closing merges the close CCs and the opening is already strong enough (a
+    // downscaled pixel is the mean of `sd_scale`^2 pixels), then only the opening is applied by default
+    if (pip->p.sd_scale > 1)
+        pip->stages[PIP_MRP] = _pipeline_stage_find(PIP_MRP, "open3", 5);
+    const char* cur = stages;
+    while (cur && *cur) {
+        const char* end = strchr(cur, ',');
+        const size_t len = end ? (size_t)(end - cur) : strlen(cur);
+        const char* eq = (const char*)memchr(cur, '=', len);
+        int step = -1;
+        for (int s = 0; eq && s < PIP_N_STAGES; s++)
+            if (strlen(_pipeline_step_names[s]) == (size_t)(eq - cur) &&
+                !strncmp(_pipeline_step_names[s], cur, eq - cur))
+                step = s;
+        const pipeline_stage_t* stage = step == -1 ? NULL :
+            _pipeline_stage_find((enum pipeline_stage_e)step, eq + 1, len - (eq + 1 - cur));
+        if (!stage) {
+            fprintf(stderr, "(EE) unknown stage '%.*s', the available stages are ('step=name'):\n", (int)len, cur);
+            pipeline_registry_print(stderr);
+            exit(1);
+        }
+        pip->stages[step] = stage;
+        cur = end ? end + 1 : NULL;
+    }
+
+    // the inputs of a stage have to be produced by the previous ones
+    uint32_t available = PIP_BUF_IG;
+    for (int s = 0; s < PIP_N_STAGES; s++) {
+        const pipeline_stage_t* stage = pip->stages[s];
+        if (stage->inputs & ~available) {
+            fprintf(stderr, "(EE) the '%s=%s' stage needs buffers (0x%x) that are not produced by the previous "
+                    "stages\n", pipeline_step_name(stage->step), stage->name, stage->inputs & ~available);
+            exit(1);
+        }
+        available |= stage->outputs;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------- PIPELINE
+
+pipeline_t* pipeline_alloc(const pipeline_params_t* p, const char* stages) {
+    pipeline_t* pip = (pipeline_t*)calloc(1, sizeof(pipeline_t));
+    if (!pip) {
+        fprintf(stderr, "(EE) 'pipeline_alloc' failed\n");
+        exit(1);
+    }
+    pip->p = *p;
+    _pipeline_select(pip, stages);
+
+    // detection image dimension (Sigma-Delta, morphology, CCL and CCA), downscaled by `sd_scale`
+    pip->si0 = p->i0;
+    pip->si1 = p->i0 + (p->i1 - p->i0 + 1) / p->sd_scale - 1;
+    pip->sj0 = p->j0;
+    pip->sj1 = p->j0 + (p->j1 - p->j0 + 1) / p->sd_scale - 1;
+    // a full resolution surface is at most `sd_scale`^2 times the downscaled one
+    pip->sd_s_min = (p->flt_s_min + p->sd_scale * p->sd_scale - 1) / (p->sd_scale * p->sd_scale);
+    if (p->sd_scale > 1)
+        pip->IS = ui8matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+
+    for (int f = 0; f < 2; f++) {
+        pipeline_frame_t* fra = &pip->frames[f];
+        fra->IB = ui8matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+        fra->L1 = ui32matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+        if (p->with_L2)
+            fra->L2 = ui32matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+        fra->RoIs_tmp = features_alloc_RoIs(p->cca_roi_max1);
+        fra->RoIs = features_alloc_RoIs(p->cca_roi_max2);
+        features_init_RoIs(fra->RoIs_tmp, p->cca_roi_max1);
+        features_init_RoIs(fra->RoIs, p->cca_roi_max2);
+    }
+    for (int s = 0; s < PIP_N_STAGES; s++) {
+        const pipeline_stage_t* stage = pip->stages[s];
+        if ((p->external >> s) & 1) {
+            if (stage->per_frame) {
+                fprintf(stderr, "(EE) the data of the '%s=%s' stage can't be external (they are per frame)\n",
+                        pipeline_step_name(stage->step), stage->name);
+                exit(1);
+            }
+            continue;
+        }
+        if (!stage->alloc)
+            continue;
+        if (stage->per_frame)
+            for (int f = 0; f < 2; f++)
+                pip->frames[f].data[s] = stage->alloc(pip);
+        else
+            pip->data[s] = stage->alloc(pip);
+    }
+    return pip;
+}
+
+void pipeline_init(pipeline_t* pip, const uint8_t** img) {
+    for (int f = 0; f < 2; f++) {
+        pipeline_frame_t* fra = &pip->frames[f];
+        fra->IG = img;
+        for (int s = 0; s < PIP_N_STAGES; s++)
+            if (pip->stages[s]->init)
+                pip->stages[s]->init(pip->stages[s]->per_frame ? fra->data[s] : pip->data[s], pip, fra);
+        zero_ui8matrix(fra->IB, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        zero_ui32matrix(fra->L1, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        if (fra->L2)
+            zero_ui32matrix(fra->L2, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        fra->n_RoIs_tmp = 0;
+        fra->n_RoIs = 0;
+    }
+}
+
+// run the stages of the [`first`, `last`] steps on a frame and accumulate their times
+static void _pipeline_run(pipeline_t* pip, pipeline_frame_t* fra, const int first, const int last) {
+    for (int s = first; s <= last; s++) {
+        const pipeline_stage_t* stage = pip->stages[s];
+        TIME_POINT(stage_b);
+        stage->process(stage->per_frame ? fra->data[s] : pip->data[s], pip, fra);
+        TIME_POINT(stage_e);
+        pip->stage_us[s] += TIME_ELAPSED2_US(stage_b, stage_e);
+    }
+}
+
+void pipeline_detect(pipeline_t* pip, const int f, const uint8_t** img) {
+    assert(f == 0 || f == 1);
+    pip->frames[f].IG = img;
+    _pipeline_run(pip, &pip->frames[f], PIP_SD, PIP_FLT);
+}
+
+void pipeline_drop(pipeline_t* pip, const int f, const uint8_t** img) {
+    assert(f == 0 || f == 1);
+    if (img) {
+        pip->frames[f].IG = img;
+        _pipeline_run(pip, &pip->frames[f], PIP_SD, PIP_SD);
+    }
+    pip->n_dropped++;
+}
+
+void pipeline_associate(pipeline_t* pip, const int cur_fra) {
+    pip->cur_fra = cur_fra;
+    _pipeline_run(pip, &pip->frames[1], PIP_KNN, PIP_TRK);
+    pip->n_dropped = 0;
+}
+
+void pipeline_set_data(pipeline_t* pip, const enum pipeline_stage_e step, void* data) {
+    assert((pip->p.external >> step) & 1);
+    assert(!pip->stages[step]->stateful || !pip->data[step]);
+    pip->data[step] = data;
+}
+
+void pipeline_swap_RoIs(pipeline_t* pip) {
+    RoI_t* tmp_RoIs = pip->frames[0].RoIs;
+    pip->frames[0].RoIs = pip->frames[1].RoIs;
+    pip->frames[1].RoIs = tmp_RoIs;
+    uint32_t tmp_n = pip->frames[0].n_RoIs;
+    pip->frames[0].n_RoIs = pip->frames[1].n_RoIs;
+    pip->frames[1].n_RoIs = tmp_n;
+}
+
+void pipeline_stages_print(FILE* f, const pipeline_t* pip) {
+    for (int s = 0; s < PIP_N_STAGES; s++)
+        fprintf(f, "%s%s=%s", s ? "," : "", pipeline_step_name((enum pipeline_stage_e)s), pip->stages[s]->name);
+}
+
+void pipeline_latencies_print(FILE* f, const pipeline_t* pip, const size_t n_frames) {
+    for (int s = 0; s < PIP_N_STAGES; s++)
+        fprintf(f, "# -> %-15s= %8.3f ms\n", _pipeline_step_labels[s], pip->stage_us[s] * 1e-3 / n_frames);
+}
+
+void pipeline_reset(pipeline_t* pip) {
+    for (int s = 0; s < PIP_N_STAGES; s++) {
+        const pipeline_stage_t* stage = pip->stages[s];
+        if (!stage->stateful || ((pip->p.external >> s) & 1))
+            continue;
+        stage->free(pip->data[s]);
+        pip->data[s] = stage->alloc(pip);
+    }
+    for (int s = 0; s < PIP_N_STAGES; s++)
+        pip->stage_us[s] = 0.;
+    // the drops of the previous video must not widen the first association of the new one
+    pip->n_dropped = 0;
+    pip->cur_fra = 0;
+}
+
+// ---------------------------------------------------------------------------------------------- ASYNCHRONOUS PIPELINE
+
+// yield the CPU a few times and then sleep, a waiting thread should not steal the cores of the OpenMP workers
+static void _pipeline_async_backoff(unsigned* n_tries) {
+    if ((*n_tries)++ < 64)
+        sched_yield();
+    else
+        usleep(50);
+}
+
+static void* _pipeline_async_group_run(void* arg) {
+    pipeline_async_group_t* group = (pipeline_async_group_t*)arg;
+    pipeline_async_t* async = group->async;
+    while (1) {
+        void* item;
+        unsigned n_tries = 0;
+        while (!spsc_queue_pop(group->in, &item)) {
+            if (__atomic_load_n(&async->stop, __ATOMIC_ACQUIRE))
+                return NULL;
+            _pipeline_async_backoff(&n_tries);
+        }
+        pipeline_slot_t* slot = (pipeline_slot_t*)item;
+        TIME_POINT(group_b);
+        _pipeline_run(async->pip, &slot->fra, group->first, group->last);
+        // the Sigma-Delta model is updated by the next frame while this one is still refined by the CCA
+        if (slot->M && group->first == PIP_SD) {
+            const pipeline_t* pip = async->pip;
+            tools_copy_ui8matrix_ui8matrix(slot->fra.M, pip->si0, pip->si1, pip->sj0, pip->sj1, slot->M);
+            tools_copy_ui8matrix_ui8matrix(slot->fra.V, pip->si0, pip->si1, pip->sj0, pip->sj1, slot->V);
+            slot->fra.M = (const uint8_t**)slot->M;
+            slot->fra.V = (const uint8_t**)slot->V;
+        }
+        TIME_POINT(group_e);
+        group->busy_us += TIME_ELAPSED2_US(group_b, group_e);
+        // cannot fail: the queue capacity is higher or equal to the number of slots
+        spsc_queue_push(group->out, item);
+    }
+    return NULL;
+}
+
+pipeline_async_t* pipeline_async_alloc(pipeline_t* pip, const size_t n_frames) {
+    assert(n_frames >= 1);
+    pipeline_async_t* async = (pipeline_async_t*)calloc(1, sizeof(pipeline_async_t));
+    if (!async) {
+        fprintf(stderr, "(EE) 'pipeline_async_alloc' failed\n");
+        exit(1);
+    }
+    async->pip = pip;
+    async->frames[0] = pip->frames[0];
+    async->frames[1] = pip->frames[1];
+    async->n_slots = n_frames + 2;
+    async->slots = (pipeline_slot_t*)calloc(async->n_slots, sizeof(pipeline_slot_t));
+    async->free = (pipeline_slot_t**)malloc(async->n_slots * sizeof(pipeline_slot_t*));
+    for (size_t s = 0; s < async->n_slots; s++) {
+        pipeline_slot_t* slot = &async->slots[s];
+        slot->fra = pip->frames[1]; // same stage data
+        slot->fra.IB = ui8matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+        slot->fra.L1 = ui32matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+        slot->fra.L2 = pip->p.with_L2 ? ui32matrix(pip->si0, pip->si1, pip->sj0, pip->sj1) : NULL;
+        slot->fra.RoIs_tmp = features_alloc_RoIs(pip->p.cca_roi_max1);
+        slot->fra.RoIs = features_alloc_RoIs(pip->p.cca_roi_max2);
+        features_init_RoIs(slot->fra.RoIs_tmp, pip->p.cca_roi_max1);
+        features_init_RoIs(slot->fra.RoIs, pip->p.cca_roi_max2);
+        slot->fra.n_RoIs_tmp = 0;
+        slot->fra.n_RoIs = 0;
+        if (pip->IS) {
+            slot->M = ui8matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+            slot->V = ui8matrix(pip->si0, pip->si1, pip->sj0, pip->sj1);
+        }
+        if (s >= 2)
+            async->free[async->n_free++] = slot;
+    }
+    // the caller always holds two slots (then at most `n_frames` frames are in flight): the second one has the RoIs
+    // of the last frame processed by the pipeline (\f$t - 1\f$ of the first pop), the first one is not read
+    pipeline_slot_t* last = &async->slots[1];
+    memcpy(last->fra.RoIs, pip->frames[1].RoIs, pip->frames[1].n_RoIs * sizeof(RoI_t));
+    last->fra.n_RoIs = pip->frames[1].n_RoIs;
+    async->held[0] = &async->slots[0];
+    async->held[1] = last;
+
+    for (int q = 0; q < 3; q++)
+        async->queues[q] = spsc_queue_alloc(async->n_slots);
+    async->groups[0].first = PIP_SD;
+    async->groups[0].last = PIP_MRP;
+    async->groups[1].first = PIP_CCL;
+    async->groups[1].last = PIP_FLT;
+    for (int g = 0; g < 2; g++) {
+        pipeline_async_group_t* group = &async->groups[g];
+        group->async = async;
+        group->in = async->queues[g];
+        group->out = async->queues[g + 1];
+        if (pthread_create(&group->thread, NULL, _pipeline_async_group_run, group)) {
+            fprintf(stderr, "(EE) Unable to create the pipeline thread n°%d.\n", g);
+            exit(1);
+        }
+    }
+    return async;
+}
+
+size_t pipeline_async_n_free(const pipeline_async_t* async) {
+    return async->n_free;
+}
+
+void pipeline_async_push(pipeline_async_t* async, const uint8_t** img, const int cur_fra, void* user) {
+    assert(async->n_free);
+    pipeline_slot_t* slot = async->free[--async->n_free];
+    slot->fra.IG = img;
+    slot->cur_fra = cur_fra;
+    slot->user = user;
+    async->n_pending++;
+    // cannot fail: the queue capacity is higher or equal to the number of slots
+    spsc_queue_push(async->queues[0], slot);
+}
+
+int pipeline_async_pop(pipeline_async_t* async, void** user) {
+    if (!async->n_pending)
+        return -1;
+    void* item;
+    if (!spsc_queue_pop(async->queues[2], &item)) {
+        unsigned n_tries = 0;
+        TIME_POINT(stall_b);
+        while (!spsc_queue_pop(async->queues[2], &item))
+            _pipeline_async_backoff(&n_tries);
+        TIME_POINT(stall_e);
+        async->stall_us += TIME_ELAPSED2_US(stall_b, stall_e);
+    }
+    async->n_pending--;
+    pipeline_slot_t* slot = (pipeline_slot_t*)item;
+    // the frame at t - 2 is not read anymore by the caller
+    async->free[async->n_free++] = async->held[0];
+    async->held[0] = async->held[1];
+    async->held[1] = slot;
+
+    pipeline_t* pip = async->pip;
+    pip->frames[0] = async->held[0]->fra;
+    pip->frames[1] = slot->fra;
+    pipeline_associate(pip, slot->cur_fra);
+    *user = slot->user;
+    return slot->cur_fra;
+}
+
+void pipeline_async_free(pipeline_async_t* async) {
+    __atomic_store_n(&async->stop, 1, __ATOMIC_RELEASE);
+    for (int g = 0; g < 2; g++)
+        pthread_join(async->groups[g].thread, NULL);
+    pipeline_t* pip = async->pip;
+    for (int f = 0; f < 2; f++) {
+        pipeline_frame_t* fra = &async->frames[f];
+        if (pip->frames[f].RoIs != fra->RoIs) {
+            memcpy(fra->RoIs, pip->frames[f].RoIs, pip->frames[f].n_RoIs * sizeof(RoI_t));
+            fra->n_RoIs = pip->frames[f].n_RoIs;
+        }
+        pip->frames[f] = *fra;
+    }
+    for (size_t s = 0; s < async->n_slots; s++) {
+        pipeline_slot_t* slot = &async->slots[s];
+        free_ui8matrix(slot->fra.IB, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        free_ui32matrix(slot->fra.L1, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        if (slot->fra.L2)
+            free_ui32matrix(slot->fra.L2, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        features_free_RoIs(slot->fra.RoIs_tmp);
+        features_free_RoIs(slot->fra.RoIs);
+        if (slot->M) {
+            free_ui8matrix(slot->M, pip->si0, pip->si1, pip->sj0, pip->sj1);
+            free_ui8matrix(slot->V, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        }
+    }
+    for (int q = 0; q < 3; q++)
+        spsc_queue_free(async->queues[q]);
+    free(async->slots);
+    free(async->free);
+    free(async);
+}
+
+void pipeline_free(pipeline_t* pip) {
+    for (int s = 0; s < PIP_N_STAGES; s++) {
+        const pipeline_stage_t* stage = pip->stages[s];
+        if (!stage->free || ((pip->p.external >> s) & 1))
+            continue;
+        if (stage->per_frame)
+            for (int f = 0; f < 2; f++)
+                stage->free(pip->frames[f].data[s]);
+        else
+            stage->free(pip->data[s]);
+    }
+    for (int f = 0; f < 2; f++) {
+        pipeline_frame_t* fra = &pip->frames[f];
+        free_ui8matrix(fra->IB, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        free_ui32matrix(fra->L1, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        if (fra->L2)
+            free_ui32matrix(fra->L2, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        features_free_RoIs(fra->RoIs_tmp);
+        features_free_RoIs(fra->RoIs);
+    }
+    if (pip->IS)
+        free_ui8matrix(pip->IS, pip->si0, pip->si1, pip->sj0, pip->sj1);
+    free(pip);
+}
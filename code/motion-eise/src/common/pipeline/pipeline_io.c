@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <nrc2.h>
+
+#include "motion/pipeline/pipeline_compute.h"
+#include "motion/pipeline/pipeline_io.h"
+
+#define PIPELINE_CKPT_MAGIC "MOTCKPT"
+#define PIPELINE_CKPT_VERSION 2
+
+static int _pipeline_read(void* ptr, const size_t size, FILE* f) {
+    if (size && fread(ptr, size, 1, f) != 1) {
+        fprintf(stderr, "(EE) the checkpoint is truncated\n");
+        return -1;
+    }
+    return 0;
+}
+
+void pipeline_checkpoint_write(FILE* f, const pipeline_t* pip) {
+    fwrite(PIPELINE_CKPT_MAGIC, 8, 1, f);
+    const int32_t header[8] = {PIPELINE_CKPT_VERSION, pip->p.i0, pip->p.i1, pip->p.j0, pip->p.j1, pip->p.sd_scale,
+                               pip->cur_fra, (int32_t)pip->n_dropped};
+    fwrite(header, sizeof(header), 1, f);
+    // the name of each selected stage, followed by its state (for the per frame stages, one state per frame)
+    for (int s = 0; s < PIP_N_STAGES; s++) {
+        const pipeline_stage_t* stage = pip->stages[s];
+        const uint8_t len = (uint8_t)strlen(stage->name), has_state = stage->save != NULL;
+        fwrite(&len, 1, 1, f);
+        fwrite(stage->name, len, 1, f);
+        fwrite(&has_state, 1, 1, f);
+        if (!has_state)
+            continue;
+        if (stage->per_frame)
+            for (int fr = 0; fr < 2; fr++)
+                stage->save(pip->frames[fr].data[s], f);
+        else
+            stage->save(pip->data[s], f);
+    }
+    for (int fr = 0; fr < 2; fr++) {
+        fwrite(&pip->frames[fr].n_RoIs, sizeof(uint32_t), 1, f);
+        fwrite(pip->frames[fr].RoIs, sizeof(RoI_t), pip->frames[fr].n_RoIs, f);
+    }
+}
+
+int pipeline_checkpoint_read(FILE* f, pipeline_t* pip) {
+    char magic[8];
+    int32_t header[8];
+    if (_pipeline_read(magic, sizeof(magic), f))
+        return -1;
+    if (memcmp(magic, PIPELINE_CKPT_MAGIC, 8)) {
+        fprintf(stderr, "(EE) the file is not a checkpoint of the processing chain\n");
+        return -1;
+    }
+    if (_pipeline_read(header, sizeof(header), f))
+        return -1;
+    if (header[0] != PIPELINE_CKPT_VERSION) {
+        fprintf(stderr, "(EE) the version of the checkpoint (%d) is not supported (%d)\n", header[0],
+                PIPELINE_CKPT_VERSION);
+        return -1;
+    }
+    if (header[1] != pip->p.i0 || header[2] != pip->p.i1 || header[3] != pip->p.j0 || header[4] != pip->p.j1 ||
+        header[5] != pip->p.sd_scale) {
+        fprintf(stderr, "(EE) the checkpoint has been written for %dx%d frames (sd-scale = %d) while the frames are "
+                "%dx%d (sd-scale = %d)\n", header[4] - header[3] + 1, header[2] - header[1] + 1, header[5],
+                pip->p.j1 - pip->p.j0 + 1, pip->p.i1 - pip->p.i0 + 1, pip->p.sd_scale);
+        return -1;
+    }
+    for (int s = 0; s < PIP_N_STAGES; s++) {
+        const pipeline_stage_t* stage = pip->stages[s];
+        uint8_t len, has_state;
+        char name[256];
+        if (_pipeline_read(&len, 1, f))
+            return -1;
+        if (_pipeline_read(name, len, f))
+            return -1;
+        name[len] = '\0';
+        if (_pipeline_read(&has_state, 1, f))
+            return -1;
+        if (has_state != (stage->load != NULL) || (has_state && strcmp(name, stage->name))) {
+            fprintf(stderr, "(EE) the checkpoint has been written with the '%s=%s' stage instead of '%s=%s'\n",
+                    pipeline_step_name(stage->step), name, pipeline_step_name(stage->step), stage->name);
+            return -1;
+        }
+        if (!has_state)
+            continue;
+        int err = 0;
+        if (stage->per_frame)
+            for (int fr = 0; fr < 2 && !err; fr++)
+                err = stage->load(pip->frames[fr].data[s], pip, &pip->frames[fr], f);
+        else
+            err = stage->load(pip->data[s], pip, &pip->frames[1], f);
+        if (err)
+            return -1;
+    }
+    for (int fr = 0; fr < 2; fr++) {
+        pipeline_frame_t* fra = &pip->frames[fr];
+        if (_pipeline_read(&fra->n_RoIs, sizeof(uint32_t), f))
+            return -1;
+        if (fra->n_RoIs > pip->p.cca_roi_max2) {
+            fprintf(stderr, "(EE) the checkpoint contains %u RoIs while '--cca-roi-max2' is %lu\n", fra->n_RoIs,
+                    (unsigned long)pip->p.cca_roi_max2);
+            return -1;
+        }
+        if (_pipeline_read(fra->RoIs, fra->n_RoIs * sizeof(RoI_t), f))
+            return -1;
+        // the same as `pipeline_init` for the buffers that are rebuilt by the next frame
+        zero_ui8matrix(fra->IB, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        zero_ui32matrix(fra->L1, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        if (fra->L2)
+            zero_ui32matrix(fra->L2, pip->si0, pip->si1, pip->sj0, pip->sj1);
+        fra->n_RoIs_tmp = 0;
+    }
+    pip->cur_fra = header[6];
+    pip->n_dropped = (uint32_t)header[7];
+    return 0;
+}
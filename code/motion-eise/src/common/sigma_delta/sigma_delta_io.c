@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "motion/sigma_delta/sigma_delta_io.h"
+
+static int _sigma_delta_read(void* ptr, const size_t size, FILE* f) {
+    if (fread(ptr, size, 1, f) != 1) {
+        fprintf(stderr, "(EE) the Sigma-Delta model of the checkpoint is truncated\n");
+        return -1;
+    }
+    return 0;
+}
+
+void sigma_delta_data_write(FILE* f, const sigma_delta_data_t* sd_data) {
+    const int32_t dims[4] = {sd_data->i0, sd_data->i1, sd_data->j0, sd_data->j1};
+    fwrite(dims, sizeof(dims), 1, f);
+    const size_t width = (size_t)(sd_data->j1 - sd_data->j0) + 1;
+    for (int i = sd_data->i0; i <= sd_data->i1; i++)
+        fwrite(&sd_data->M[i][sd_data->j0], width, 1, f);
+    for (int i = sd_data->i0; i <= sd_data->i1; i++)
+        fwrite(&sd_data->V[i][sd_data->j0], width, 1, f);
+}
+
+int sigma_delta_data_read(FILE* f, sigma_delta_data_t* sd_data) {
+    int32_t dims[4];
+    if (_sigma_delta_read(dims, sizeof(dims), f))
+        return -1;
+    if (dims[0] != sd_data->i0 || dims[1] != sd_data->i1 || dims[2] != sd_data->j0 || dims[3] != sd_data->j1) {
+        fprintf(stderr, "(EE) the Sigma-Delta model of the checkpoint is %dx%d while %dx%d is expected\n",
+                dims[3] - dims[2] + 1, dims[1] - dims[0] + 1, sd_data->j1 - sd_data->j0 + 1,
+                sd_data->i1 - sd_data->i0 + 1);
+        return -1;
+    }
+    const size_t width = (size_t)(sd_data->j1 - sd_data->j0) + 1;
+    for (int i = sd_data->i0; i <= sd_data->i1; i++)
+        if (_sigma_delta_read(&sd_data->M[i][sd_data->j0], width, f))
+            return -1;
+    for (int i = sd_data->i0; i <= sd_data->i1; i++)
+        if (_sigma_delta_read(&sd_data->V[i][sd_data->j0], width, f))
+            return -1;
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "motion/spsc_queue.h"
+
+spsc_queue_t* spsc_queue_alloc(const size_t capacity) {
+    spsc_queue_t* queue = (spsc_queue_t*)malloc(sizeof(spsc_queue_t));
+    if (!queue) {
+        fprintf(stderr, "(EE) 'spsc_queue_alloc' failed\n");
+        exit(1);
+    }
+    size_t cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+    queue->items = (void**)malloc(cap * sizeof(void*));
+    queue->_mask = cap - 1;
+    queue->head = 0;
+    queue->tail = 0;
+    return queue;
+}
+
+void spsc_queue_free(spsc_queue_t* queue) {
+    free(queue->items);
+    free(queue);
+}
+
+int spsc_queue_push(spsc_queue_t* queue, void* item) {
+    const size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    const size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (tail - head > queue->_mask)
+        return 0;
+    queue->items[tail & queue->_mask] = item;
+    // publish the item to the consumer
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int spsc_queue_pop(spsc_queue_t* queue, void** item) {
+    const size_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    const size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head == tail)
+        return 0;
+    *item = queue->items[head & queue->_mask];
+    // give the slot back to the producer
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+size_t spsc_queue_size(const spsc_queue_t* queue) {
+    const size_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    const size_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    return tail - head;
+}
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <nrc2.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "motion/macros.h"
+#include "motion/video/video_io.h"
+#include "motion/kNN/kNN_compute.h"
+#include "motion/pipeline/pipeline_compute.h"
+#include "motion/streams.h"
+
+static double _streams_now_us(void) {
+    TIME_POINT(now);
+    return t_now_us;
+}
+
+streams_t* streams_alloc_init(const char** paths, const size_t n_streams, const motion_params_t* params,
+                              const enum video_codec_e codec_type, const size_t n_workers, const size_t quantum) {
+    if (!n_streams || !n_workers || !quantum) {
+        fprintf(stderr, "(EE) 'streams_alloc_init' needs at least one stream, one worker and one frame per quantum\n");
+        exit(1);
+    }
+    streams_t* engine = (streams_t*)malloc(sizeof(streams_t));
+    if (!engine) {
+        fprintf(stderr, "(EE) 'streams_alloc_init' failed\n");
+        exit(1);
+    }
+    engine->n_streams = n_streams;
+    engine->n_workers = n_workers;
+    engine->quantum = quantum;
+    engine->n_running = n_streams;
+    engine->n_idle = 0;
+    engine->run_us = 0.;
+    pthread_mutex_init(&engine->mutex, NULL);
+    pthread_cond_init(&engine->cond, NULL);
+
+    // the k-NN matrices are lent by the workers: one set per worker instead of one per stream
+    motion_params_t stream_params = *params;
+    stream_params.chain.external |= 1 << PIP_KNN;
+    engine->streams = (stream_t*)calloc(n_streams, sizeof(stream_t));
+    for (size_t s = 0; s < n_streams; s++) {
+        stream_t* stream = &engine->streams[s];
+        stream->id = s;
+        stream->path = paths[s];
+        // one decoding thread per stream, the parallelism comes from the streams
+        stream->video = video_reader_alloc_init(paths[s], 0, 0, 0, VBUF_NONE, 1, codec_type, VCDC_HWACCEL_NONE, 0, 0,
+                                                NULL, &stream->i0, &stream->i1, &stream->j0, &stream->j1);
+        stream->img = ui8matrix(stream->i0, stream->i1, stream->j0, stream->j1);
+        stream_params.width = (stream->j1 - stream->j0) + 1;
+        stream_params.height = (stream->i1 - stream->i0) + 1;
+        stream->mp = motion_pipeline_create(&stream_params);
+        if (!stream->mp)
+            exit(1);
+    }
+
+    engine->workers = (streams_worker_t*)calloc(n_workers, sizeof(streams_worker_t));
+    for (size_t w = 0; w < n_workers; w++) {
+        streams_worker_t* worker = &engine->workers[w];
+        worker->id = w;
+        worker->engine = engine;
+        worker->queue = (stream_t**)malloc(n_streams * sizeof(stream_t*));
+        pthread_mutex_init(&worker->mutex, NULL);
+        worker->kNN_data = kNN_alloc_data(params->chain.cca_roi_max2);
+        kNN_init_data(worker->kNN_data);
+    }
+    return engine;
+}
+
+static void _streams_push(streams_worker_t* worker, stream_t* stream) {
+    stream->ready_us = _streams_now_us();
+    pthread_mutex_lock(&worker->mutex);
+    worker->queue[(worker->head + worker->size++) % worker->engine->n_streams] = stream;
+    pthread_mutex_unlock(&worker->mutex);
+}
+
+static streams_worker_t* _streams_shortest(streams_worker_t* worker) {
+    streams_t* engine = worker->engine;
+    streams_worker_t* shortest = worker;
+    size_t shortest_size = SIZE_MAX;
+    for (size_t w = 0; w < engine->n_workers; w++) {
+        streams_worker_t* cur = &engine->workers[(worker->id + w) % engine->n_workers];
+        pthread_mutex_lock(&cur->mutex);
+        const size_t size = cur->size;
+        pthread_mutex_unlock(&cur->mutex);
+        if (size < shortest_size) {
+            shortest = cur;
+            shortest_size = size;
+        }
+    }
+    return shortest;
+}
+
+// the oldest stream of the queue (FIFO order for the owner and for the thieves: the streams are scheduled in
+// round-robin and a thief takes the stream that waits for the longest time)
+static stream_t* _streams_pop(streams_worker_t* worker) {
+    stream_t* stream = NULL;
+    pthread_mutex_lock(&worker->mutex);
+    if (worker->size) {
+        stream = worker->queue[worker->head];
+        worker->head = (worker->head + 1) % worker->engine->n_streams;
+        worker->size--;
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    return stream;
+}
+
+static stream_t* _streams_find(streams_worker_t* worker) {
+    streams_t* engine = worker->engine;
+    stream_t* stream = _streams_pop(worker);
+    for (size_t w = 1; !stream && w < engine->n_workers; w++) {
+        stream = _streams_pop(&engine->workers[(worker->id + w) % engine->n_workers]);
+        if (stream) {
+            worker->n_steals++;
+            stream->n_stolen++;
+        }
+    }
+    return stream;
+}
+
+// wait for a stream to process, NULL means that all the streams are done
+static stream_t* _streams_wait(streams_worker_t* worker) {
+    streams_t* engine = worker->engine;
+    stream_t* stream = _streams_find(worker);
+    if (stream)
+        return stream;
+    pthread_mutex_lock(&engine->mutex);
+    engine->n_idle++;
+    // the queues are scanned again with `mutex` locked: a stream enqueued after this scan is signaled
+    while (engine->n_running && !(stream = _streams_find(worker)))
+        pthread_cond_wait(&engine->cond, &engine->mutex);
+    engine->n_idle--;
+    pthread_mutex_unlock(&engine->mutex);
+    return stream;
+}
+
+// process the next frame of a stream, return 0 at the end of the video
+static int _streams_step(streams_worker_t* worker, stream_t* stream) {
+    TIME_POINT(dec_b);
+    const uint8_t** view;
+    const int cur_fra = video_reader_get_frame_view(stream->video, stream->img, &view);
+    TIME_POINT(dec_e);
+    stream->dec_us += TIME_ELAPSED2_US(dec_b, dec_e);
+    if (cur_fra == -1)
+        return 0;
+    pipeline_set_data(stream->mp->pip, PIP_KNN, (void*)worker->kNN_data);
+    motion_pipeline_push_view(stream->mp, view, cur_fra);
+    TIME_POINT(proc_e);
+    stream->proc_us += TIME_ELAPSED2_US(dec_e, proc_e);
+    stream->n_frames++;
+    return 1;
+}
+
+static void* _streams_worker_thread(void* arg) {
+    streams_worker_t* worker = (streams_worker_t*)arg;
+    streams_t* engine = worker->engine;
+#ifdef _OPENMP
+    // the streams are the parallelism, the kernels stay sequential to not oversubscribe the cores
+    omp_set_num_threads(1);
+#endif
+    stream_t* stream;
+    while ((stream = _streams_wait(worker))) {
+        TIME_POINT(quantum_b);
+        stream->wait_us += t_quantum_b_us - stream->ready_us;
+        stream->n_quanta++;
+        for (size_t q = 0; q < engine->quantum && !stream->done; q++)
+            stream->done = !_streams_step(worker, stream);
+        TIME_POINT(quantum_e);
+        worker->busy_us += TIME_ELAPSED2_US(quantum_b, quantum_e);
+        worker->n_quanta++;
+
+        pthread_mutex_lock(&engine->mutex);
+        if (stream->done) {
+            if (!--engine->n_running)
+                pthread_cond_broadcast(&engine->cond);
+        } else {
+            // back at the end of the shortest queue (this worker first): the workers have the same share of streams
+            _streams_push(_streams_shortest(worker), stream);
+            if (engine->n_idle)
+                pthread_cond_signal(&engine->cond);
+        }
+        pthread_mutex_unlock(&engine->mutex);
+    }
+    return NULL;
+}
+
+void streams_run(streams_t* engine) {
+    for (size_t s = 0; s < engine->n_streams; s++)
+        if (!engine->streams[s].done)
+            _streams_push(&engine->workers[s % engine->n_workers], &engine->streams[s]);
+    TIME_POINT(run_b);
+    for (size_t w = 0; w < engine->n_workers; w++)
+        if (pthread_create(&engine->workers[w].thread, NULL, _streams_worker_thread, &engine->workers[w])) {
+            fprintf(stderr, "(EE) 'pthread_create' failed for the worker %lu\n", (unsigned long)w);
+            exit(1);
+        }
+    for (size_t w = 0; w < engine->n_workers; w++)
+        pthread_join(engine->workers[w].thread, NULL);
+    TIME_POINT(run_e);
+    engine->run_us = TIME_ELAPSED2_US(run_b, run_e);
+}
+
+void streams_stats_print(FILE* f, const streams_t* engine) {
+    const double run_s = engine->run_us * 1e-6;
+    fprintf(f, "# Streams statistics:\n");
+    fprintf(f, "# -----||--------|--------|----------|----------|----------|--------|--------\n");
+    fprintf(f, "#   Id || Frames |    FPS | Decoding |  Process |    Delay | Quanta | Stolen\n");
+    fprintf(f, "#      ||        |        |     (ms) |     (ms) |     (ms) |        |       \n");
+    fprintf(f, "# -----||--------|--------|----------|----------|----------|--------|--------\n");
+    for (size_t s = 0; s < engine->n_streams; s++) {
+        const stream_t* stream = &engine->streams[s];
+        const double n = stream->n_frames ? (double)stream->n_frames : 1.;
+        const double q = stream->n_quanta ? (double)stream->n_quanta : 1.;
+        fprintf(f, "# %4lu || %6lu | %6.1f | %8.3f | %8.3f | %8.3f | %6lu | %6lu\n", (unsigned long)stream->id,
+                (unsigned long)stream->n_frames, run_s > 0. ? stream->n_frames / run_s : 0., stream->dec_us * 1e-3 / n,
+                stream->proc_us * 1e-3 / n, stream->wait_us * 1e-3 / q, (unsigned long)stream->n_quanta,
+                (unsigned long)stream->n_stolen);
+    }
+    fprintf(f, "#\n");
+    fprintf(f, "# Workers statistics:\n");
+    fprintf(f, "# -----||--------|--------|--------\n");
+    fprintf(f, "#   Id || Quanta | Steals |   Busy\n");
+    fprintf(f, "# -----||--------|--------|--------\n");
+    for (size_t w = 0; w < engine->n_workers; w++) {
+        const streams_worker_t* worker = &engine->workers[w];
+        fprintf(f, "# %4lu || %6lu | %6lu | %5.1f%%\n", (unsigned long)worker->id, (unsigned long)worker->n_quanta,
+                (unsigned long)worker->n_steals, engine->run_us > 0. ? 100. * worker->busy_us / engine->run_us : 0.);
+    }
+}
+
+void streams_free(streams_t* engine) {
+    for (size_t s = 0; s < engine->n_streams; s++) {
+        stream_t* stream = &engine->streams[s];
+        motion_pipeline_free(stream->mp);
+        free_ui8matrix(stream->img, stream->i0, stream->i1, stream->j0, stream->j1);
+        video_reader_free(stream->video);
+    }
+    for (size_t w = 0; w < engine->n_workers; w++) {
+        streams_worker_t* worker = &engine->workers[w];
+        kNN_free_data(worker->kNN_data);
+        pthread_mutex_destroy(&worker->mutex);
+        free(worker->queue);
+    }
+    pthread_mutex_destroy(&engine->mutex);
+    pthread_cond_destroy(&engine->cond);
+    free(engine->streams);
+    free(engine->workers);
+    free(engine);
+}
@@ -54,6 +54,9 @@ tracking_data_t* tracking_alloc_data(const size_t max_history_size, const size_t
     tracking_data->tracks = (vec_track_t)vector_create();
     tracking_data->history = alloc_history(max_history_size, max_RoIs_size);
     tracking_data->RoIs_list = (RoI4track_t*)malloc(max_history_size * sizeof(RoI4track_t));
+    tracking_data->RoIs_id_pool = tracking_RoIs_id_pool_alloc(256);
+    tracking_data->_max_proposals = 0;
+    tracking_data->proposals = NULL;
     return tracking_data;
 }
 
@@ -68,19 +71,17 @@ void tracking_init_data(tracking_data_t* tracking_data) {
 }
 
 void tracking_free_data(tracking_data_t* tracking_data) {
-    int vs = vector_size(tracking_data->tracks);
-    for (int t = 0; t < vs; t++)
-        if (tracking_data->tracks[t].RoIs_id != NULL)
-            vector_free(tracking_data->tracks[t].RoIs_id);
     vector_free(tracking_data->tracks);
+    tracking_RoIs_id_pool_free(tracking_data->RoIs_id_pool);
+    free(tracking_data->proposals);
     free_history(tracking_data->history);
     free(tracking_data->RoIs_list);
     free(tracking_data);
 }
 
 // Returns 0 if no RoI matches or returns the RoI id found (RoI id >= 1)
-size_t _find_matching_RoI(const History_t* history, const track_t* cur_track, const size_t r_extrapol,
-                          const float min_extrapol_ratio_S) {
+size_t _find_matching_RoI(const History_t* history, const track_t* cur_track, const uint32_t fra_gap,
+                          const size_t r_extrapol, const float min_extrapol_ratio_S) {
     for (size_t j = 0; j < history->n_RoIs[0]; j++) {
         if (!history->RoIs[0][j].r.prev_id && !history->RoIs[0][j].is_extrapolated) {
             float x0_0 = history->RoIs[0][j].r.x;
@@ -90,15 +91,16 @@ size_t _find_matching_RoI(const History_t* history, const track_t* cur_track, co
             float x1_0 = cur_track->extrapol_x1;
             float y1_0 = cur_track->extrapol_y1;
 
-            float x_diff = x0_0 - (x1_0 + cur_track->extrapol_dx);
-            float y_diff = y0_0 - (y1_0 + cur_track->extrapol_dy);
+            // the velocity is per frame, the search radius grows with the number of dropped frames
+            float x_diff = x0_0 - (x1_0 + cur_track->extrapol_dx * fra_gap);
+            float y_diff = y0_0 - (y1_0 + cur_track->extrapol_dy * fra_gap);
             float dist = sqrtf(x_diff * x_diff + y_diff * y_diff);
 
             float ratio_S_ij = cur_track->end.r.S < history->RoIs[0][j].r.S ?
                                (float)cur_track->end.r.S / (float)history->RoIs[0][j].r.S :
                                (float)history->RoIs[0][j].r.S / (float)cur_track->end.r.S;
 
-            if (dist < r_extrapol && ratio_S_ij >= min_extrapol_ratio_S) {
+            if (dist < r_extrapol * fra_gap && ratio_S_ij >= min_extrapol_ratio_S) {
                 // in the current implementation, the first RoI that matches is used for extrapolation
                 // TODO: this behavior is dangerous, we should associate the closest RoI
                 return j + 1;
@@ -108,7 +110,7 @@ size_t _find_matching_RoI(const History_t* history, const track_t* cur_track, co
     return 0;
 }
 
-void _track_extrapolate(const History_t* history, track_t* cur_track) {
+void _track_extrapolate(const History_t* history, track_t* cur_track, const uint32_t fra_gap) {
     float x1_1 = cur_track->extrapol_x1;
     float y1_1 = cur_track->extrapol_y1;
 
@@ -120,11 +122,11 @@ void _track_extrapolate(const History_t* history, track_t* cur_track) {
     cur_track->extrapol_y2 = y1_1;
 
     // extrapolate x0 and y0 @ t
-    cur_track->extrapol_x1 = x1_0 + cur_track->extrapol_dx;
-    cur_track->extrapol_y1 = y1_0 + cur_track->extrapol_dy;
+    cur_track->extrapol_x1 = x1_0 + cur_track->extrapol_dx * fra_gap;
+    cur_track->extrapol_y1 = y1_0 + cur_track->extrapol_dy * fra_gap;
 }
 
-void _update_extrapol_vars(const History_t* history, track_t* cur_track) {
+void _update_extrapol_vars(const History_t* history, track_t* cur_track, const uint32_t fra_gap) {
     float x2_1 = cur_track->extrapol_x1;
     float y2_1 = cur_track->extrapol_y1;
 
@@ -135,8 +137,8 @@ void _update_extrapol_vars(const History_t* history, track_t* cur_track) {
     float x1_0 = cur_track->end.r.x;
     float y1_0 = cur_track->end.r.y;
 
-    cur_track->extrapol_dx = x1_0 - x2_0;
-    cur_track->extrapol_dy = y1_0 - y2_0;
+    cur_track->extrapol_dx = (x1_0 - x2_0) / fra_gap;
+    cur_track->extrapol_dy = (y1_0 - y2_0) / fra_gap;
 
     // for tracking @ t + 1
     cur_track->extrapol_x2 = cur_track->extrapol_x1;
@@ -145,65 +147,75 @@ void _update_extrapol_vars(const History_t* history, track_t* cur_track) {
     cur_track->extrapol_y1 = cur_track->end.r.y;
 }
 
-void _update_existing_tracks(History_t* history, vec_track_t track_array, const size_t frame, const size_t r_extrapol,
-                             const uint8_t extrapol_order_max, const float min_extrapol_ratio_S) {
-    size_t n_tracks = vector_size(track_array);
-    for (size_t i = 0; i < n_tracks; i++) {
+// Computes the candidate RoI (at t) of a track: the k-NN association if any, the first extrapolation match otherwise
+void _propose_RoI(const History_t* history, const track_t* cur_track, const uint32_t fra_gap, const size_t r_extrapol,
+                  const float min_extrapol_ratio_S, track_proposal_t* proposal) {
+    if (cur_track->state == STATE_UPDATED) {
+        uint32_t next_id = history->RoIs[1][cur_track->end.r.id - 1].r.next_id;
+        if (next_id) {
+            proposal->RoI_id = next_id;
+            proposal->is_knn = 1;
+            return;
+        }
+    }
+    proposal->RoI_id = (uint32_t)_find_matching_RoI(history, cur_track, fra_gap, r_extrapol, min_extrapol_ratio_S);
+    proposal->is_knn = 0;
+}
+
+void _update_existing_tracks(History_t* history, RoIs_id_pool_t* RoIs_id_pool, vec_track_t track_array,
+                             track_proposal_t* proposals, const size_t frame, const uint32_t fra_gap,
+                             const size_t r_extrapol, const uint8_t extrapol_order_max,
+                             const float min_extrapol_ratio_S) {
+    const int n_tracks = (int)vector_size(track_array);
+
+    // all the live tracks propose a RoI in parallel (`history` is read only here)
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < n_tracks; i++)
+        if (track_array[i].id && track_array[i].state != STATE_FINISHED)
+            _propose_RoI(history, &track_array[i], fra_gap, r_extrapol, min_extrapol_ratio_S, &proposals[i]);
+
+    for (int i = 0; i < n_tracks; i++) {
         track_t* cur_track = &track_array[i];
         if (cur_track->id && cur_track->state != STATE_FINISHED) {
-            if (cur_track->state == STATE_LOST) {
-                size_t RoI_id = _find_matching_RoI(history, cur_track, r_extrapol, min_extrapol_ratio_S);
-                if (RoI_id) {
-                    cur_track->state = STATE_UPDATED;
+            uint32_t RoI_id = proposals[i].RoI_id;
+            // the tracks are resolved in order: if a previous track already took the extrapolated RoI, the search is
+            // done again without it (it is the rare case), then the associations are the same as in a sequential run
+            if (RoI_id && !proposals[i].is_knn && history->RoIs[0][RoI_id - 1].is_extrapolated)
+                RoI_id = (uint32_t)_find_matching_RoI(history, cur_track, fra_gap, r_extrapol, min_extrapol_ratio_S);
+            if (RoI_id) {
+                // no RoI id when the RoI has been extrapolated or when the frame has been dropped
+                if (cur_track->RoIs_id.head != NULL)
+                    for (uint32_t e = cur_track->extrapol_order + fra_gap - 1; e >= 1; e--)
+                        tracking_RoIs_id_add(RoIs_id_pool, &cur_track->RoIs_id, (uint32_t)0);
+                if (!proposals[i].is_knn)
                     history->RoIs[0][RoI_id - 1].is_extrapolated = 1;
-                    memcpy(&cur_track->end, &history->RoIs[0][RoI_id - 1], sizeof(RoI4track_t));
-                    _update_extrapol_vars(history, cur_track);
-
-                    if (cur_track->RoIs_id != NULL) {
-                        // no RoI id when the RoI has been extrapolated
-                        for (uint8_t e = cur_track->extrapol_order; e >= 1; e--)
-                            vector_add(&cur_track->RoIs_id, (uint32_t)0);
-                        vector_add(&cur_track->RoIs_id, history->RoIs[0][RoI_id - 1].r.id);
-                    }
-                    cur_track->extrapol_order = 0;
-                }
-            }
-            else if (cur_track->state == STATE_UPDATED) {
-                int next_id = history->RoIs[1][cur_track->end.r.id - 1].r.next_id;
-                if (next_id) {
-                    memcpy(&cur_track->end, &history->RoIs[0][next_id - 1], sizeof(RoI4track_t));
-                    _update_extrapol_vars(history, cur_track);
-                    if (cur_track->RoIs_id != NULL)
-                        vector_add(&cur_track->RoIs_id, history->RoIs[0][next_id - 1].r.id);
-                } else {
-                    size_t RoI_id = _find_matching_RoI(history, cur_track, r_extrapol, min_extrapol_ratio_S);
-                    if (RoI_id) {
-                        history->RoIs[0][RoI_id - 1].is_extrapolated = 1;
-                        memcpy(&cur_track->end, &history->RoIs[0][RoI_id - 1], sizeof(RoI4track_t));
-                        _update_extrapol_vars(history, cur_track);
-
-                        if (cur_track->RoIs_id != NULL)
-                            vector_add(&cur_track->RoIs_id, history->RoIs[0][RoI_id - 1].r.id);
-                    } else {
-                        cur_track->state = STATE_LOST;
-                    }
-                }
+                cur_track->state = STATE_UPDATED;
+                memcpy(&cur_track->end, &history->RoIs[0][RoI_id - 1], sizeof(RoI4track_t));
+                _update_extrapol_vars(history, cur_track, fra_gap);
+                if (cur_track->RoIs_id.head != NULL)
+                    tracking_RoIs_id_add(RoIs_id_pool, &cur_track->RoIs_id, history->RoIs[0][RoI_id - 1].r.id);
+                cur_track->extrapol_order = 0;
+            } else {
+                cur_track->state = STATE_LOST;
             }
             if (cur_track->state == STATE_LOST) {
-                cur_track->extrapol_order++;
-                if (cur_track->extrapol_order > extrapol_order_max) {
+                // the track has been lost for `fra_gap` more frames (dropped ones included)
+                const uint32_t extrapol_order = cur_track->extrapol_order + fra_gap;
+                if (extrapol_order > extrapol_order_max) {
+                    cur_track->extrapol_order = (uint8_t)MIN(extrapol_order, UINT8_MAX);
                     cur_track->state = STATE_FINISHED;
                 } else {
+                    cur_track->extrapol_order = (uint8_t)extrapol_order;
                     // extrapolate if the state is not finished
-                    _track_extrapolate(history, cur_track);
+                    _track_extrapolate(history, cur_track, fra_gap);
                 }
             }
         }
     }
 }
 
-void _insert_new_track(const RoI4track_t* RoIs_list, const unsigned n_RoIs, vec_track_t* track_array, const int frame,
-                       const uint8_t save_RoIs_id) {
+void _insert_new_track(const RoI4track_t* RoIs_list, const unsigned n_RoIs, RoIs_id_pool_t* RoIs_id_pool,
+                       vec_track_t* track_array, const int frame, const uint8_t save_RoIs_id) {
     assert(n_RoIs >= 1);
 
     size_t track_id = vector_size(*track_array) + 1;
@@ -212,7 +224,9 @@ void _insert_new_track(const RoI4track_t* RoIs_list, const unsigned n_RoIs, vec_
     memcpy(&tmp_track->begin, &RoIs_list[n_RoIs - 1], sizeof(RoI4track_t));
     memcpy(&tmp_track->end, &RoIs_list[0], sizeof(RoI4track_t));
     tmp_track->state = STATE_UPDATED;
-    tmp_track->RoIs_id = NULL;
+    tmp_track->RoIs_id.head = NULL;
+    tmp_track->RoIs_id.tail = NULL;
+    tmp_track->RoIs_id.size = 0;
     tmp_track->extrapol_x2 = RoIs_list[1].r.x;
     tmp_track->extrapol_y2 = RoIs_list[1].r.y;
     tmp_track->extrapol_x1 = RoIs_list[0].r.x;
@@ -220,16 +234,15 @@ void _insert_new_track(const RoI4track_t* RoIs_list, const unsigned n_RoIs, vec_
     tmp_track->extrapol_dx = NAN; // this will be properly initialized later in "_update_existing_tracks"
     tmp_track->extrapol_dy = NAN; // this will be properly initialized later in "_update_existing_tracks"
     tmp_track->extrapol_order = 0;
-    if (save_RoIs_id) {
-        tmp_track->RoIs_id = (vec_uint32_t)vector_create();
+    if (save_RoIs_id)
         for (unsigned n = 0; n < n_RoIs; n++)
-            vector_add(&tmp_track->RoIs_id, RoIs_list[(n_RoIs - 1) - n].r.id);
-    }
+            tracking_RoIs_id_add(RoIs_id_pool, &tmp_track->RoIs_id, RoIs_list[(n_RoIs - 1) - n].r.id);
     tmp_track = NULL; // stop using temp now that the element is initialized
 }
 
-void _create_new_tracks(History_t* history, RoI4track_t* RoIs_list, vec_track_t* track_array, const size_t frame,
-                        const size_t fra_obj_min, const uint8_t save_RoIs_id) {
+void _create_new_tracks(History_t* history, RoI4track_t* RoIs_list, RoIs_id_pool_t* RoIs_id_pool,
+                        vec_track_t* track_array, const size_t frame, const size_t fra_obj_min,
+                        const uint8_t save_RoIs_id) {
     for (size_t i = 0; i < history->n_RoIs[1]; i++) {
         int asso = history->RoIs[1][i].r.next_id;
         if (asso) {
@@ -255,7 +268,7 @@ void _create_new_tracks(History_t* history, RoI4track_t* RoIs_list, vec_track_t*
                         memcpy(&RoIs_list[ii], &history->RoIs[ii + 1][RoIs_list[ii - 1].r.prev_id - 1],
                                sizeof(RoI4track_t));
 
-                     _insert_new_track(RoIs_list, fra_min - 1, track_array, frame, save_RoIs_id);
+                     _insert_new_track(RoIs_list, fra_min - 1, RoIs_id_pool, track_array, frame, save_RoIs_id);
                 }
             }
         }
@@ -279,8 +292,8 @@ void _update_RoIs_next_id(const RoI_t* RoIs, RoI4track_t* RoIs_dst, const size_t
 }
 
 void tracking_perform(tracking_data_t* tracking_data, const RoI_t* RoIs, const size_t n_RoIs, const size_t frame,
-                      const size_t r_extrapol, const size_t fra_obj_min, const uint8_t save_RoIs_id,
-                      const uint8_t extrapol_order_max, const float min_extrapol_ratio_S) {
+                      const uint32_t fra_gap, const size_t r_extrapol, const size_t fra_obj_min,
+                      const uint8_t save_RoIs_id, const uint8_t extrapol_order_max, const float min_extrapol_ratio_S) {
     assert(extrapol_order_max < tracking_data->history->_max_size);
     assert(min_extrapol_ratio_S >= 0.f && min_extrapol_ratio_S <= 1.f);
 
@@ -293,13 +306,30 @@ void tracking_perform(tracking_data_t* tracking_data, const RoI_t* RoIs, const s
         tracking_data->history->_size++;
 
     if (tracking_data->history->_size >= 2) {
-        _create_new_tracks(tracking_data->history, tracking_data->RoIs_list, &tracking_data->tracks, frame,
-                           fra_obj_min, save_RoIs_id);
-        _update_existing_tracks(tracking_data->history, tracking_data->tracks, frame, r_extrapol,
-                                extrapol_order_max, min_extrapol_ratio_S);
+        _create_new_tracks(tracking_data->history, tracking_data->RoIs_list, tracking_data->RoIs_id_pool,
+                           &tracking_data->tracks, frame, fra_obj_min, save_RoIs_id);
+        size_t n_tracks = vector_size(tracking_data->tracks);
+        if (n_tracks > tracking_data->_max_proposals) {
+            tracking_data->_max_proposals = vector_get_alloc(tracking_data->tracks);
+            tracking_data->proposals = (track_proposal_t*)realloc(tracking_data->proposals,
+                                                                  tracking_data->_max_proposals *
+                                                                  sizeof(track_proposal_t));
+        }
+        _update_existing_tracks(tracking_data->history, tracking_data->RoIs_id_pool, tracking_data->tracks,
+                                tracking_data->proposals, frame, fra_gap, r_extrapol, extrapol_order_max,
+                                min_extrapol_ratio_S);
     }
 
     rotate_history(tracking_data->history);
     memset(tracking_data->history->RoIs[0], 0, tracking_data->history->n_RoIs[0] * sizeof(RoI4track_t));
     tracking_data->history->n_RoIs[0] = 0;
 }
+
+void tracking_release_RoIs_id(tracking_data_t* tracking_data, const uint32_t frame_min) {
+    size_t n_tracks = vector_size(tracking_data->tracks);
+    for (size_t t = 0; t < n_tracks; t++) {
+        track_t* cur_track = &tracking_data->tracks[t];
+        if (cur_track->state == STATE_FINISHED && cur_track->RoIs_id.head != NULL && cur_track->end.frame < frame_min)
+            tracking_RoIs_id_release(tracking_data->RoIs_id_pool, &cur_track->RoIs_id);
+    }
+}
@@ -3,8 +3,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "vec.h"
+#include "motion/macros.h"
 #include "motion/tracking/tracking_io.h"
 
 void tracking_tracks_write(FILE* f, const vec_track_t tracks) {
@@ -76,11 +78,110 @@ void tracking_tracks_RoIs_id_write(FILE* f, const vec_track_t tracks) {
     for (size_t i = 0; i < n_tracks; i++)
         if (tracks[i].id) {
             fprintf(f, " %5d %s ", tracks[i].id, "object");
-            if (tracks[i].RoIs_id != NULL) {
-                size_t vs = vector_size(tracks[i].RoIs_id);
-                for (size_t j = 0; j < vs; j++)
-                    fprintf(f, " %5u ", tracks[i].RoIs_id[j]);
+            if (tracks[i].RoIs_id.head != NULL) {
+                const RoIs_id_chunk_t* chunk = tracks[i].RoIs_id.head;
+                for (size_t j = 0; j < tracks[i].RoIs_id.size; j++) {
+                    fprintf(f, " %5u ", chunk->ids[j % TRACKING_RoIs_ID_CHUNK_SIZE]);
+                    if ((j + 1) % TRACKING_RoIs_ID_CHUNK_SIZE == 0)
+                        chunk = chunk->next;
+                }
                 fprintf(f, "\n");
             }
         }
 }
+
+static int _tracking_read(void* ptr, const size_t size, FILE* f) {
+    if (size && fread(ptr, size, 1, f) != 1) {
+        fprintf(stderr, "(EE) the tracking state of the checkpoint is truncated\n");
+        return -1;
+    }
+    return 0;
+}
+
+void tracking_data_write(FILE* f, const tracking_data_t* tracking_data) {
+    const History_t* history = tracking_data->history;
+    const uint64_t header[5] = {sizeof(RoI4track_t), sizeof(track_t), history->_max_size, history->_max_n_RoIs,
+                                history->_size};
+    fwrite(header, sizeof(header), 1, f);
+    for (size_t h = 0; h < history->_max_size; h++) {
+        fwrite(&history->n_RoIs[h], sizeof(uint32_t), 1, f);
+        fwrite(history->RoIs[h], sizeof(RoI4track_t), history->n_RoIs[h], f);
+    }
+
+    const uint64_t n_tracks = vector_size(tracking_data->tracks);
+    fwrite(&n_tracks, sizeof(n_tracks), 1, f);
+    for (size_t t = 0; t < n_tracks; t++) {
+        const track_t* track = &tracking_data->tracks[t];
+        fwrite(track, sizeof(track_t), 1, f); // the RoI ids list pointers are meaningless, they are rebuilt
+        const uint64_t n_ids = track->RoIs_id.size;
+        fwrite(&n_ids, sizeof(n_ids), 1, f);
+        size_t n = 0;
+        for (const RoIs_id_chunk_t* chunk = track->RoIs_id.head; chunk; chunk = chunk->next) {
+            const size_t n_chunk = MIN(n_ids - n, (size_t)TRACKING_RoIs_ID_CHUNK_SIZE);
+            fwrite(chunk->ids, sizeof(uint32_t), n_chunk, f);
+            n += n_chunk;
+        }
+    }
+}
+
+int tracking_data_read(FILE* f, tracking_data_t* tracking_data) {
+    History_t* history = tracking_data->history;
+    uint64_t header[5];
+    if (_tracking_read(header, sizeof(header), f))
+        return -1;
+    if (header[0] != sizeof(RoI4track_t) || header[1] != sizeof(track_t)) {
+        fprintf(stderr, "(EE) the tracking state of the checkpoint has been written by an incompatible build\n");
+        return -1;
+    }
+    if (header[2] != history->_max_size || header[3] != history->_max_n_RoIs || header[4] > history->_max_size) {
+        fprintf(stderr, "(EE) the tracking history of the checkpoint (%lu frames of %lu RoIs) does not match the "
+                "current one (%lu frames of %lu RoIs), check '--trk-obj-min', '--trk-ext-o' and '--cca-roi-max2'\n",
+                (unsigned long)header[2], (unsigned long)header[3], (unsigned long)history->_max_size,
+                (unsigned long)history->_max_n_RoIs);
+        return -1;
+    }
+    history->_size = header[4];
+    for (size_t h = 0; h < history->_max_size; h++) {
+        if (_tracking_read(&history->n_RoIs[h], sizeof(uint32_t), f))
+            return -1;
+        if (history->n_RoIs[h] > history->_max_n_RoIs) {
+            fprintf(stderr, "(EE) the tracking history of the checkpoint is corrupted\n");
+            history->n_RoIs[h] = 0;
+            return -1;
+        }
+        memset(history->RoIs[h], 0, history->_max_n_RoIs * sizeof(RoI4track_t));
+        if (_tracking_read(history->RoIs[h], history->n_RoIs[h] * sizeof(RoI4track_t), f))
+            return -1;
+    }
+
+    // the current tracks are replaced, their RoI ids go back to the pool
+    size_t n_tracks = vector_size(tracking_data->tracks);
+    for (size_t t = 0; t < n_tracks; t++)
+        tracking_RoIs_id_release(tracking_data->RoIs_id_pool, &tracking_data->tracks[t].RoIs_id);
+    vector_free(tracking_data->tracks);
+    tracking_data->tracks = (vec_track_t)vector_create();
+    uint64_t n_tracks_ckpt;
+    if (_tracking_read(&n_tracks_ckpt, sizeof(n_tracks_ckpt), f))
+        return -1;
+    for (size_t t = 0; t < n_tracks_ckpt; t++) {
+        // read aside: after an error, the added tracks hold valid RoI ids lists (they can be released)
+        track_t track_ckpt;
+        if (_tracking_read(&track_ckpt, sizeof(track_t), f))
+            return -1;
+        track_t* track = vector_add_asg(&tracking_data->tracks);
+        *track = track_ckpt;
+        track->RoIs_id.head = NULL;
+        track->RoIs_id.tail = NULL;
+        track->RoIs_id.size = 0;
+        uint64_t n_ids;
+        if (_tracking_read(&n_ids, sizeof(n_ids), f))
+            return -1;
+        for (size_t i = 0; i < n_ids; i++) {
+            uint32_t id;
+            if (_tracking_read(&id, sizeof(id), f))
+                return -1;
+            tracking_RoIs_id_add(tracking_data->RoIs_id_pool, &track->RoIs_id, id);
+        }
+    }
+    return 0;
+}
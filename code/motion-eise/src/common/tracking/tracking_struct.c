@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <assert.h>
 
 #include "vec.h"
 
@@ -21,3 +22,104 @@ size_t tracking_count_objects(const vec_track_t tracks) {
             real_n_tracks++;
     return real_n_tracks;
 }
+
+RoIs_id_pool_t* tracking_RoIs_id_pool_alloc(const size_t slab_n_chunks) {
+    assert(slab_n_chunks > 0);
+    RoIs_id_pool_t* pool = (RoIs_id_pool_t*)malloc(sizeof(RoIs_id_pool_t));
+    pool->slabs = (RoIs_id_chunk_t**)vector_create();
+    pool->free_list = NULL;
+    pool->slab_n_chunks = slab_n_chunks;
+    pool->n_chunks = 0;
+    pool->n_free_chunks = 0;
+    pool->n_ids = 0;
+    return pool;
+}
+
+void tracking_RoIs_id_pool_free(RoIs_id_pool_t* pool) {
+    size_t n_slabs = vector_size(pool->slabs);
+    for (size_t s = 0; s < n_slabs; s++)
+        free(pool->slabs[s]);
+    vector_free(pool->slabs);
+    free(pool);
+}
+
+static RoIs_id_chunk_t* _tracking_RoIs_id_pool_get_chunk(RoIs_id_pool_t* pool) {
+    if (pool->free_list == NULL) {
+        RoIs_id_chunk_t* slab = (RoIs_id_chunk_t*)malloc(pool->slab_n_chunks * sizeof(RoIs_id_chunk_t));
+        if (!slab) {
+            fprintf(stderr, "(EE) can't allocate a new slab of RoI ids chunks\n");
+            exit(1);
+        }
+        vector_add(&pool->slabs, slab);
+        for (size_t c = 0; c < pool->slab_n_chunks; c++)
+            slab[c].next = (c + 1 < pool->slab_n_chunks) ? &slab[c + 1] : NULL;
+        pool->free_list = slab;
+        pool->n_chunks += pool->slab_n_chunks;
+        pool->n_free_chunks += pool->slab_n_chunks;
+    }
+    RoIs_id_chunk_t* chunk = pool->free_list;
+    pool->free_list = chunk->next;
+    pool->n_free_chunks--;
+    chunk->prev = NULL;
+    chunk->next = NULL;
+    return chunk;
+}
+
+void tracking_RoIs_id_add(RoIs_id_pool_t* pool, RoIs_id_list_t* list, const uint32_t id) {
+    const size_t pos = list->size % TRACKING_RoIs_ID_CHUNK_SIZE;
+    if (pos == 0) {
+        RoIs_id_chunk_t* chunk = _tracking_RoIs_id_pool_get_chunk(pool);
+        chunk->prev = list->tail;
+        if (list->tail)
+            list->tail->next = chunk;
+        else
+            list->head = chunk;
+        list->tail = chunk;
+    }
+    list->tail->ids[pos] = id;
+    list->size++;
+    pool->n_ids++;
+}
+
+uint32_t tracking_RoIs_id_get(const RoIs_id_list_t* list, const size_t pos) {
+    assert(pos < list->size);
+    const size_t chunk_id = pos / TRACKING_RoIs_ID_CHUNK_SIZE;
+    const size_t n_chunks = (list->size + TRACKING_RoIs_ID_CHUNK_SIZE - 1) / TRACKING_RoIs_ID_CHUNK_SIZE;
+    const RoIs_id_chunk_t* chunk;
+    if (chunk_id >= n_chunks / 2) {
+        chunk = list->tail;
+        for (size_t c = n_chunks - 1; c > chunk_id; c--)
+            chunk = chunk->prev;
+    } else {
+        chunk = list->head;
+        for (size_t c = 0; c < chunk_id; c++)
+            chunk = chunk->next;
+    }
+    return chunk->ids[pos % TRACKING_RoIs_ID_CHUNK_SIZE];
+}
+
+void tracking_RoIs_id_release(RoIs_id_pool_t* pool, RoIs_id_list_t* list) {
+    if (list->head == NULL)
+        return;
+    size_t n_chunks = 0;
+    for (RoIs_id_chunk_t* chunk = list->head; chunk != NULL; chunk = chunk->next)
+        n_chunks++;
+    // the whole list is spliced at the beginning of the free list
+    list->tail->next = pool->free_list;
+    pool->free_list = list->head;
+    pool->n_free_chunks += n_chunks;
+    pool->n_ids -= list->size;
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+}
+
+size_t tracking_RoIs_id_pool_footprint(const RoIs_id_pool_t* pool) {
+    return pool->n_chunks * sizeof(RoIs_id_chunk_t) + vector_get_alloc(pool->slabs) * sizeof(RoIs_id_chunk_t*) +
+           sizeof(RoIs_id_pool_t);
+}
+
+float tracking_RoIs_id_pool_fragmentation(const RoIs_id_pool_t* pool) {
+    const size_t n_slots = pool->n_chunks * TRACKING_RoIs_ID_CHUNK_SIZE;
+    return n_slots ? 1.f - (float)pool->n_ids / (float)n_slots : 0.f;
+}
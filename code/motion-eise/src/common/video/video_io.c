@@ -2,11 +2,229 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <ctype.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 #include <nrc2.h>
 
+#include "motion/macros.h"
 #include "motion/video/video_io.h"
 
-#define MAX_BUFF_SIZE 16384
+// Minimum number of unchanged bytes to end a run of literals (a shorter run costs more than it saves)
+#define ZBUF_MIN_RUN 8
+
+static size_t _zbuf_put_varint(uint8_t* out, size_t v) {
+    size_t o = 0;
+    while (v >= 0x80) {
+        out[o++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[o++] = (uint8_t)v;
+    return o;
+}
+
+static size_t _zbuf_get_varint(const uint8_t* in, size_t* v) {
+    size_t i = 0, shift = 0;
+    *v = 0;
+    do {
+        *v |= (size_t)(in[i] & 0x7F) << shift;
+        shift += 7;
+    } while (in[i++] & 0x80);
+    return i;
+}
+
+// Upper bound of the compressed size of a `n` bytes frame
+static size_t _zbuf_bound(const size_t n) {
+    return n + (n / ZBUF_MIN_RUN + 1) * 2 * 10;
+}
+
+// Codes `cur` as the byte-wise difference with `ref` (the values themselves when `ref` is NULL): the output is a list
+// of (number of unchanged bytes, number of literals, literals) triplets, the numbers are varints
+static size_t _zbuf_encode(const uint8_t* ref, const uint8_t* cur, const size_t n, uint8_t* out) {
+    size_t i = 0, o = 0;
+    while (i < n) {
+        size_t same = i;
+        while (same < n && cur[same] == (ref ? ref[same] : 0))
+            same++;
+        size_t lit = same, zeros = 0;
+        while (lit < n) {
+            if (cur[lit] == (ref ? ref[lit] : 0)) {
+                if (++zeros == ZBUF_MIN_RUN) {
+                    lit -= ZBUF_MIN_RUN - 1;
+                    break;
+                }
+            } else
+                zeros = 0;
+            lit++;
+        }
+        o += _zbuf_put_varint(out + o, same - i);
+        o += _zbuf_put_varint(out + o, lit - same);
+        for (size_t k = same; k < lit; k++)
+            out[o++] = (uint8_t)(cur[k] - (ref ? ref[k] : 0));
+        i = lit;
+    }
+    return o;
+}
+
+static void _zbuf_decode(const uint8_t* ref, const uint8_t* in, const size_t n, uint8_t* out) {
+    size_t i = 0, p = 0;
+    while (i < n) {
+        size_t n_same, n_lit;
+        p += _zbuf_get_varint(in + p, &n_same);
+        p += _zbuf_get_varint(in + p, &n_lit);
+        if (ref)
+            memcpy(out + i, ref + i, n_same);
+        else
+            memset(out + i, 0, n_same);
+        i += n_same;
+        if (ref)
+            for (size_t k = 0; k < n_lit; k++)
+                out[i + k] = (uint8_t)(ref[i + k] + in[p + k]);
+        else
+            memcpy(out + i, in + p, n_lit);
+        i += n_lit;
+        p += n_lit;
+    }
+}
+
+// Decodes the whole video sequence in memory, the buffer grows as needed (no fixed limit on the number of frames).
+// With `VBUF_DELTA_RLE` each frame is stored as its difference with the previous one (see `_zbuf_encode`)
+static void _video_reader_bufferize(video_reader_t* video, int (*get_frame)(video_reader_t*, uint8_t**),
+                                    const int bufferize, const int i0, const int i1, const int j0, const int j1) {
+    size_t capacity = 64;
+    uint8_t*** fra_buffer = NULL;
+    video_zbuffer_t* zbuf = NULL;
+    uint8_t** prev = NULL;
+    uint8_t* scratch = NULL;
+    const size_t fsize = (size_t)(i1 - i0 + 1) * (j1 - j0 + 1);
+    if (bufferize == VBUF_DELTA_RLE) {
+        zbuf = (video_zbuffer_t*)calloc(1, sizeof(video_zbuffer_t));
+        zbuf->frames = (uint8_t**)malloc(capacity * sizeof(uint8_t*));
+        zbuf->sizes = (size_t*)malloc(capacity * sizeof(size_t));
+        zbuf->width = (unsigned)(j1 - j0 + 1);
+        zbuf->height = (unsigned)(i1 - i0 + 1);
+        zbuf->i0 = i0;
+        zbuf->j0 = j0;
+        for (int r = 0; r < 2; r++)
+            zbuf->ref[r] = ui8matrix(i0, i1, j0, j1);
+        prev = ui8matrix(i0, i1, j0, j1);
+        scratch = (uint8_t*)malloc(_zbuf_bound(fsize));
+    } else
+        fra_buffer = (uint8_t***)malloc(capacity * sizeof(uint8_t**));
+    int frame_id;
+    do {
+        uint8_t **I = zbuf ? zbuf->ref[0] : ui8matrix(i0, i1, j0, j1);
+        // `video->fra_count` is incremented by `get_frame`
+        frame_id = get_frame(video, I);
+        if (frame_id != -1) {
+            if (video->fra_count > capacity) {
+                capacity *= 2;
+                if (zbuf) {
+                    zbuf->frames = (uint8_t**)realloc(zbuf->frames, capacity * sizeof(uint8_t*));
+                    zbuf->sizes = (size_t*)realloc(zbuf->sizes, capacity * sizeof(size_t));
+                } else
+                    fra_buffer = (uint8_t***)realloc(fra_buffer, capacity * sizeof(uint8_t**));
+            }
+            if (zbuf) {
+                // `ui8matrix` rows are contiguous
+                const size_t f = video->fra_count - 1;
+                const size_t zsize = _zbuf_encode(f ? prev[i0] + j0 : NULL, I[i0] + j0, fsize, scratch);
+                zbuf->frames[f] = (uint8_t*)malloc(zsize);
+                memcpy(zbuf->frames[f], scratch, zsize);
+                zbuf->sizes[f] = zsize;
+                zbuf->raw_size += fsize;
+                zbuf->zip_size += zsize;
+                memcpy(prev[i0] + j0, I[i0] + j0, fsize);
+            } else
+                fra_buffer[video->fra_count -1] = I;
+        } else if (!zbuf)
+            free_ui8matrix(I, i0, i1, j0, j1);
+    } while (frame_id != -1);
+    if (zbuf) {
+        free_ui8matrix(prev, i0, i1, j0, j1);
+        free(scratch);
+        zbuf->cur = 0;
+        zbuf->last = 0;
+    }
+    video->fra_buffer = fra_buffer;
+    video->fra_zbuffer = zbuf;
+    video->frame_current = 0;
+    video->cur_loop = 1;
+}
+
+static int _video_reader_is_buffered(const video_reader_t* video) {
+    return video->fra_buffer != NULL || video->fra_zbuffer != NULL;
+}
+
+static void _video_reader_buffer_free(video_reader_t* video, const int i0, const int i1, const int j0, const int j1) {
+    if (video->fra_buffer) {
+        for (size_t i = 0; i < video->fra_count; i++)
+            free_ui8matrix(video->fra_buffer[i], i0, i1, j0, j1);
+        free(video->fra_buffer);
+    }
+    video_zbuffer_t* zbuf = video->fra_zbuffer;
+    if (zbuf) {
+        for (size_t i = 0; i < video->fra_count; i++)
+            free(zbuf->frames[i]);
+        for (int r = 0; r < 2; r++)
+            free_ui8matrix(zbuf->ref[r], i0, i1, j0, j1);
+        free(zbuf->frames);
+        free(zbuf->sizes);
+        free(zbuf);
+    }
+}
+
+// Frame number of a buffered/cached frame (same numbering as the frames decoded on the fly)
+static int _video_reader_buffered_next(video_reader_t* video, size_t* fra_id) {
+    if (video->frame_current < video->fra_count || video->cur_loop < video->loop_size) {
+        if (video->frame_current == video->fra_count) {
+            video->cur_loop++;
+            video->frame_current = 0;
+        }
+        *fra_id = video->frame_current;
+        int cur_fra = video->frame_start + (video->frame_current + (video->cur_loop -1) * video->fra_count) *
+                      (1 + video->frame_skip);
+        video->frame_current++;
+        return cur_fra;
+    }
+    return -1;
+}
+
+// Next buffered frame as a view: the raw frames are given without copy, the compressed frames are decoded in turn in
+// the two `ref` frames of the buffer (the views of the frames at t and t - 1 remain valid)
+static int _video_reader_buffered_view(video_reader_t* video, const uint8_t*** view) {
+    size_t f;
+    int cur_fra = _video_reader_buffered_next(video, &f);
+    if (cur_fra == -1)
+        return -1;
+    if (video->fra_buffer) {
+        *view = (const uint8_t**)video->fra_buffer[f];
+        return cur_fra;
+    }
+    video_zbuffer_t* zbuf = video->fra_zbuffer;
+    TIME_POINT(unzip_b);
+    const int next = zbuf->cur ^ 1;
+    // the frames are read in order, the first one is coded without reference (restart of a loop)
+    assert(f == 0 || f == zbuf->last + 1);
+    const size_t fsize = (size_t)zbuf->width * zbuf->height;
+    // same base as in `_video_reader_bufferize` (`ui8matrix` rows are contiguous from `[i0] + j0`)
+    _zbuf_decode(f ? zbuf->ref[zbuf->cur][zbuf->i0] + zbuf->j0 : NULL, zbuf->frames[f], fsize,
+                 zbuf->ref[next][zbuf->i0] + zbuf->j0);
+    zbuf->cur = next;
+    zbuf->last = f;
+    *view = (const uint8_t**)zbuf->ref[next];
+    TIME_POINT(unzip_e);
+    zbuf->decode_us += TIME_ELAPSED2_US(unzip_b, unzip_e);
+    zbuf->n_decoded++;
+    return cur_fra;
+}
 
 #if MOTION_USE_FFMPEG_IO
 
@@ -21,6 +239,16 @@ typedef struct {
     char hwaccel[2048]; /*!< Hardware acceleration string. */
 } video_metadata_ffio_t;
 
+int video_reader_ffio_get_frame(video_reader_t* video, uint8_t** img);
+
+int video_reader_ffio_probe(const char* path) {
+    ffmpeg_options ffmpeg_opts;
+    ffmpeg_handle ffmpeg;
+    ffmpeg_options_init(&ffmpeg_opts);
+    ffmpeg_init(&ffmpeg);
+    return ffmpeg_probe(&ffmpeg, path, &ffmpeg_opts) != 0;
+}
+
 video_reader_t* video_reader_ffio_alloc_init(const char* path, const size_t start, const size_t end, const size_t skip,
                                              const int bufferize, const size_t n_ffmpeg_threads,
                                              const enum video_codec_hwaccel_e hwaccel, int* i0, int* i1, int* j0,
@@ -43,8 +271,10 @@ video_reader_t* video_reader_ffio_alloc_init(const char* path, const size_t star
         metadata->ffmpeg_opts.threads_input = n_ffmpeg_threads;
     if (start)
         metadata->ffmpeg_opts.start_number = start;
+    // the skipped frames are dropped by ffmpeg: they are not converted nor sent through the pipe
+    metadata->ffmpeg_opts.frame_step = 1 + skip;
     if (end)
-        metadata->ffmpeg_opts.vframes = (end - start) + 1;
+        metadata->ffmpeg_opts.vframes = (end - start) / (1 + skip) + 1;
 
     switch(hwaccel) {
         case VCDC_HWACCEL_VIDEOTOOLBOX:
@@ -82,34 +312,14 @@ video_reader_t* video_reader_ffio_alloc_init(const char* path, const size_t star
     *j1 = metadata->ffmpeg.input.width - 1;
 
     video->fra_buffer = NULL;
+    video->fra_zbuffer = NULL;
     video->fra_count = 0;
 
     video->cur_loop = 1;
     video->loop_size = 1;
 
-    int frame_id = 0;
-    if (bufferize) {
-        uint8_t*** fra_buffer_tmp;
-        fra_buffer_tmp = (uint8_t***)malloc(MAX_BUFF_SIZE * sizeof(uint8_t***));
-        do {
-            if (video->fra_count >= MAX_BUFF_SIZE) {
-                fprintf(stderr, "(EE) 'video->fra_count' has to be smaller than 'MAX_BUFF_SIZE' "
-                                "('video->fra_count' = %d, 'MAX_BUFF_SIZE' = %d\n)", (int)video->fra_count,
-                                (int)MAX_BUFF_SIZE);
-                exit(-1);
-            }
-            uint8_t **I = ui8matrix(*i0, *i1, *j0, *j1);
-            frame_id = video_reader_get_frame(video, I);
-            if (frame_id != -1) {
-                fra_buffer_tmp[video->fra_count -1] = I;
-            } else
-                free_ui8matrix(I, *i0, *i1, *j0, *j1);
-        } while (frame_id != -1);
-
-        video->fra_buffer = fra_buffer_tmp;
-        video->frame_current = 0;
-        video->cur_loop = 1;
-    }
+    if (bufferize)
+        _video_reader_bufferize(video, video_reader_ffio_get_frame, bufferize, *i0, *i1, *j0, *j1);
 
     return video;
 }
@@ -126,8 +336,9 @@ static int _video_reader_ffio_get_frame(video_reader_t* video, uint8_t** img) {
         return -1;
     }
 
+    // the frames between two read frames have been dropped by ffmpeg
     int cur_fra = (int)video->frame_current;
-    video->frame_current++;
+    video->frame_current += metadata->ffmpeg_opts.frame_step;
     return cur_fra;
 }
 
@@ -135,54 +346,49 @@ int video_reader_ffio_get_frame(video_reader_t* video, uint8_t** img) {
     assert(video->codec_type == VCDC_FFMPEG_IO);
     video_metadata_ffio_t* metadata = (video_metadata_ffio_t*)video->metadata;
 retry:
-    if (video->fra_buffer == NULL) {
-        int r;
-        size_t skip = video->frame_current == 0 ? 0 : video->frame_skip;
-        do {
-            r = _video_reader_ffio_get_frame(video, img);
-            // restart reader
-            if (r == -1 && video->cur_loop < video->loop_size) {
-                video->cur_loop++;
-                video->frame_current = 0;
-                ffmpeg_stop_reader(&metadata->ffmpeg);
-                if (!ffmpeg_start_reader(&metadata->ffmpeg, video->path, &metadata->ffmpeg_opts)) {
-                    fprintf(stderr, "(EE) can't open file %s\n", video->path);
-                    exit(1);
-                }
-                goto retry;
+    if (!_video_reader_is_buffered(video)) {
+        // no frame to skip here (see `frame_step`)
+        int r = _video_reader_ffio_get_frame(video, img);
+        // restart reader
+        if (r == -1 && video->cur_loop < video->loop_size) {
+            video->cur_loop++;
+            video->frame_current = 0;
+            ffmpeg_stop_reader(&metadata->ffmpeg);
+            if (!ffmpeg_start_reader(&metadata->ffmpeg, video->path, &metadata->ffmpeg_opts)) {
+                fprintf(stderr, "(EE) can't open file %s\n", video->path);
+                exit(1);
             }
-        } while ((r != -1) && skip--);
+            goto retry;
+        }
         if (video->cur_loop == 1 && r != -1)
             video->fra_count++;
         return (r == -1) ? r : video->frame_start + r + (video->cur_loop -1) * video->fra_count *
                                (1 + video->frame_skip);
     } else {
-        if (video->frame_current < video->fra_count || video->cur_loop < video->loop_size) {
-            if (video->frame_current == video->fra_count) {
-                video->cur_loop++;
-                video->frame_current = 0;
-            }
+        const uint8_t** view;
+        int cur_fra = _video_reader_buffered_view(video, &view);
+        if (cur_fra != -1)
             for (unsigned l = 0; l < metadata->ffmpeg.input.height; l++)
-                memcpy(img[l], video->fra_buffer[video->frame_current][l], metadata->ffmpeg.input.width);
-            int cur_fra = video->frame_start + (video->frame_current + (video->cur_loop -1) * video->fra_count) *
-                          (1 + video->frame_skip);
-            video->frame_current++;
-            return cur_fra;
-        } else
-            return -1;
+                memcpy(img[l], view[l], metadata->ffmpeg.input.width);
+        return cur_fra;
+    }
+}
+
+int video_reader_ffio_get_frame_view(video_reader_t* video, uint8_t** img, const uint8_t*** view) {
+    assert(video->codec_type == VCDC_FFMPEG_IO);
+    if (!_video_reader_is_buffered(video)) {
+        *view = (const uint8_t**)img;
+        return video_reader_ffio_get_frame(video, img);
     }
+    // buffered frames are given without copy
+    return _video_reader_buffered_view(video, view);
 }
 
 void video_reader_ffio_free(video_reader_t* video) {
     assert(video->codec_type == VCDC_FFMPEG_IO);
     video_metadata_ffio_t* metadata = (video_metadata_ffio_t*)video->metadata;
     ffmpeg_stop_reader(&metadata->ffmpeg);
-    if (video->fra_buffer) {
-        for (size_t i = 0; i < video->fra_count; i++)
-            free_ui8matrix(video->fra_buffer[i], 0, metadata->ffmpeg.input.height - 1, 0,
-                           metadata->ffmpeg.input.width - 1);
-        free(video->fra_buffer);
-    }
+    _video_reader_buffer_free(video, 0, metadata->ffmpeg.input.height - 1, 0, metadata->ffmpeg.input.width - 1);
     free(metadata);
     free(video);
 }
@@ -223,6 +429,10 @@ video_writer_t* video_writer_ffio_alloc_init(const char* path, const size_t star
 
     video->codec_type = VCDC_FFMPEG_IO;
     video->win_play = win_play;
+    video->img_height = img_height;
+    video->img_width = img_width;
+    video->pixfmt = pixfmt;
+    video->async = NULL;
     video_metadata_ffio_t* metadata = (video_metadata_ffio_t*)malloc(sizeof(video_metadata_ffio_t));
     video->metadata = (void*)metadata;
 
@@ -279,16 +489,149 @@ void video_writer_ffio_free(video_writer_t* video) {
 
 #if MOTION_USE_VCODECS_IO
 
-#include <vcodecs-io/vcodecs-io.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+#ifdef __cplusplus
+}
+#endif
 
 typedef struct {
-    vcio_options_t vcio_opts;
-    vcio_reader_t reader;
+    AVFormatContext* fmt_ctx; /*!< Demuxer. */
+    AVCodecContext* dec_ctx; /*!< Decoder. */
+    int stream_id; /*!< Index of the decoded video stream. */
+    AVPacket* pkt; /*!< Last demuxed packet. */
+    AVFrame* decoded; /*!< Decoded frame when a conversion to gray is required. */
+    AVFrame* frames[2]; /*!< Two last frames exposed to the caller (the two last views remain valid). */
+    const uint8_t** rows[2]; /*!< Row pointers on the luma planes of `frames` (views given to the caller). */
+    int cur; /*!< Index in `frames` of the last exposed frame. */
+    struct SwsContext* sws; /*!< Conversion to `AV_PIX_FMT_GRAY8`, NULL when the luma plane is used directly. */
+    int eof; /*!< Boolean, 1 when the demuxer has reached the end of the file (the decoder is drained). */
+    int first_read; /*!< Boolean, 1 when the first packet of the video stream has been demuxed. */
+    int64_t first_ts; /*!< Decoding (or presentation) timestamp of the first packet, `AV_NOPTS_VALUE` if unknown. */
+    unsigned width; /*!< Frames width. */
+    unsigned height; /*!< Frames height. */
 } video_metadata_vcio_t;
 
-static int _video_reader_vcio_get_frame(video_reader_t* video, uint8_t** img);
 int video_reader_vcio_get_frame(video_reader_t* video, uint8_t** img);
 
+// 8-bit luma (or gray) in the first plane, one byte per pixel: the plane can be exposed without conversion
+static int _vcio_is_luma_usable(const enum AVPixelFormat pix_fmt) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(pix_fmt);
+    return desc && !(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_HWACCEL)) &&
+           desc->comp[0].plane == 0 && desc->comp[0].step == 1 && desc->comp[0].depth == 8 &&
+           desc->comp[0].shift == 0;
+}
+
+// Returns 1 if a frame has been decoded in `frame`, 0 at the end of the stream and -1 on error
+static int _vcio_decode(video_metadata_vcio_t* metadata, AVFrame* frame) {
+    while (1) {
+        int ret = avcodec_receive_frame(metadata->dec_ctx, frame);
+        if (ret == 0)
+            return 1;
+        if (ret == AVERROR_EOF)
+            return 0;
+        if (ret != AVERROR(EAGAIN))
+            return -1;
+
+        ret = av_read_frame(metadata->fmt_ctx, metadata->pkt);
+        if (ret < 0) {
+            if (metadata->eof)
+                return 0;
+            // end of the file: drain the decoder
+            metadata->eof = 1;
+            avcodec_send_packet(metadata->dec_ctx, NULL);
+            continue;
+        }
+        if (metadata->pkt->stream_index == metadata->stream_id) {
+            if (!metadata->first_read) {
+                metadata->first_read = 1;
+                metadata->first_ts = metadata->pkt->dts != AV_NOPTS_VALUE ? metadata->pkt->dts : metadata->pkt->pts;
+            }
+            ret = avcodec_send_packet(metadata->dec_ctx, metadata->pkt);
+        }
+        av_packet_unref(metadata->pkt);
+        if (ret < 0 && ret != AVERROR(EAGAIN))
+            return -1;
+    }
+}
+
+// Decodes the next frame in the next `frames` slot and updates its row pointers, the previous view is kept valid
+static int _vcio_decode_next(video_metadata_vcio_t* metadata) {
+    const int next = metadata->cur ^ 1;
+    AVFrame* out = metadata->frames[next];
+    int ret;
+    if (metadata->sws) {
+        ret = _vcio_decode(metadata, metadata->decoded);
+        if (ret == 1) {
+            sws_scale(metadata->sws, (const uint8_t* const*)metadata->decoded->data, metadata->decoded->linesize, 0,
+                      metadata->height, out->data, out->linesize);
+            av_frame_unref(metadata->decoded);
+        }
+    } else {
+        av_frame_unref(out);
+        ret = _vcio_decode(metadata, out);
+    }
+    if (ret == 1) {
+        for (unsigned l = 0; l < metadata->height; l++)
+            metadata->rows[next][l] = out->data[0] + (size_t)l * out->linesize[0];
+        metadata->cur = next;
+    }
+    return ret;
+}
+
+// Decodes the next frame without conversion (frame skipped by the caller), the exposed frames are left untouched
+static int _vcio_drop_next(video_metadata_vcio_t* metadata) {
+    int ret = _vcio_decode(metadata, metadata->decoded);
+    if (ret == 1)
+        av_frame_unref(metadata->decoded);
+    return ret;
+}
+
+// Goes back to the first frame of the file and drops the frames before `frame_start`
+static int _vcio_rewind(video_reader_t* video, const int seek) {
+    video_metadata_vcio_t* metadata = (video_metadata_vcio_t*)video->metadata;
+    if (seek) {
+        // a seek to 0 fails when the timestamps start later, and `start_time` is a presentation time: with B-frames
+        // the first packet is before it (MPEG-TS seeks on the decoding times). Then the seek targets the timestamp of
+        // the first packet, or the first byte when the packets have no timestamp (raw streams)
+        int ret = -1;
+        if (metadata->first_ts != AV_NOPTS_VALUE)
+            ret = avformat_seek_file(metadata->fmt_ctx, metadata->stream_id, INT64_MIN, metadata->first_ts,
+                                     metadata->first_ts, 0);
+        if (ret < 0)
+            ret = av_seek_frame(metadata->fmt_ctx, metadata->stream_id, 0, AVSEEK_FLAG_BYTE);
+        if (ret < 0)
+            return 0;
+        avcodec_flush_buffers(metadata->dec_ctx);
+        metadata->eof = 0;
+    }
+    for (size_t f = 0; f < video->frame_start; f++)
+        if (_vcio_drop_next(metadata) != 1)
+            return 0;
+    return 1;
+}
+
+int video_reader_vcio_probe(const char* path) {
+    AVFormatContext* fmt_ctx = NULL;
+    if (avformat_open_input(&fmt_ctx, path, NULL, NULL) < 0)
+        return 0;
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+    const AVCodec* codec = NULL;
+#else
+    AVCodec* codec = NULL;
+#endif
+    // same checks as in `video_reader_vcio_alloc_init`: a video stream and its decoder are required
+    const int is_valid = avformat_find_stream_info(fmt_ctx, NULL) >= 0 &&
+                         av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0) >= 0;
+    avformat_close_input(&fmt_ctx);
+    return is_valid;
+}
+
 video_reader_t* video_reader_vcio_alloc_init(const char* path, const size_t start, const size_t end, const size_t skip,
                                              const int bufferize, const size_t n_ffmpeg_threads,
                                              const enum video_codec_hwaccel_e hwaccel, int* i0, int* i1, int* j0,
@@ -305,254 +648,1737 @@ video_reader_t* video_reader_vcio_alloc_init(const char* path, const size_t star
         exit(1);
     }
 
-    // Dead code...
-    // enum AVHWDeviceType av_hwaccel;
-    // switch (hwaccel) {
-    //     case VCDC_HWACCEL_NVDEC:
-    //         av_hwaccel = AV_HWDEVICE_TYPE_CUDA;
-    //         break;
-    //     case VCDC_HWACCEL_VIDEOTOOLBOX:
-    //         av_hwaccel = AV_HWDEVICE_TYPE_VIDEOTOOLBOX;
-    //         break;
-    //     default: // VCDC_HWACCEL_NONE
-    //         av_hwaccel = AV_HWDEVICE_TYPE_NONE;
-    //         break;
-    // }
-    
     snprintf(video->path, sizeof(video->path), "%s", path);
 
     video->codec_type = VCDC_VCODECS_IO;
-    video_metadata_vcio_t* metadata = (video_metadata_vcio_t*)malloc(sizeof(video_metadata_vcio_t));
+    video_metadata_vcio_t* metadata = (video_metadata_vcio_t*)calloc(1, sizeof(video_metadata_vcio_t));
     video->metadata = (void*)metadata;
+    metadata->first_ts = AV_NOPTS_VALUE;
 
-    vcio_options_init(&metadata->vcio_opts);
-    if (n_ffmpeg_threads) {
-        metadata->vcio_opts.thread_count = n_ffmpeg_threads;
+    if (avformat_open_input(&metadata->fmt_ctx, video->path, NULL, NULL) < 0 ||
+        avformat_find_stream_info(metadata->fmt_ctx, NULL) < 0) {
+        fprintf(stderr, "(EE) can't open file %s\n", video->path);
+        exit(1);
     }
-    if (start) {
-        metadata->vcio_opts.start_number = start;
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+    const AVCodec* codec = NULL;
+#else
+    AVCodec* codec = NULL;
+#endif
+    metadata->stream_id = av_find_best_stream(metadata->fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (metadata->stream_id < 0) {
+        fprintf(stderr, "(EE) can't find a video stream in %s\n", video->path);
+        exit(1);
     }
-    if (end) {
-        metadata->vcio_opts.vframes = (end - start) + 1; // currently unused by vcio (it's mostly synchronous)
+    metadata->dec_ctx = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(metadata->dec_ctx, metadata->fmt_ctx->streams[metadata->stream_id]->codecpar);
+    // 0 lets libavcodec decide
+    metadata->dec_ctx->thread_count = (int)n_ffmpeg_threads;
+    metadata->dec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    if (avcodec_open2(metadata->dec_ctx, codec, NULL) < 0) {
+        fprintf(stderr, "(EE) can't open the decoder for %s\n", video->path);
+        exit(1);
     }
 
-    int status = vcio_reader_alloc(&metadata->reader, video->path, &metadata->vcio_opts);
-    if (status < 0) {
-        fprintf(stderr, "(EE) can't open file %s\n", video->path);
-        free(video);
-        exit(1);
+    metadata->width = (unsigned)metadata->dec_ctx->width;
+    metadata->height = (unsigned)metadata->dec_ctx->height;
+    metadata->pkt = av_packet_alloc();
+    metadata->decoded = av_frame_alloc();
+    for (int f = 0; f < 2; f++) {
+        metadata->frames[f] = av_frame_alloc();
+        metadata->rows[f] = (const uint8_t**)malloc(metadata->height * sizeof(uint8_t*));
+    }
+    metadata->cur = 1;
+    if (!_vcio_is_luma_usable(metadata->dec_ctx->pix_fmt)) {
+        metadata->sws = sws_getContext(metadata->width, metadata->height, metadata->dec_ctx->pix_fmt,
+                                       metadata->width, metadata->height, AV_PIX_FMT_GRAY8, SWS_BILINEAR, NULL, NULL,
+                                       NULL);
+        for (int f = 0; f < 2; f++) {
+            metadata->frames[f]->format = AV_PIX_FMT_GRAY8;
+            metadata->frames[f]->width = metadata->width;
+            metadata->frames[f]->height = metadata->height;
+            if (!metadata->sws || av_frame_get_buffer(metadata->frames[f], 0) < 0) {
+                fprintf(stderr, "(EE) can't convert %s frames to grayscale\n", video->path);
+                exit(1);
+            }
+        }
     }
 
     video->frame_start = start;
     video->frame_end = end;
     video->frame_skip = skip;
     video->frame_current = 0;
-    // Implicit pix format
+
+    if (!_vcio_rewind(video, 0)) {
+        fprintf(stderr, "(EE) can't read file %s\n", video->path);
+        exit(1);
+    }
 
     *i0 = 0;
     *j0 = 0;
-    *i1 = metadata->reader.height - 1;
-    *j1 = metadata->reader.width - 1;
+    *i1 = metadata->height - 1;
+    *j1 = metadata->width - 1;
 
     video->fra_buffer = NULL;
+    video->fra_zbuffer = NULL;
     video->fra_count = 0;
 
     video->cur_loop = 1;
     video->loop_size = 1;
 
-    int frame_id = 0;
-    if (bufferize) {
-        fprintf(stdout, "Bufferizing image sequence\n");
-        uint8_t*** fra_buffer_tmp;
-        fra_buffer_tmp = (uint8_t***)malloc(MAX_BUFF_SIZE * sizeof(uint8_t***));
-        do {
-            if (video->fra_count >= MAX_BUFF_SIZE) {
-                fprintf(stderr, "(EE) 'video->fra_count' has to be smaller than 'MAX_BUFF_SIZE' "
-                                "('video->fra_count' = %d, 'MAX_BUFF_SIZE' = %d\n)", (int)video->fra_count,
-                                (int)MAX_BUFF_SIZE);
-                exit(-1);
-            }
-            uint8_t **I = ui8matrix(*i0, *i1, *j0, *j1);
-            frame_id = video_reader_vcio_get_frame(video, I);
-            if (frame_id != -1) {
-                fra_buffer_tmp[video->fra_count -1] = I;
-            } else
-                free_ui8matrix(I, *i0, *i1, *j0, *j1);
-        } while (frame_id != -1);
-        video->fra_buffer = fra_buffer_tmp;
-        video->frame_current = 0;
-        video->cur_loop = 1;
-    }
+    if (bufferize)
+        _video_reader_bufferize(video, video_reader_vcio_get_frame, bufferize, *i0, *i1, *j0, *j1);
 
     return video;
 }
 
-static int _video_reader_vcio_get_frame(video_reader_t* video, uint8_t** img) {
+// `view` is NULL for a skipped frame: the frame is decoded (the next frames may depend on it) but not converted
+static int _video_reader_vcio_get_frame(video_reader_t* video, const uint8_t*** view) {
     video_metadata_vcio_t* metadata = (video_metadata_vcio_t*)video->metadata;
-    if (video->frame_end && video->frame_start + video->frame_current > video->frame_end) {
-        fprintf(stdout, "End of video sequence");
+    if (video->frame_end && video->frame_start + video->frame_current > video->frame_end)
         return -1;
-    }
 
-    int status = vcio_read2d(&metadata->reader, img);
-    if (status <= 0) {
-        if (status < 0) // 0 == EOF
-            //fprintf(stderr, "(EE) %s\n", ffmpeg_error2str(video->ffmpeg.error));
+    int status = view ? _vcio_decode_next(metadata) : _vcio_drop_next(metadata);
+    if (status != 1) {
+        if (status < 0)
             fprintf(stderr, "(EE) Could not read frame\n");
         return -1;
     }
+    if (view)
+        *view = metadata->rows[metadata->cur];
 
     int cur_fra = (int)video->frame_current;
     video->frame_current++;
     return cur_fra;
 }
 
-int video_reader_vcio_get_frame(video_reader_t* video, uint8_t** img) {
+int video_reader_vcio_get_frame_view(video_reader_t* video, const uint8_t*** view) {
     assert(video->codec_type == VCDC_VCODECS_IO);
-    video_metadata_vcio_t* metadata = (video_metadata_vcio_t*)video->metadata;
-    retry:
-    if (video->fra_buffer == NULL) { // Not bufferized
+retry:
+    if (!_video_reader_is_buffered(video)) { // Not bufferized
+        int r;
         size_t skip = video->frame_current == 0 ? 0 : video->frame_skip;
-        int status;
-        int cur_fra = 0;
         do {
-            status = _video_reader_vcio_get_frame(video, img);
-
+            r = _video_reader_vcio_get_frame(video, skip ? NULL : view);
             // restart reader
-            if (status < 0 && video->cur_loop < video->loop_size) {
+            if (r == -1 && video->cur_loop < video->loop_size) {
                 video->cur_loop++;
                 video->frame_current = 0;
-
-                vcio_reader_seek(&metadata->reader, video->frame_start, 0);
+                if (!_vcio_rewind(video, 1)) {
+                    fprintf(stderr, "(EE) can't rewind file %s\n", video->path);
+                    exit(1);
+                }
                 goto retry;
             }
-        } while ((status != -1) && skip--);
-
-        if (video->cur_loop == 1 && status >= 0) {
+        } while ((r != -1) && skip--);
+        if (video->cur_loop == 1 && r != -1)
             video->fra_count++;
-        }
-        return (status < 0) ? status : video->frame_start + cur_fra + (video->cur_loop) * video->fra_count
-            * (1 + video->frame_skip);
-    } else {
-        if (video->frame_current < video->fra_count || video->cur_loop < video->loop_size) {
-            if (video->frame_current == video->fra_count) {
-                video->cur_loop++;
-                video->frame_current = 0;
-            }
-            for (unsigned l = 0; l < metadata->reader.height; l++)
-                memcpy(img[l], video->fra_buffer[video->frame_current][l], metadata->reader.width);
-            int cur_fra = video->frame_start + (video->frame_current + (video->cur_loop -1) * video->fra_count) *
-                (1 + video->frame_skip);
-            video->frame_current++;
-            return cur_fra;
-        } else
-            return -1;
-    }
+        return (r == -1) ? r : video->frame_start + r + (video->cur_loop -1) * video->fra_count *
+                               (1 + video->frame_skip);
+    } else
+        return _video_reader_buffered_view(video, view);
+}
+
+int video_reader_vcio_get_frame(video_reader_t* video, uint8_t** img) {
+    video_metadata_vcio_t* metadata = (video_metadata_vcio_t*)video->metadata;
+    const uint8_t** view;
+    int r = video_reader_vcio_get_frame_view(video, &view);
+    if (r != -1)
+        for (unsigned l = 0; l < metadata->height; l++)
+            memcpy(img[l], view[l], metadata->width);
+    return r;
 }
 
 void video_reader_vcio_free(video_reader_t* video) {
     assert(video->codec_type == VCDC_VCODECS_IO);
     video_metadata_vcio_t* metadata = (video_metadata_vcio_t*)video->metadata;
-    vcio_reader_free(&metadata->reader);
-    if (video->fra_buffer) {
-        for (size_t i = 0; i < video->fra_count; i++)
-            free_ui8matrix(video->fra_buffer[i], 0, metadata->reader.height - 1, 0, metadata->reader.width - 1);
-        free(video->fra_buffer);
+    _video_reader_buffer_free(video, 0, metadata->height - 1, 0, metadata->width - 1);
+    for (int f = 0; f < 2; f++) {
+        av_frame_free(&metadata->frames[f]);
+        free(metadata->rows[f]);
     }
+    av_frame_free(&metadata->decoded);
+    av_packet_free(&metadata->pkt);
+    sws_freeContext(metadata->sws);
+    avcodec_free_context(&metadata->dec_ctx);
+    avformat_close_input(&metadata->fmt_ctx);
     free(metadata);
     free(video);
 }
 
 #endif
 
-// ----------------------------------------------------------------------------
-// ----------------------------------------------------------------------------
+// Formats read by the native decoder
+enum native_format_e { NATIVE_RAW = 0, NATIVE_Y4M, NATIVE_PGM_SEQ };
 
-video_reader_t* video_reader_alloc_init(const char* path, const size_t start, const size_t end, const size_t skip,
-                                        const int bufferize, const size_t n_ffmpeg_threads,
-                                        const enum video_codec_e codec_type, const enum video_codec_hwaccel_e hwaccel,
-                                        int* i0, int* i1, int* j0, int* j1) {
-    switch (codec_type) {
-        case VCDC_FFMPEG_IO: {
-#ifdef MOTION_USE_FFMPEG_IO
-            return video_reader_ffio_alloc_init(path, start, end, skip, bufferize, n_ffmpeg_threads, hwaccel, i0, i1, j0, j1);
-            break;
-#else
-            fprintf(stderr, "(EE) Link with the ffmpeg-io library is required.\n");
-            exit(-1);
-#endif
-        }
-        case VCDC_VCODECS_IO: {
-#ifdef MOTION_USE_VCODECS_IO
-            return video_reader_vcio_alloc_init(path, start, end, skip, bufferize, n_ffmpeg_threads, hwaccel, i0, i1, j0, j1);
+typedef struct {
+    enum native_format_e format; /*!< Input format. */
+    unsigned width; /*!< Frames width. */
+    unsigned height; /*!< Frames height. */
+    size_t chroma_size; /*!< Size in bytes of the chroma planes following each luma plane (Y4M only). */
+    uint8_t* map; /*!< Memory-mapped input file (NULL when the input is a stream). */
+    size_t map_size; /*!< Size in bytes of `map`. */
+    size_t offset; /*!< Current position in `map`. */
+    size_t data_offset; /*!< Position of the first frame in `map` (after the Y4M stream header). */
+    FILE* stream; /*!< Input stream when the input can't be mapped (pipe), NULL otherwise. */
+    uint8_t* chroma; /*!< Buffer to drop the chroma planes and the skipped frames from `stream`. */
+    uint8_t** img[2]; /*!< Frames read from `stream` (the two last frames remain valid). */
+    uint8_t* pgm_maps[2]; /*!< Two last memory-mapped PGM files. */
+    size_t pgm_sizes[2]; /*!< Sizes in bytes of `pgm_maps`. */
+    size_t pgm_first; /*!< Number of the first image of the PGM sequence. */
+    const uint8_t** rows[2]; /*!< Rows of the two last frames (views given to the caller). */
+    int cur; /*!< Index in `rows` of the last returned frame. */
+} video_metadata_native_t;
+
+int video_reader_native_get_frame(video_reader_t* video, uint8_t** img);
+
+// Maps a regular file in memory (read-only), returns NULL if `fd` is not a regular file
+static uint8_t* _native_map(const int fd, size_t* size) {
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode) || !st.st_size)
+        return NULL;
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+        return NULL;
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+    *size = (size_t)st.st_size;
+    return (uint8_t*)map;
+}
+
+// Reads a text line (without the '\n') from the map or from the stream, returns 0 at the end of the input
+static int _native_read_line(video_metadata_native_t* metadata, char* line, const size_t max_len) {
+    size_t n = 0;
+    int c;
+    while (1) {
+        if (metadata->stream)
+            c = getc(metadata->stream);
+        else
+            c = metadata->offset < metadata->map_size ? metadata->map[metadata->offset++] : EOF;
+        if (c == EOF)
+            return 0;
+        if (c == '\n')
             break;
-#else
-            fprintf(stderr, "(EE) Link with the vcodecs-io library is required.\n");
-            exit(-1);
-#endif
+        if (n < max_len - 1)
+            line[n++] = (char)c;
+    }
+    line[n] = '\0';
+    return 1;
+}
+
+// Parses the Y4M stream header ("YUV4MPEG2 W640 H480 F30:1 C420jpeg ..."), only 8-bit formats are supported: returns
+// 0 if this is not a Y4M stream and -1 if the colorspace is not supported
+static int _native_parse_y4m_header(video_metadata_native_t* metadata) {
+    char line[1024];
+    if (!_native_read_line(metadata, line, sizeof(line)) || strncmp(line, "YUV4MPEG2", 9))
+        return 0;
+    const char* colorspace = "420";
+    char* save = NULL;
+    for (char* tok = strtok_r(line + 9, " ", &save); tok; tok = strtok_r(NULL, " ", &save)) {
+        if (tok[0] == 'W')
+            metadata->width = (unsigned)atoi(tok + 1);
+        else if (tok[0] == 'H')
+            metadata->height = (unsigned)atoi(tok + 1);
+        else if (tok[0] == 'C')
+            colorspace = tok + 1;
+    }
+    const size_t w = metadata->width, h = metadata->height;
+    if (!w || !h)
+        return 0;
+    if (!strncmp(colorspace, "mono", 4) && !colorspace[4])
+        metadata->chroma_size = 0;
+    else if (!strncmp(colorspace, "420", 3) && !strstr(colorspace, "p1"))
+        metadata->chroma_size = 2 * ((w + 1) / 2) * ((h + 1) / 2);
+    else if (!strcmp(colorspace, "422"))
+        metadata->chroma_size = 2 * ((w + 1) / 2) * h;
+    else if (!strcmp(colorspace, "411"))
+        metadata->chroma_size = 2 * ((w + 3) / 4) * h;
+    else if (!strcmp(colorspace, "444"))
+        metadata->chroma_size = 2 * w * h;
+    else if (!strcmp(colorspace, "444alpha"))
+        metadata->chroma_size = 3 * w * h;
+    else
+        return -1;
+    return 1;
+}
+
+// Parses a binary PGM header ("P5 <width> <height> <maxval>", with optional comments), returns the data offset or 0
+static size_t _native_parse_pgm_header(const uint8_t* map, const size_t size, unsigned* width, unsigned* height) {
+    if (size < 2 || map[0] != 'P' || map[1] != '5')
+        return 0;
+    size_t pos = 2;
+    unsigned values[3];
+    for (int v = 0; v < 3; v++) {
+        while (pos < size && (isspace(map[pos]) || map[pos] == '#')) {
+            if (map[pos] == '#')
+                while (pos < size && map[pos] != '\n')
+                    pos++;
+            else
+                pos++;
         }
-        default: {
-            fprintf(stderr, "(EE) This should never happen.\n");
-            exit(-1);
+        if (pos >= size || !isdigit(map[pos]))
+            return 0;
+        values[v] = 0;
+        while (pos < size && isdigit(map[pos]))
+            values[v] = values[v] * 10 + (map[pos++] - '0');
+    }
+    // a single whitespace separates the header from the pixels
+    pos++;
+    if (values[2] > 255 || pos + (size_t)values[0] * values[1] > size)
+        return 0;
+    *width = values[0];
+    *height = values[1];
+    return pos;
+}
+
+// Builds the path of the image `number` from an images sequence pattern: the pattern is not used as a `printf`
+// format, only the `%d`, `%0Nd` and `%%` conversions are replaced. Returns the number of integer conversions, -1 if
+// the pattern holds another conversion (the pattern is valid when 1 is returned)
+static int _native_pgm_path(const char* pattern, const size_t number, char* path, const size_t max_len) {
+    int n_conv = 0;
+    size_t n = 0;
+    for (const char* c = pattern; *c; c++) {
+        char tmp[96];
+        const char* str = tmp;
+        if (*c != '%') {
+            tmp[0] = *c;
+            tmp[1] = '\0';
+        } else if (c[1] == '%') {
+            str = "%";
+            c++;
+        } else {
+            const int zero = c[1] == '0';
+            int width = 0;
+            for (c += 1 + zero; isdigit(*c) && width < 64; c++)
+                width = width * 10 + (*c - '0');
+            if (*c != 'd')
+                return -1;
+            snprintf(tmp, sizeof(tmp), zero ? "%0*d" : "%*d", width, (int)number);
+            n_conv++;
         }
+        for (; *str && n + 1 < max_len; str++)
+            path[n++] = *str;
     }
+    if (max_len)
+        path[n] = '\0';
+    return n_conv;
 }
 
-int video_reader_get_frame(video_reader_t* video, uint8_t** img) {
-    switch (video->codec_type) {
-        case VCDC_FFMPEG_IO: {
-#ifdef MOTION_USE_FFMPEG_IO
-            return video_reader_ffio_get_frame(video, img);
-            break;
-#else
-            fprintf(stderr, "(EE) Link with the ffmpeg-io library is required.\n");
-            exit(-1);
-#endif
+// Maps the PGM image number `number` in the next `pgm_maps` slot, returns the pixels or NULL if there is no such image
+static const uint8_t* _native_map_pgm(video_reader_t* video, const size_t number, const int slot) {
+    video_metadata_native_t* metadata = (video_metadata_native_t*)video->metadata;
+    char path[sizeof(video->path) + 32];
+    _native_pgm_path(video->path, number, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+    size_t size = 0;
+    uint8_t* map = _native_map(fd, &size);
+    close(fd);
+    if (!map)
+        return NULL;
+    unsigned width, height;
+    size_t offset = _native_parse_pgm_header(map, size, &width, &height);
+    if (!offset || (metadata->width && (width != metadata->width || height != metadata->height))) {
+        fprintf(stderr, "(EE) '%s' is not a valid 8-bit binary PGM of the sequence\n", path);
+        exit(1);
+    }
+    if (metadata->pgm_maps[slot])
+        munmap(metadata->pgm_maps[slot], metadata->pgm_sizes[slot]);
+    metadata->pgm_maps[slot] = map;
+    metadata->pgm_sizes[slot] = size;
+    metadata->width = width;
+    metadata->height = height;
+    return map + offset;
+}
+
+// Reads the next frame in the next `rows` slot, returns 1 if a frame has been read and 0 at the end of the input
+static int _native_read_next(video_reader_t* video) {
+    video_metadata_native_t* metadata = (video_metadata_native_t*)video->metadata;
+    const int next = metadata->cur ^ 1;
+    const size_t w = metadata->width, h = metadata->height, fsize = w * h;
+    const uint8_t* frame = NULL;
+
+    if (metadata->format == NATIVE_PGM_SEQ) {
+        frame = _native_map_pgm(video, metadata->pgm_first + video->frame_current, next);
+        if (!frame)
+            return 0;
+    } else {
+        if (metadata->format == NATIVE_Y4M) {
+            char line[256];
+            if (!_native_read_line(metadata, line, sizeof(line)))
+                return 0;
+            if (strncmp(line, "FRAME", 5)) {
+                fprintf(stderr, "(EE) Invalid Y4M frame header in %s\n", video->path);
+                return 0;
+            }
         }
-        case VCDC_VCODECS_IO: {
-#ifdef MOTION_USE_VCODECS_IO
-            return video_reader_vcio_get_frame(video, img);
-            break;
-#else
-            fprintf(stderr, "(EE) Link with the vcodecs-io library is required.\n");
-            exit(-1);
-#endif
+        if (metadata->stream) {
+            // large reads: the frames do not go through the `FILE` buffer
+            uint8_t** img = metadata->img[next];
+            if (fread(img[0], 1, fsize, metadata->stream) != fsize ||
+                (metadata->chroma_size &&
+                 fread(metadata->chroma, 1, metadata->chroma_size, metadata->stream) != metadata->chroma_size))
+                return 0;
+            frame = img[0];
+        } else {
+            if (metadata->offset + fsize + metadata->chroma_size > metadata->map_size)
+                return 0;
+            frame = metadata->map + metadata->offset;
+            metadata->offset += fsize + metadata->chroma_size;
         }
-        default: {
-            fprintf(stderr, "(EE) This should never happen.\n");
-            exit(-1);
+    }
+    for (size_t l = 0; l < h; l++)
+        metadata->rows[next][l] = frame + l * w;
+    metadata->cur = next;
+    return 1;
+}
+
+// Drops the next frame without touching the `rows` slots (the two last returned frames remain valid), returns 1 if a
+// frame has been dropped and 0 at the end of the input
+static int _native_drop_next(video_reader_t* video) {
+    video_metadata_native_t* metadata = (video_metadata_native_t*)video->metadata;
+    const size_t fsize = (size_t)metadata->width * metadata->height;
+
+    if (metadata->format == NATIVE_PGM_SEQ) {
+        char path[sizeof(video->path) + 32];
+        _native_pgm_path(video->path, metadata->pgm_first + video->frame_current, path, sizeof(path));
+        return access(path, R_OK) == 0;
+    }
+    if (metadata->format == NATIVE_Y4M) {
+        char line[256];
+        if (!_native_read_line(metadata, line, sizeof(line)))
+            return 0;
+        if (strncmp(line, "FRAME", 5)) {
+            fprintf(stderr, "(EE) Invalid Y4M frame header in %s\n", video->path);
+            return 0;
         }
     }
+    if (metadata->stream) {
+        // `chroma` is at least as large as a luma plane
+        if (fread(metadata->chroma, 1, fsize, metadata->stream) != fsize ||
+            (metadata->chroma_size &&
+             fread(metadata->chroma, 1, metadata->chroma_size, metadata->stream) != metadata->chroma_size))
+            return 0;
+    } else {
+        if (metadata->offset + fsize + metadata->chroma_size > metadata->map_size)
+            return 0;
+        metadata->offset += fsize + metadata->chroma_size;
+    }
+    return 1;
 }
 
-void video_reader_free(video_reader_t* video) {
-    switch (video->codec_type) {
-        case VCDC_FFMPEG_IO: {
-#ifdef MOTION_USE_FFMPEG_IO
-            video_reader_ffio_free(video);
-            break;
-#else
-            fprintf(stderr, "(EE) Link with the ffmpeg-io library is required.\n");
-            exit(-1);
-#endif
+// Goes back to the first frame and drops the frames before `frame_start` (PGM sequences directly start at `pgm_first`)
+static int _native_rewind(video_reader_t* video) {
+    video_metadata_native_t* metadata = (video_metadata_native_t*)video->metadata;
+    if (metadata->format == NATIVE_PGM_SEQ)
+        return 1;
+    if (metadata->stream) {
+        if (video->cur_loop > 1) // a stream can't be read twice
+            return 0;
+    } else {
+        metadata->offset = metadata->data_offset;
+        if (metadata->format == NATIVE_RAW) {
+            metadata->offset += video->frame_start * (size_t)metadata->width * metadata->height;
+            // a start after the end of the file gives an empty video (no error)
+            if (metadata->offset > metadata->map_size)
+                metadata->offset = metadata->map_size;
+            return 1;
         }
-        case VCDC_VCODECS_IO: {
-#ifdef MOTION_USE_VCODECS_IO
-            video_reader_vcio_free(video);
+    }
+    for (size_t f = 0; f < video->frame_start; f++)
+        if (!_native_drop_next(video))
             break;
-#else
-            fprintf(stderr, "(EE) Link with the vcodecs-io library is required.\n");
-            exit(-1);
-#endif
-        }
-        default: {
-            fprintf(stderr, "(EE) This should never happen.\n");
-            exit(-1);
+    return 1;
+}
+
+int video_reader_native_probe(const char* path, const size_t raw_width, const size_t raw_height) {
+    if (strchr(path, '%')) { // images sequence, same search of the first image as in `video_reader_native_alloc_init`
+        char img_path[2048 + 32];
+        for (size_t number = 0; number <= 4; number++) {
+            if (_native_pgm_path(path, number, img_path, sizeof(img_path)) != 1)
+                return 0;
+            int fd = open(img_path, O_RDONLY);
+            if (fd == -1)
+                continue;
+            size_t size = 0;
+            uint8_t* map = _native_map(fd, &size);
+            close(fd);
+            if (!map)
+                return 0;
+            unsigned width, height;
+            const int is_pgm = _native_parse_pgm_header(map, size, &width, &height) != 0;
+            munmap(map, size);
+            return is_pgm;
         }
+        return 0;
     }
+    if (!strcmp(path, "-")) // a stream can't be probed without being consumed
+        return 1;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return 0;
+    video_metadata_native_t metadata;
+    memset(&metadata, 0, sizeof(metadata));
+    metadata.map = _native_map(fd, &metadata.map_size);
+    close(fd);
+    if (!metadata.map)
+        return 0;
+    const int is_valid = raw_width && raw_height ? metadata.map_size >= raw_width * raw_height :
+                                                   _native_parse_y4m_header(&metadata) == 1;
+    munmap(metadata.map, metadata.map_size);
+    return is_valid;
 }
 
-video_writer_t* video_writer_alloc_init(const char* path, const size_t start, const size_t n_ffmpeg_threads,
+video_reader_t* video_reader_native_alloc_init(const char* path, const size_t start, const size_t end,
+                                               const size_t skip, const int bufferize, const size_t raw_width,
+                                               const size_t raw_height, int* i0, int* i1, int* j0, int* j1) {
+    assert(!end || start <= end);
+    video_reader_t* video = (video_reader_t*)malloc(sizeof(video_reader_t));
+    if (!video) {
+        fprintf(stderr, "(EE) can't allocate video structure\n");
+        exit(1);
+    }
+
+    snprintf(video->path, sizeof(video->path), "%s", path);
+
+    video->codec_type = VCDC_NATIVE;
+    video_metadata_native_t* metadata = (video_metadata_native_t*)calloc(1, sizeof(video_metadata_native_t));
+    video->metadata = (void*)metadata;
+
+    video->frame_start = start;
+    video->frame_end = end;
+    video->frame_skip = skip;
+    video->frame_current = 0;
+    video->fra_buffer = NULL;
+    video->fra_zbuffer = NULL;
+    video->fra_count = 0;
+    video->cur_loop = 1;
+    video->loop_size = 1;
+
+    if (strchr(path, '%')) { // images sequence
+        metadata->format = NATIVE_PGM_SEQ;
+        char img_path[sizeof(video->path) + 32];
+        if (_native_pgm_path(path, 0, img_path, sizeof(img_path)) != 1) {
+            fprintf(stderr, "(EE) %s: an images sequence needs exactly one '%%d' (or '%%0Nd') conversion\n",
+                    video->path);
+            exit(1);
+        }
+        // same as the ffmpeg 'image2' demuxer: if not given, the first image is searched in [0;4]
+        size_t first = start, last = start ? start : 4;
+        for (metadata->pgm_first = first; metadata->pgm_first <= last; metadata->pgm_first++)
+            if (_native_map_pgm(video, metadata->pgm_first, 0))
+                break;
+        if (metadata->pgm_first > last) {
+            fprintf(stderr, "(EE) can't open file %s\n", video->path);
+            exit(1);
+        }
+    } else {
+        const int is_stdin = !strcmp(path, "-");
+        int fd = is_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+        if (fd == -1) {
+            fprintf(stderr, "(EE) can't open file %s\n", video->path);
+            exit(1);
+        }
+        metadata->map = _native_map(fd, &metadata->map_size);
+        if (!is_stdin)
+            close(fd);
+        if (!metadata->map) {
+            if (!is_stdin) {
+                fprintf(stderr, "(EE) can't read file %s\n", video->path);
+                exit(1);
+            }
+            metadata->stream = stdin;
+            setvbuf(stdin, NULL, _IOFBF, 1 << 20);
+        }
+        if (raw_width && raw_height) {
+            metadata->format = NATIVE_RAW;
+            metadata->width = raw_width;
+            metadata->height = raw_height;
+        } else {
+            metadata->format = NATIVE_Y4M;
+            const int y4m = _native_parse_y4m_header(metadata);
+            if (y4m < 0) {
+                fprintf(stderr, "(EE) %s: unsupported Y4M colorspace\n", video->path);
+                exit(1);
+            }
+            if (!y4m) {
+                fprintf(stderr, "(EE) %s is not a Y4M stream, the frame size is required for raw gray inputs\n",
+                        video->path);
+                exit(1);
+            }
+        }
+        metadata->data_offset = metadata->offset;
+        if (metadata->stream) {
+            const size_t fsize = (size_t)metadata->width * metadata->height;
+            metadata->chroma = (uint8_t*)malloc(metadata->chroma_size > fsize ? metadata->chroma_size : fsize);
+            for (int f = 0; f < 2; f++)
+                metadata->img[f] = ui8matrix(0, metadata->height - 1, 0, metadata->width - 1);
+        }
+    }
+    for (int f = 0; f < 2; f++)
+        metadata->rows[f] = (const uint8_t**)malloc(metadata->height * sizeof(const uint8_t*));
+    metadata->cur = 1;
+
+    if (!_native_rewind(video)) {
+        fprintf(stderr, "(EE) can't read file %s\n", video->path);
+        exit(1);
+    }
+
+    *i0 = 0;
+    *j0 = 0;
+    *i1 = metadata->height - 1;
+    *j1 = metadata->width - 1;
+
+    if (bufferize)
+        _video_reader_bufferize(video, video_reader_native_get_frame, bufferize, *i0, *i1, *j0, *j1);
+
+    return video;
+}
+
+// Reads the next frame, or drops it when `view` is NULL (skipped frames)
+static int _video_reader_native_get_frame(video_reader_t* video, const uint8_t*** view) {
+    video_metadata_native_t* metadata = (video_metadata_native_t*)video->metadata;
+    if (video->frame_end && video->frame_start + video->frame_current > video->frame_end)
+        return -1;
+    if (!(view ? _native_read_next(video) : _native_drop_next(video)))
+        return -1;
+    if (view)
+        *view = metadata->rows[metadata->cur];
+
+    int cur_fra = (int)video->frame_current;
+    video->frame_current++;
+    return cur_fra;
+}
+
+int video_reader_native_get_frame_view(video_reader_t* video, const uint8_t*** view) {
+    assert(video->codec_type == VCDC_NATIVE);
+retry:
+    if (!_video_reader_is_buffered(video)) { // Not bufferized
+        int r;
+        size_t skip = video->frame_current == 0 ? 0 : video->frame_skip;
+        do {
+            r = _video_reader_native_get_frame(video, skip ? NULL : view);
+            // restart reader
+            if (r == -1 && video->cur_loop < video->loop_size) {
+                video->cur_loop++;
+                video->frame_current = 0;
+                if (!_native_rewind(video)) {
+                    fprintf(stderr, "(EE) can't rewind file %s\n", video->path);
+                    exit(1);
+                }
+                goto retry;
+            }
+        } while ((r != -1) && skip--);
+        if (video->cur_loop == 1 && r != -1)
+            video->fra_count++;
+        return (r == -1) ? r : video->frame_start + r + (video->cur_loop -1) * video->fra_count *
+                               (1 + video->frame_skip);
+    } else
+        return _video_reader_buffered_view(video, view);
+}
+
+int video_reader_native_get_frame(video_reader_t* video, uint8_t** img) {
+    video_metadata_native_t* metadata = (video_metadata_native_t*)video->metadata;
+    const uint8_t** view;
+    int r = video_reader_native_get_frame_view(video, &view);
+    if (r != -1)
+        for (unsigned l = 0; l < metadata->height; l++)
+            memcpy(img[l], view[l], metadata->width);
+    return r;
+}
+
+void video_reader_native_free(video_reader_t* video) {
+    assert(video->codec_type == VCDC_NATIVE);
+    video_metadata_native_t* metadata = (video_metadata_native_t*)video->metadata;
+    _video_reader_buffer_free(video, 0, metadata->height - 1, 0, metadata->width - 1);
+    if (metadata->map)
+        munmap(metadata->map, metadata->map_size);
+    for (int f = 0; f < 2; f++) {
+        if (metadata->pgm_maps[f])
+            munmap(metadata->pgm_maps[f], metadata->pgm_sizes[f]);
+        if (metadata->img[f])
+            free_ui8matrix(metadata->img[f], 0, metadata->height - 1, 0, metadata->width - 1);
+        free(metadata->rows[f]);
+    }
+    free(metadata->chroma);
+    free(metadata);
+    free(video);
+}
+
+
+typedef struct {
+    int fd; /*!< File descriptor of the cache. */
+    uint8_t* map; /*!< Memory-mapped cache file. */
+    size_t map_size; /*!< Size in bytes of the mapping. */
+    unsigned width; /*!< Frames width. */
+    unsigned height; /*!< Frames height. */
+    const uint8_t** rows[2]; /*!< Rows of the two last returned frames (a view stays valid until the next-next call). */
+    int cur; /*!< Index in `rows` of the last returned frame. */
+} video_metadata_cache_t;
+
+static void _video_cache_src_stat(const char* src_path, uint64_t* size, int64_t* mtime) {
+    struct stat st;
+    if (!stat(src_path, &st)) {
+        *size = (uint64_t)st.st_size;
+        *mtime = (int64_t)st.st_mtime;
+    } else { // images sequence ("%04d.pgm"-like path)
+        *size = 0;
+        *mtime = 0;
+    }
+}
+
+// Returns a video reader on `cache_path` if the cache exists and matches the source & the parameters, NULL otherwise
+static video_reader_t* _video_reader_cache_open(const char* cache_path, const char* src_path, const size_t start,
+                                                const size_t end, const size_t skip, int* i0, int* i1, int* j0,
+                                                int* j1) {
+    int fd = open(cache_path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    video_cache_header_t hdr;
+    struct stat st;
+    uint64_t src_size;
+    int64_t src_mtime;
+    _video_cache_src_stat(src_path, &src_size, &src_mtime);
+    if (pread(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) || fstat(fd, &st) ||
+        memcmp(hdr.magic, VIDEO_CACHE_MAGIC, sizeof(hdr.magic)) || hdr.version != VIDEO_CACHE_VERSION ||
+        !hdr.width || !hdr.height || !hdr.n_frames || hdr.frame_start != start || hdr.frame_end != end ||
+        hdr.frame_skip != skip || hdr.src_size != src_size || hdr.src_mtime != src_mtime ||
+        strncmp(hdr.src_path, src_path, sizeof(hdr.src_path)) ||
+        (uint64_t)st.st_size != VIDEO_CACHE_HEADER_SIZE + hdr.n_frames * hdr.width * hdr.height) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t map_size = (size_t)st.st_size;
+    void* map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    madvise(map, map_size, MADV_SEQUENTIAL);
+
+    video_reader_t* video = (video_reader_t*)malloc(sizeof(video_reader_t));
+    video_metadata_cache_t* metadata = (video_metadata_cache_t*)malloc(sizeof(video_metadata_cache_t));
+    if (!video || !metadata) {
+        fprintf(stderr, "(EE) can't allocate video structure\n");
+        exit(1);
+    }
+    snprintf(video->path, sizeof(video->path), "%s", src_path);
+    video->codec_type = VCDC_FRAME_CACHE;
+    video->metadata = (void*)metadata;
+    video->frame_start = start;
+    video->frame_end = end;
+    video->frame_skip = skip;
+    video->frame_current = 0;
+    video->fra_buffer = NULL;
+    video->fra_zbuffer = NULL;
+    video->fra_count = hdr.n_frames;
+    video->cur_loop = 1;
+    video->loop_size = 1;
+
+    metadata->fd = fd;
+    metadata->map = (uint8_t*)map;
+    metadata->map_size = map_size;
+    metadata->width = hdr.width;
+    metadata->height = hdr.height;
+    for (int r = 0; r < 2; r++)
+        metadata->rows[r] = (const uint8_t**)malloc(hdr.height * sizeof(const uint8_t*));
+    metadata->cur = 0;
+
+    *i0 = 0;
+    *j0 = 0;
+    *i1 = hdr.height - 1;
+    *j1 = hdr.width - 1;
+
+    return video;
+}
+
+// Decodes all the frames of `src` in a new cache file (written in "<cache_path>.tmp" and renamed when complete)
+static void _video_reader_cache_build(video_reader_t* src, const char* cache_path, const int i0, const int i1,
+                                      const int j0, const int j1) {
+    char tmp_path[2048 + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        fprintf(stderr, "(EE) can't create the frame cache '%s'\n", tmp_path);
+        exit(1);
+    }
+
+    static const char zeros[VIDEO_CACHE_HEADER_SIZE] = {0};
+    const size_t width = (size_t)(j1 - j0 + 1), height = (size_t)(i1 - i0 + 1);
+    uint8_t** img = ui8matrix(i0, i1, j0, j1);
+    uint64_t n_frames = 0;
+    int ok = fwrite(zeros, 1, sizeof(zeros), f) == sizeof(zeros);
+    while (ok && video_reader_get_frame(src, img) != -1) {
+        // `ui8matrix` rows are contiguous
+        ok = fwrite(img[i0] + j0, 1, width * height, f) == width * height;
+        n_frames++;
+    }
+    free_ui8matrix(img, i0, i1, j0, j1);
+
+    video_cache_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, VIDEO_CACHE_MAGIC, sizeof(hdr.magic));
+    hdr.version = VIDEO_CACHE_VERSION;
+    hdr.width = width;
+    hdr.height = height;
+    hdr.n_frames = n_frames;
+    hdr.frame_start = src->frame_start;
+    hdr.frame_end = src->frame_end;
+    hdr.frame_skip = src->frame_skip;
+    _video_cache_src_stat(src->path, &hdr.src_size, &hdr.src_mtime);
+    snprintf(hdr.src_path, sizeof(hdr.src_path), "%s", src->path);
+
+    ok = ok && n_frames && !fseek(f, 0, SEEK_SET) && fwrite(&hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+    ok = !fclose(f) && ok;
+    if (!ok || rename(tmp_path, cache_path)) {
+        fprintf(stderr, "(EE) can't write the frame cache '%s'\n", cache_path);
+        remove(tmp_path);
+        exit(1);
+    }
+}
+
+int video_reader_cache_get_frame_view(video_reader_t* video, const uint8_t*** view) {
+    assert(video->codec_type == VCDC_FRAME_CACHE);
+    video_metadata_cache_t* metadata = (video_metadata_cache_t*)video->metadata;
+    size_t f;
+    int cur_fra = _video_reader_buffered_next(video, &f);
+    if (cur_fra != -1) {
+        const size_t fsize = (size_t)metadata->width * metadata->height;
+        const uint8_t* frame = metadata->map + VIDEO_CACHE_HEADER_SIZE + f * fsize;
+        metadata->cur ^= 1;
+        const uint8_t** rows = metadata->rows[metadata->cur];
+        for (unsigned l = 0; l < metadata->height; l++)
+            rows[l] = frame + l * metadata->width;
+        *view = rows;
+    }
+    return cur_fra;
+}
+
+int video_reader_cache_get_frame(video_reader_t* video, uint8_t** img) {
+    video_metadata_cache_t* metadata = (video_metadata_cache_t*)video->metadata;
+    const uint8_t** view;
+    int r = video_reader_cache_get_frame_view(video, &view);
+    if (r != -1)
+        for (unsigned l = 0; l < metadata->height; l++)
+            memcpy(img[l], view[l], metadata->width);
+    return r;
+}
+
+void video_reader_cache_free(video_reader_t* video) {
+    assert(video->codec_type == VCDC_FRAME_CACHE);
+    video_metadata_cache_t* metadata = (video_metadata_cache_t*)video->metadata;
+    munmap(metadata->map, metadata->map_size);
+    close(metadata->fd);
+    for (int r = 0; r < 2; r++)
+        free(metadata->rows[r]);
+    free(metadata);
+    free(video);
+}
+
+int video_reader_shm_get_frame(video_reader_t* video, uint8_t** img);
+
+typedef struct {
+    video_shm_header_t* header; /*!< Mapped ring (header and slots). */
+    size_t map_size; /*!< Size in bytes of the mapping. */
+    const uint8_t*** rows; /*!< Rows of the frame of each slot. */
+    uint64_t next; /*!< Number of the next frame to read in the ring. */
+    uint64_t last; /*!< Number of the last returned frame (still used by the caller, as the skipped frames after it
+                        are not released). */
+} video_metadata_shm_t;
+
+// Waits until `*addr != val` (or a wake up, a signal or a 100 ms timeout: the caller checks its condition again)
+static void _shm_futex_wait(uint32_t* addr, const uint32_t val) {
+#ifdef __linux__
+    struct timespec timeout = {0, 100 * 1000 * 1000};
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, &timeout, NULL, 0);
+#else
+    (void)addr;
+    (void)val;
+    usleep(100);
+#endif
+}
+
+static void _shm_futex_wake(uint32_t* addr) {
+#ifdef __linux__
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+
+static inline video_shm_slot_t* _shm_slot(video_shm_header_t* header, const uint64_t seq) {
+    return (video_shm_slot_t*)((uint8_t*)header + VIDEO_SHM_HEADER_SIZE + (seq % header->n_slots) * header->slot_size);
+}
+
+// Releases the frames before `seq` to the producer
+static void _shm_release(video_shm_header_t* header, const uint64_t seq) {
+    __atomic_store_n(&header->read_seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->read_futex, (uint32_t)seq, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->producer_waiting, __ATOMIC_SEQ_CST))
+        _shm_futex_wake(&header->read_futex);
+}
+
+// Waits for the frame `seq`, returns 0 at the end of the stream
+static int _shm_wait_frame(video_shm_header_t* header, const uint64_t seq) {
+    while (__atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE) <= seq) {
+        if (__atomic_load_n(&header->eos, __ATOMIC_ACQUIRE))
+            return __atomic_load_n(&header->write_seq, __ATOMIC_ACQUIRE) > seq;
+        __atomic_store_n(&header->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+        const uint32_t val = __atomic_load_n(&header->write_futex, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&header->write_seq, __ATOMIC_SEQ_CST) <= seq &&
+            !__atomic_load_n(&header->eos, __ATOMIC_SEQ_CST))
+            _shm_futex_wait(&header->write_futex, val);
+        __atomic_store_n(&header->consumer_waiting, 0, __ATOMIC_RELAXED);
+    }
+    return 1;
+}
+
+// Reads the next frame of the ring, or skips it when `view` is NULL. Only the frames before the previously returned one
+// are released: the caller still uses it. Returns 0 at the end
+static int _shm_read_next(video_metadata_shm_t* metadata, const uint8_t*** view) {
+    video_shm_header_t* header = metadata->header;
+    const uint64_t seq = metadata->next;
+    // released before the wait: the producer may need these slots to write the frame `seq`
+    _shm_release(header, metadata->last);
+    if (!_shm_wait_frame(header, seq))
+        return 0;
+    if (_shm_slot(header, seq)->seq != seq) {
+        fprintf(stderr, "(EE) the shared-memory ring is corrupted (frame %lu expected in the slot, %lu found)\n",
+                (unsigned long)seq, (unsigned long)_shm_slot(header, seq)->seq);
+        exit(1);
+    }
+    if (view) {
+        *view = metadata->rows[seq % header->n_slots];
+        metadata->last = seq;
+    }
+    metadata->next++;
+    return 1;
+}
+
+video_reader_t* video_reader_shm_alloc_init(const char* path, const size_t start, const size_t end, const size_t skip,
+                                            const int bufferize, int* i0, int* i1, int* j0, int* j1) {
+    assert(!end || start <= end);
+    video_reader_t* video = (video_reader_t*)malloc(sizeof(video_reader_t));
+    if (!video) {
+        fprintf(stderr, "(EE) can't allocate video structure\n");
+        exit(1);
+    }
+
+    snprintf(video->path, sizeof(video->path), "%s", path);
+
+    video->codec_type = VCDC_SHM;
+    video_metadata_shm_t* metadata = (video_metadata_shm_t*)calloc(1, sizeof(video_metadata_shm_t));
+    video->metadata = (void*)metadata;
+
+    video->frame_start = start;
+    video->frame_end = end;
+    video->frame_skip = skip;
+    video->frame_current = 0;
+    video->fra_buffer = NULL;
+    video->fra_zbuffer = NULL;
+    video->fra_count = 0;
+    video->cur_loop = 1;
+    video->loop_size = 1;
+
+    int fd = open(path, O_RDWR);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) || (size_t)st.st_size < VIDEO_SHM_HEADER_SIZE) {
+        fprintf(stderr, "(EE) can't open the shared-memory ring %s\n", video->path);
+        exit(1);
+    }
+    metadata->map_size = st.st_size;
+    void* map = mmap(NULL, metadata->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "(EE) can't map the shared-memory ring %s\n", video->path);
+        exit(1);
+    }
+    video_shm_header_t* header = (video_shm_header_t*)map;
+    metadata->header = header;
+    if (memcmp(header->magic, VIDEO_SHM_MAGIC, 8) || header->version != VIDEO_SHM_VERSION || !header->width ||
+        !header->height || header->n_slots < 3 ||
+        header->slot_size < VIDEO_SHM_SLOT_HEADER_SIZE + (uint64_t)header->width * header->height ||
+        metadata->map_size < VIDEO_SHM_HEADER_SIZE + header->n_slots * header->slot_size) {
+        fprintf(stderr, "(EE) %s is not a valid shared-memory ring (version %u expected)\n", video->path,
+                VIDEO_SHM_VERSION);
+        exit(1);
+    }
+    // the consumer holds the previous returned frame and the skipped ones while it waits for the next frame
+    if (header->n_slots < skip + 2) {
+        fprintf(stderr, "(EE) %s: the shared-memory ring has %u slots, at least %lu are required to skip %lu frames\n",
+                video->path, header->n_slots, (unsigned long)(skip + 2), (unsigned long)skip);
+        exit(1);
+    }
+
+    // the consumer starts at the oldest frame still in the ring
+    metadata->next = __atomic_load_n(&header->read_seq, __ATOMIC_ACQUIRE);
+    metadata->rows = (const uint8_t***)malloc(header->n_slots * sizeof(const uint8_t**));
+    for (uint32_t s = 0; s < header->n_slots; s++) {
+        const uint8_t* frame = (const uint8_t*)_shm_slot(header, s) + VIDEO_SHM_SLOT_HEADER_SIZE;
+        metadata->rows[s] = (const uint8_t**)malloc(header->height * sizeof(const uint8_t*));
+        for (uint32_t l = 0; l < header->height; l++)
+            metadata->rows[s][l] = frame + (size_t)l * header->width;
+    }
+    metadata->last = metadata->next;
+    // nothing has been returned yet, the frames before the start are released as they are read
+    for (size_t f = 0; f < start; f++) {
+        if (!_shm_read_next(metadata, NULL))
+            break;
+        metadata->last = metadata->next;
+    }
+
+    *i0 = 0;
+    *j0 = 0;
+    *i1 = header->height - 1;
+    *j1 = header->width - 1;
+
+    if (bufferize)
+        _video_reader_bufferize(video, video_reader_shm_get_frame, bufferize, *i0, *i1, *j0, *j1);
+
+    return video;
+}
+
+static int _video_reader_shm_get_frame(video_reader_t* video, const uint8_t*** view) {
+    video_metadata_shm_t* metadata = (video_metadata_shm_t*)video->metadata;
+    if (video->frame_end && video->frame_start + video->frame_current > video->frame_end)
+        return -1;
+    if (!_shm_read_next(metadata, view))
+        return -1;
+
+    int cur_fra = (int)video->frame_current;
+    video->frame_current++;
+    return cur_fra;
+}
+
+int video_reader_shm_get_frame_view(video_reader_t* video, const uint8_t*** view) {
+    assert(video->codec_type == VCDC_SHM);
+    if (!_video_reader_is_buffered(video)) { // Not bufferized
+        int r;
+        size_t skip = video->frame_current == 0 ? 0 : video->frame_skip;
+        do {
+            r = _video_reader_shm_get_frame(video, skip ? NULL : view);
+            // a stream can't be read twice
+            if (r == -1 && video->cur_loop < video->loop_size) {
+                fprintf(stderr, "(EE) can't rewind the shared-memory ring %s\n", video->path);
+                exit(1);
+            }
+        } while ((r != -1) && skip--);
+        if (r != -1)
+            video->fra_count++;
+        return (r == -1) ? r : video->frame_start + r;
+    } else
+        return _video_reader_buffered_view(video, view);
+}
+
+int video_reader_shm_get_frame(video_reader_t* video, uint8_t** img) {
+    video_metadata_shm_t* metadata = (video_metadata_shm_t*)video->metadata;
+    const uint8_t** view;
+    int r = video_reader_shm_get_frame_view(video, &view);
+    if (r != -1)
+        for (unsigned l = 0; l < metadata->header->height; l++)
+            memcpy(img[l], view[l], metadata->header->width);
+    return r;
+}
+
+void video_reader_shm_free(video_reader_t* video) {
+    assert(video->codec_type == VCDC_SHM);
+    video_metadata_shm_t* metadata = (video_metadata_shm_t*)video->metadata;
+    video_shm_header_t* header = metadata->header;
+    _video_reader_buffer_free(video, 0, header->height - 1, 0, header->width - 1);
+    // give back all the frames to the producer
+    _shm_release(header, metadata->next);
+    for (uint32_t s = 0; s < header->n_slots; s++)
+        free(metadata->rows[s]);
+    free(metadata->rows);
+    munmap(header, metadata->map_size);
+    free(metadata);
+    free(video);
+}
+
+video_shm_writer_t* video_shm_writer_alloc_init(const char* path, const size_t width, const size_t height,
+                                                const size_t n_slots) {
+    if (n_slots < 3) {
+        fprintf(stderr, "(EE) a shared-memory ring requires at least 3 slots\n");
+        exit(1);
+    }
+    video_shm_writer_t* shm = (video_shm_writer_t*)malloc(sizeof(video_shm_writer_t));
+    if (!shm) {
+        fprintf(stderr, "(EE) 'video_shm_writer_alloc_init' failed\n");
+        exit(1);
+    }
+    const size_t slot_size = (VIDEO_SHM_SLOT_HEADER_SIZE + width * height + 63) & ~(size_t)63;
+    shm->map_size = VIDEO_SHM_HEADER_SIZE + n_slots * slot_size;
+    shm->stall_us = 0.;
+    shm->n_dropped = 0;
+
+    // the ring is created under a temporary name and renamed once its header is complete
+    char tmp_path[2048 + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1 || ftruncate(fd, shm->map_size)) {
+        fprintf(stderr, "(EE) can't create the shared-memory ring %s\n", tmp_path);
+        exit(1);
+    }
+    void* map = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "(EE) can't map the shared-memory ring %s\n", tmp_path);
+        exit(1);
+    }
+    shm->header = (video_shm_header_t*)map;
+    memcpy(shm->header->magic, VIDEO_SHM_MAGIC, 8);
+    shm->header->version = VIDEO_SHM_VERSION;
+    shm->header->width = width;
+    shm->header->height = height;
+    shm->header->n_slots = n_slots;
+    shm->header->slot_size = slot_size;
+    if (rename(tmp_path, path)) {
+        fprintf(stderr, "(EE) can't rename %s into %s\n", tmp_path, path);
+        exit(1);
+    }
+    return shm;
+}
+
+int video_shm_writer_save_frame(video_shm_writer_t* shm, const uint8_t** img, const int block) {
+    video_shm_header_t* header = shm->header;
+    const uint64_t seq = header->write_seq; // only written by this process
+    if (seq >= __atomic_load_n(&header->read_seq, __ATOMIC_ACQUIRE) + header->n_slots) {
+        if (!block) {
+            shm->n_dropped++;
+            return 0;
+        }
+        TIME_POINT(stall_b);
+        while (1) {
+            __atomic_store_n(&header->producer_waiting, 1, __ATOMIC_SEQ_CST);
+            const uint32_t val = __atomic_load_n(&header->read_futex, __ATOMIC_SEQ_CST);
+            if (seq < __atomic_load_n(&header->read_seq, __ATOMIC_SEQ_CST) + header->n_slots)
+                break;
+            _shm_futex_wait(&header->read_futex, val);
+        }
+        __atomic_store_n(&header->producer_waiting, 0, __ATOMIC_RELAXED);
+        TIME_POINT(stall_e);
+        shm->stall_us += TIME_ELAPSED2_US(stall_b, stall_e);
+    }
+    video_shm_slot_t* slot = _shm_slot(header, seq);
+    uint8_t* frame = (uint8_t*)slot + VIDEO_SHM_SLOT_HEADER_SIZE;
+    for (uint32_t l = 0; l < header->height; l++)
+        memcpy(frame + (size_t)l * header->width, img[l], header->width);
+    slot->seq = seq;
+    __atomic_store_n(&header->write_seq, seq + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->write_futex, (uint32_t)(seq + 1), __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->consumer_waiting, __ATOMIC_SEQ_CST))
+        _shm_futex_wake(&header->write_futex);
+    return 1;
+}
+
+void video_shm_writer_free(video_shm_writer_t* shm) {
+    video_shm_header_t* header = shm->header;
+    __atomic_store_n(&header->eos, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&header->write_futex, 1, __ATOMIC_SEQ_CST);
+    _shm_futex_wake(&header->write_futex);
+    munmap(header, shm->map_size);
+    free(shm);
+}
+
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+
+static video_reader_t* _video_reader_alloc_init(const char* path, const size_t start, const size_t end,
+                                                const size_t skip, const int bufferize, const size_t n_ffmpeg_threads,
+                                                const enum video_codec_e codec_type,
+                                                const enum video_codec_hwaccel_e hwaccel, const size_t raw_width,
+                                                const size_t raw_height, int* i0, int* i1, int* j0, int* j1) {
+    switch (codec_type) {
+        case VCDC_FFMPEG_IO: {
+#ifdef MOTION_USE_FFMPEG_IO
+            return video_reader_ffio_alloc_init(path, start, end, skip, bufferize, n_ffmpeg_threads, hwaccel, i0, i1, j0, j1);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the ffmpeg-io library is required.\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_VCODECS_IO: {
+#ifdef MOTION_USE_VCODECS_IO
+            return video_reader_vcio_alloc_init(path, start, end, skip, bufferize, n_ffmpeg_threads, hwaccel, i0, i1, j0, j1);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the libavcodec libraries is required ('MOTION_VCODECS_IO_LINK').\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_NATIVE: {
+            return video_reader_native_alloc_init(path, start, end, skip, bufferize, raw_width, raw_height, i0, i1, j0,
+                                                  j1);
+            break;
+        }
+        case VCDC_SHM: {
+            return video_reader_shm_alloc_init(path, start, end, skip, bufferize, i0, i1, j0, j1);
+            break;
+        }
+        default: {
+            fprintf(stderr, "(EE) This should never happen.\n");
+            exit(-1);
+        }
+    }
+}
+
+int video_reader_segments_get_frame(video_reader_t* video, uint8_t** img);
+int video_reader_segments_get_frame_view(video_reader_t* video, const uint8_t*** view);
+void video_reader_segments_free(video_reader_t* video);
+
+video_reader_t* video_reader_alloc_init(const char* path, const size_t start, const size_t end, const size_t skip,
+                                        const int bufferize, const size_t n_ffmpeg_threads,
+                                        const enum video_codec_e codec_type, const enum video_codec_hwaccel_e hwaccel,
+                                        const size_t raw_width, const size_t raw_height, const char* cache_path,
+                                        int* i0, int* i1, int* j0, int* j1) {
+    if (!cache_path)
+        return _video_reader_alloc_init(path, start, end, skip, bufferize, n_ffmpeg_threads, codec_type, hwaccel,
+                                        raw_width, raw_height, i0, i1, j0, j1);
+
+    // the cache is already in memory (mapped), `bufferize` is useless here
+    video_reader_t* video = _video_reader_cache_open(cache_path, path, start, end, skip, i0, i1, j0, j1);
+    if (!video) {
+        fprintf(stderr, "(II) Building the frame cache '%s'...\n", cache_path);
+        video_reader_t* src = _video_reader_alloc_init(path, start, end, skip, 0, n_ffmpeg_threads, codec_type,
+                                                       hwaccel, raw_width, raw_height, i0, i1, j0, j1);
+        _video_reader_cache_build(src, cache_path, *i0, *i1, *j0, *j1);
+        video_reader_free(src);
+        video = _video_reader_cache_open(cache_path, path, start, end, skip, i0, i1, j0, j1);
+        if (!video) {
+            fprintf(stderr, "(EE) can't open the frame cache '%s'\n", cache_path);
+            exit(1);
+        }
+    }
+    return video;
+}
+
+int video_reader_probe(const char* path, const enum video_codec_e codec_type, const size_t raw_width,
+                       const size_t raw_height) {
+    switch (codec_type) {
+        case VCDC_FFMPEG_IO: {
+#ifdef MOTION_USE_FFMPEG_IO
+            return video_reader_ffio_probe(path);
+#else
+            return 0;
+#endif
+        }
+        case VCDC_VCODECS_IO: {
+#ifdef MOTION_USE_VCODECS_IO
+            return video_reader_vcio_probe(path);
+#else
+            return 0;
+#endif
+        }
+        case VCDC_NATIVE:
+            return video_reader_native_probe(path, raw_width, raw_height);
+        default: // the shared-memory ring is created by the producer, it can't be probed before it exists
+            return 1;
+    }
+}
+
+int video_reader_get_frame(video_reader_t* video, uint8_t** img) {
+    switch (video->codec_type) {
+        case VCDC_FFMPEG_IO: {
+#ifdef MOTION_USE_FFMPEG_IO
+            return video_reader_ffio_get_frame(video, img);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the ffmpeg-io library is required.\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_VCODECS_IO: {
+#ifdef MOTION_USE_VCODECS_IO
+            return video_reader_vcio_get_frame(video, img);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the libavcodec libraries is required ('MOTION_VCODECS_IO_LINK').\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_NATIVE: {
+            return video_reader_native_get_frame(video, img);
+            break;
+        }
+        case VCDC_SHM: {
+            return video_reader_shm_get_frame(video, img);
+            break;
+        }
+        case VCDC_SEGMENTS: {
+            return video_reader_segments_get_frame(video, img);
+            break;
+        }
+        case VCDC_FRAME_CACHE: {
+            return video_reader_cache_get_frame(video, img);
+            break;
+        }
+        default: {
+            fprintf(stderr, "(EE) This should never happen.\n");
+            exit(-1);
+        }
+    }
+}
+
+int video_reader_get_frame_view(video_reader_t* video, uint8_t** img, const uint8_t*** view) {
+    switch (video->codec_type) {
+        case VCDC_FFMPEG_IO: {
+#ifdef MOTION_USE_FFMPEG_IO
+            return video_reader_ffio_get_frame_view(video, img, view);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the ffmpeg-io library is required.\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_VCODECS_IO: {
+#ifdef MOTION_USE_VCODECS_IO
+            return video_reader_vcio_get_frame_view(video, view);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the libavcodec libraries is required ('MOTION_VCODECS_IO_LINK').\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_NATIVE: {
+            return video_reader_native_get_frame_view(video, view);
+            break;
+        }
+        case VCDC_SHM: {
+            return video_reader_shm_get_frame_view(video, view);
+            break;
+        }
+        case VCDC_SEGMENTS: {
+            return video_reader_segments_get_frame_view(video, view);
+            break;
+        }
+        case VCDC_FRAME_CACHE: {
+            return video_reader_cache_get_frame_view(video, view);
+            break;
+        }
+        default: {
+            // no zero-copy support: the frame is copied in `img`
+            *view = (const uint8_t**)img;
+            return video_reader_get_frame(video, img);
+        }
+    }
+}
+
+double video_reader_get_frame_rate(const video_reader_t* video) {
+#ifdef MOTION_USE_FFMPEG_IO
+    if (video->codec_type == VCDC_FFMPEG_IO) {
+        const ffmpeg_ratio rate = ((const video_metadata_ffio_t*)video->metadata)->ffmpeg.input.framerate;
+        if (rate.num && rate.den)
+            return (double)rate.num / (double)rate.den / (double)(video->frame_skip + 1);
+    }
+#endif
+    (void)video;
+    return 0.;
+}
+
+void video_reader_free(video_reader_t* video) {
+    switch (video->codec_type) {
+        case VCDC_FFMPEG_IO: {
+#ifdef MOTION_USE_FFMPEG_IO
+            video_reader_ffio_free(video);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the ffmpeg-io library is required.\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_VCODECS_IO: {
+#ifdef MOTION_USE_VCODECS_IO
+            video_reader_vcio_free(video);
+            break;
+#else
+            fprintf(stderr, "(EE) Link with the libavcodec libraries is required ('MOTION_VCODECS_IO_LINK').\n");
+            exit(-1);
+#endif
+        }
+        case VCDC_NATIVE: {
+            video_reader_native_free(video);
+            break;
+        }
+        case VCDC_SHM: {
+            video_reader_shm_free(video);
+            break;
+        }
+        case VCDC_SEGMENTS: {
+            video_reader_segments_free(video);
+            break;
+        }
+        case VCDC_FRAME_CACHE: {
+            video_reader_cache_free(video);
+            break;
+        }
+        default: {
+            fprintf(stderr, "(EE) This should never happen.\n");
+            exit(-1);
+        }
+    }
+}
+
+// yield the CPU a few times and then sleep, a waiting thread should not steal the cores of the OpenMP workers
+static void _video_reader_async_backoff(unsigned* n_tries) {
+    if ((*n_tries)++ < 64)
+        sched_yield();
+    else
+        usleep(50);
+}
+
+static void* _video_reader_async_decode(void* arg) {
+    video_reader_async_t* async = (video_reader_async_t*)arg;
+    while (!__atomic_load_n(&async->stop, __ATOMIC_ACQUIRE)) {
+        void* item;
+        unsigned n_tries = 0;
+        while (!spsc_queue_pop(async->empty, &item)) {
+            if (__atomic_load_n(&async->stop, __ATOMIC_ACQUIRE))
+                return NULL;
+            _video_reader_async_backoff(&n_tries);
+        }
+        video_frame_slot_t* slot = (video_frame_slot_t*)item;
+        TIME_POINT(dec_b);
+        slot->fra_id = video_reader_get_frame(async->video, slot->img);
+        TIME_POINT(dec_e);
+        async->decode_us += TIME_ELAPSED2_US(dec_b, dec_e);
+        if (slot->fra_id != -1)
+            async->n_decoded++;
+        // cannot fail: the queue capacity is higher or equal to the number of slots
+        spsc_queue_push(async->filled, item);
+        if (slot->fra_id == -1)
+            break;
+    }
+    return NULL;
+}
+
+video_reader_async_t* video_reader_async_alloc_init(video_reader_t* video, const size_t n_frames, const int i0,
+                                                    const int i1, const int j0, const int j1) {
+    assert(n_frames >= 1);
+    video_reader_async_t* async = (video_reader_async_t*)malloc(sizeof(video_reader_async_t));
+    if (!async) {
+        fprintf(stderr, "(EE) 'video_reader_async_alloc_init' failed\n");
+        exit(1);
+    }
+    async->video = video;
+    async->n_slots = n_frames;
+    async->i0 = i0;
+    async->i1 = i1;
+    async->j0 = j0;
+    async->j1 = j1;
+    async->stop = 0;
+    async->eof = 0;
+    async->decode_us = 0.;
+    async->n_decoded = 0;
+    async->filled = spsc_queue_alloc(n_frames);
+    async->empty = spsc_queue_alloc(n_frames);
+    async->slots = (video_frame_slot_t*)malloc(n_frames * sizeof(video_frame_slot_t));
+    for (size_t s = 0; s < n_frames; s++) {
+        async->slots[s].img = ui8matrix(i0, i1, j0, j1);
+        async->slots[s].fra_id = -1;
+        spsc_queue_push(async->empty, &async->slots[s]);
+    }
+    if (pthread_create(&async->thread, NULL, _video_reader_async_decode, async)) {
+        fprintf(stderr, "(EE) Unable to create the decoder thread.\n");
+        exit(1);
+    }
+    return async;
+}
+
+int video_reader_async_get_frame(video_reader_async_t* async, uint8_t*** img) {
+    if (async->eof)
+        return -1;
+    void* item;
+    unsigned n_tries = 0;
+    while (!spsc_queue_pop(async->filled, &item))
+        _video_reader_async_backoff(&n_tries);
+    video_frame_slot_t* slot = (video_frame_slot_t*)item;
+    int fra_id = slot->fra_id;
+    if (fra_id == -1) {
+        async->eof = 1;
+        return -1;
+    }
+    uint8_t** tmp = *img;
+    *img = slot->img;
+    slot->img = tmp;
+    spsc_queue_push(async->empty, item);
+    return fra_id;
+}
+
+void video_reader_async_free(video_reader_async_t* async) {
+    __atomic_store_n(&async->stop, 1, __ATOMIC_RELEASE);
+    pthread_join(async->thread, NULL);
+    for (size_t s = 0; s < async->n_slots; s++)
+        free_ui8matrix(async->slots[s].img, async->i0, async->i1, async->j0, async->j1);
+    free(async->slots);
+    spsc_queue_free(async->filled);
+    spsc_queue_free(async->empty);
+    free(async);
+}
+
+typedef struct {
+    video_reader_t* video; /*!< Segmented video reader (the worker reads `metadata` parameters from it). */
+    size_t id; /*!< Worker id: the worker decodes the segments `id`, `id + n_workers`, `id + 2 * n_workers`, ... */
+    video_reader_t* reader; /*!< Reader opened by the main thread for the first segment (NULL otherwise). */
+    video_frame_slot_t* slots; /*!< Ring of preallocated frames. */
+    spsc_queue_t* filled; /*!< Decoded frames (worker -> pipeline), a -1 frame id ends a segment. */
+    spsc_queue_t* empty; /*!< Free frames (pipeline -> worker). */
+    pthread_t thread; /*!< Decoder thread. */
+    double decode_us; /*!< Cumulated decoding time (in us). */
+    size_t n_decoded; /*!< Number of decoded frames. */
+} video_segment_worker_t;
+
+typedef struct {
+    enum video_codec_e codec_type; /*!< Decoder used to read the segments. */
+    enum video_codec_hwaccel_e hwaccel; /*!< Hardware acceleration of the segment decoders. */
+    size_t n_ffmpeg_threads; /*!< Number of threads of each segment decoder. */
+    size_t raw_width; /*!< Frames width of a raw input. */
+    size_t raw_height; /*!< Frames height of a raw input. */
+    size_t seg_len; /*!< Number of frames in a segment. */
+    size_t n_slots; /*!< Number of frames in the ring of each worker. */
+    video_segment_worker_t* workers; /*!< Segment decoders. */
+    size_t n_workers; /*!< Number of segment decoders. */
+    size_t cur_seg; /*!< Segment currently read by the pipeline. */
+    size_t cur_seg_frames; /*!< Number of frames of `cur_seg` read by the pipeline. */
+    video_frame_slot_t* held[2]; /*!< Two last frames given to the pipeline (their views have to remain valid). */
+    spsc_queue_t* held_queue[2]; /*!< Queues where `held` frames go back. */
+    int stop; /*!< Boolean, 1 to stop the workers (accessed with atomics). */
+    int eof; /*!< Boolean, 1 when the last segment has been read. */
+    int i0, i1, j0, j1; /*!< Frames dimensions. */
+} video_metadata_segments_t;
+
+static void* _video_reader_segments_decode(void* arg) {
+    video_segment_worker_t* worker = (video_segment_worker_t*)arg;
+    video_reader_t* video = worker->video;
+    video_metadata_segments_t* metadata = (video_metadata_segments_t*)video->metadata;
+    const size_t step = 1 + video->frame_skip;
+    for (size_t seg = worker->id;; seg += metadata->n_workers) {
+        const size_t seg_start = video->frame_start + seg * metadata->seg_len * step;
+        size_t seg_end = seg_start + (metadata->seg_len - 1) * step;
+        video_reader_t* reader = worker->reader;
+        worker->reader = NULL;
+        // a segment after the end of the video has no frame, it is only marked as ended
+        if (!reader && (!video->frame_end || seg_start <= video->frame_end)) {
+            if (video->frame_end && seg_end > video->frame_end)
+                seg_end = video->frame_end;
+            int i0, i1, j0, j1;
+            reader = _video_reader_alloc_init(video->path, seg_start, seg_end, video->frame_skip, VBUF_NONE,
+                                              metadata->n_ffmpeg_threads, metadata->codec_type, metadata->hwaccel,
+                                              metadata->raw_width, metadata->raw_height, &i0, &i1, &j0, &j1);
+        }
+        size_t n_frames = 0;
+        int fra_id;
+        do {
+            void* item;
+            unsigned n_tries = 0;
+            while (!spsc_queue_pop(worker->empty, &item)) {
+                if (__atomic_load_n(&metadata->stop, __ATOMIC_ACQUIRE)) {
+                    if (reader)
+                        video_reader_free(reader);
+                    return NULL;
+                }
+                _video_reader_async_backoff(&n_tries);
+            }
+            video_frame_slot_t* slot = (video_frame_slot_t*)item;
+            TIME_POINT(dec_b);
+            fra_id = reader ? video_reader_get_frame(reader, slot->img) : -1;
+            TIME_POINT(dec_e);
+            slot->fra_id = fra_id;
+            if (fra_id != -1) {
+                worker->decode_us += TIME_ELAPSED2_US(dec_b, dec_e);
+                worker->n_decoded++;
+                n_frames++;
+            }
+            // cannot fail: the queue capacity is higher or equal to the number of slots
+            spsc_queue_push(worker->filled, item);
+        } while (fra_id != -1);
+        if (reader)
+            video_reader_free(reader);
+        // a partial segment is the last one
+        if (n_frames < metadata->seg_len)
+            return NULL;
+    }
+}
+
+static void _video_reader_segments_start(video_reader_t* video) {
+    video_metadata_segments_t* metadata = (video_metadata_segments_t*)video->metadata;
+    metadata->stop = 0;
+    metadata->eof = 0;
+    metadata->cur_seg = 0;
+    metadata->cur_seg_frames = 0;
+    for (size_t w = 0; w < metadata->n_workers; w++)
+        if (pthread_create(&metadata->workers[w].thread, NULL, _video_reader_segments_decode,
+                           &metadata->workers[w])) {
+            fprintf(stderr, "(EE) Unable to create the segment decoder threads.\n");
+            exit(1);
+        }
+}
+
+// Stops the workers and gives back all the frames to them
+static void _video_reader_segments_stop(video_reader_t* video) {
+    video_metadata_segments_t* metadata = (video_metadata_segments_t*)video->metadata;
+    __atomic_store_n(&metadata->stop, 1, __ATOMIC_RELEASE);
+    for (size_t w = 0; w < metadata->n_workers; w++) {
+        video_segment_worker_t* worker = &metadata->workers[w];
+        pthread_join(worker->thread, NULL);
+        void* item;
+        while (spsc_queue_pop(worker->filled, &item))
+            spsc_queue_push(worker->empty, item);
+    }
+    for (int h = 0; h < 2; h++)
+        if (metadata->held[h]) {
+            spsc_queue_push(metadata->held_queue[h], metadata->held[h]);
+            metadata->held[h] = NULL;
+        }
+}
+
+video_reader_t* video_reader_segments_alloc_init(const char* path, const size_t start, const size_t end,
+                                                 const size_t skip, const size_t n_segments, const size_t seg_len,
+                                                 const size_t n_frames, const size_t n_ffmpeg_threads,
+                                                 const enum video_codec_e codec_type,
+                                                 const enum video_codec_hwaccel_e hwaccel, const size_t raw_width,
+                                                 const size_t raw_height, int* i0, int* i1, int* j0, int* j1) {
+    assert(!end || start <= end);
+    assert(n_segments >= 1 && seg_len >= 1 && n_frames >= 3);
+    if (codec_type == VCDC_SHM) {
+        fprintf(stderr, "(EE) a shared-memory ring can't be decoded by segments\n");
+        exit(1);
+    }
+    video_reader_t* video = (video_reader_t*)malloc(sizeof(video_reader_t));
+    video_metadata_segments_t* metadata = (video_metadata_segments_t*)calloc(1, sizeof(video_metadata_segments_t));
+    if (!video || !metadata) {
+        fprintf(stderr, "(EE) can't allocate video structure\n");
+        exit(1);
+    }
+
+    snprintf(video->path, sizeof(video->path), "%s", path);
+    video->codec_type = VCDC_SEGMENTS;
+    video->metadata = (void*)metadata;
+    video->frame_start = start;
+    video->frame_end = end;
+    video->frame_skip = skip;
+    video->frame_current = 0;
+    video->fra_buffer = NULL;
+    video->fra_zbuffer = NULL;
+    video->fra_count = 0;
+    video->cur_loop = 1;
+    video->loop_size = 1;
+
+    metadata->codec_type = codec_type;
+    metadata->hwaccel = hwaccel;
+    metadata->n_ffmpeg_threads = n_ffmpeg_threads;
+    metadata->raw_width = raw_width;
+    metadata->raw_height = raw_height;
+    metadata->seg_len = seg_len;
+    metadata->n_slots = n_frames;
+    metadata->n_workers = n_segments;
+
+    // the first segment is opened here to get the frames size
+    size_t seg_end = start + (seg_len - 1) * (1 + skip);
+    if (end && seg_end > end)
+        seg_end = end;
+    video_reader_t* first = _video_reader_alloc_init(path, start, seg_end, skip, VBUF_NONE, n_ffmpeg_threads,
+                                                     codec_type, hwaccel, raw_width, raw_height, i0, i1, j0, j1);
+    metadata->i0 = *i0;
+    metadata->i1 = *i1;
+    metadata->j0 = *j0;
+    metadata->j1 = *j1;
+
+    metadata->workers = (video_segment_worker_t*)calloc(n_segments, sizeof(video_segment_worker_t));
+    for (size_t w = 0; w < n_segments; w++) {
+        video_segment_worker_t* worker = &metadata->workers[w];
+        worker->video = video;
+        worker->id = w;
+        worker->reader = w == 0 ? first : NULL;
+        worker->filled = spsc_queue_alloc(n_frames);
+        worker->empty = spsc_queue_alloc(n_frames);
+        worker->slots = (video_frame_slot_t*)malloc(n_frames * sizeof(video_frame_slot_t));
+        for (size_t s = 0; s < n_frames; s++) {
+            worker->slots[s].img = ui8matrix(*i0, *i1, *j0, *j1);
+            worker->slots[s].fra_id = -1;
+            spsc_queue_push(worker->empty, &worker->slots[s]);
+        }
+    }
+    _video_reader_segments_start(video);
+
+    return video;
+}
+
+int video_reader_segments_get_frame_view(video_reader_t* video, const uint8_t*** view) {
+    assert(video->codec_type == VCDC_SEGMENTS);
+    video_metadata_segments_t* metadata = (video_metadata_segments_t*)video->metadata;
+    while (1) {
+        if (metadata->eof) {
+            if (video->cur_loop >= video->loop_size)
+                return -1;
+            // restart reader
+            _video_reader_segments_stop(video);
+            video->cur_loop++;
+            _video_reader_segments_start(video);
+        }
+        video_segment_worker_t* worker = &metadata->workers[metadata->cur_seg % metadata->n_workers];
+        void* item;
+        unsigned n_tries = 0;
+        while (!spsc_queue_pop(worker->filled, &item))
+            _video_reader_async_backoff(&n_tries);
+        video_frame_slot_t* slot = (video_frame_slot_t*)item;
+        if (slot->fra_id == -1) { // end of the segment
+            spsc_queue_push(worker->empty, item);
+            if (metadata->cur_seg_frames < metadata->seg_len)
+                metadata->eof = 1;
+            else {
+                metadata->cur_seg++;
+                metadata->cur_seg_frames = 0;
+            }
+            continue;
+        }
+        metadata->cur_seg_frames++;
+        // the frame before the previous one is given back to its worker
+        if (metadata->held[0])
+            spsc_queue_push(metadata->held_queue[0], metadata->held[0]);
+        metadata->held[0] = metadata->held[1];
+        metadata->held_queue[0] = metadata->held_queue[1];
+        metadata->held[1] = slot;
+        metadata->held_queue[1] = worker->empty;
+        *view = (const uint8_t**)slot->img;
+        if (video->cur_loop == 1)
+            video->fra_count++;
+        return slot->fra_id + (int)((video->cur_loop - 1) * video->fra_count * (1 + video->frame_skip));
+    }
+}
+
+int video_reader_segments_get_frame(video_reader_t* video, uint8_t** img) {
+    video_metadata_segments_t* metadata = (video_metadata_segments_t*)video->metadata;
+    const uint8_t** view;
+    int r = video_reader_segments_get_frame_view(video, &view);
+    if (r != -1)
+        for (int i = metadata->i0; i <= metadata->i1; i++)
+            memcpy(img[i] + metadata->j0, view[i] + metadata->j0, metadata->j1 - metadata->j0 + 1);
+    return r;
+}
+
+void video_reader_segments_free(video_reader_t* video) {
+    assert(video->codec_type == VCDC_SEGMENTS);
+    video_metadata_segments_t* metadata = (video_metadata_segments_t*)video->metadata;
+    _video_reader_segments_stop(video);
+    for (size_t w = 0; w < metadata->n_workers; w++) {
+        video_segment_worker_t* worker = &metadata->workers[w];
+        if (worker->reader)
+            video_reader_free(worker->reader);
+        for (size_t s = 0; s < metadata->n_slots; s++)
+            free_ui8matrix(worker->slots[s].img, metadata->i0, metadata->i1, metadata->j0, metadata->j1);
+        free(worker->slots);
+        spsc_queue_free(worker->filled);
+        spsc_queue_free(worker->empty);
+    }
+    free(metadata->workers);
+    free(metadata);
+    free(video);
+}
+
+video_writer_t* video_writer_alloc_init(const char* path, const size_t start, const size_t n_ffmpeg_threads,
                                         const size_t img_height, const size_t img_width, const enum pixfmt_e pixfmt,
                                         const enum video_codec_e codec_type, const int win_play) {
     switch (codec_type) {
@@ -570,7 +2396,7 @@ video_writer_t* video_writer_alloc_init(const char* path, const size_t start, co
             fprintf(stderr, "(EE) vcodecs-io is not supported yet for video writer.\n");
             exit(-1);
 #else
-            fprintf(stderr, "(EE) Link with the vcodecs-io library is required.\n");
+            fprintf(stderr, "(EE) Link with the libavcodec libraries is required ('MOTION_VCODECS_IO_LINK').\n");
             exit(-1);
 #endif
         }
@@ -581,7 +2407,7 @@ video_writer_t* video_writer_alloc_init(const char* path, const size_t start, co
     }
 }
 
-void video_writer_save_frame(video_writer_t* video, const uint8_t** img) {
+static void _video_writer_save_frame(video_writer_t* video, const uint8_t** img) {
     switch (video->codec_type) {
         case VCDC_FFMPEG_IO: {
 #ifdef MOTION_USE_FFMPEG_IO
@@ -597,7 +2423,7 @@ void video_writer_save_frame(video_writer_t* video, const uint8_t** img) {
             fprintf(stderr, "(EE) vcodecs-io is not supported yet for video writer.\n");
             exit(-1);
 #else
-            fprintf(stderr, "(EE) Link with the vcodecs-io library is required.\n");
+            fprintf(stderr, "(EE) Link with the libavcodec libraries is required ('MOTION_VCODECS_IO_LINK').\n");
             exit(-1);
 #endif
         }
@@ -608,7 +2434,122 @@ void video_writer_save_frame(video_writer_t* video, const uint8_t** img) {
     }
 }
 
+static void* _video_writer_async_encode(void* arg) {
+    video_writer_t* video = (video_writer_t*)arg;
+    video_writer_async_t* async = video->async;
+    while (1) {
+        void* item;
+        unsigned n_tries = 0;
+        while (!spsc_queue_pop(async->filled, &item))
+            _video_reader_async_backoff(&n_tries);
+        video_frame_slot_t* slot = (video_frame_slot_t*)item;
+        if (slot->fra_id == -1)
+            break;
+        TIME_POINT(enc_b);
+        _video_writer_save_frame(video, (const uint8_t**)slot->img);
+        TIME_POINT(enc_e);
+        async->encode_us += TIME_ELAPSED2_US(enc_b, enc_e);
+        async->n_written++;
+        // cannot fail: the queue capacity is higher or equal to the number of slots
+        spsc_queue_push(async->empty, item);
+    }
+    return NULL;
+}
+
+void video_writer_async_start(video_writer_t* video, const size_t n_frames, const enum video_writer_policy_e policy) {
+    assert(n_frames >= 1);
+    assert(video->async == NULL);
+    // the player is kept on the caller thread (the display is not thread-safe), it stays synchronous
+    if (video->win_play)
+        return;
+    video_writer_async_t* async = (video_writer_async_t*)malloc(sizeof(video_writer_async_t));
+    if (!async) {
+        fprintf(stderr, "(EE) 'video_writer_async_start' failed\n");
+        exit(1);
+    }
+    async->n_slots = n_frames;
+    async->row_size = video->img_width * (video->pixfmt == PIXFMT_RGB24 ? 3 : 1);
+    async->policy = policy;
+    async->encode_us = 0.;
+    async->stall_us = 0.;
+    async->n_written = 0;
+    async->n_dropped = 0;
+    async->filled = spsc_queue_alloc(n_frames);
+    async->empty = spsc_queue_alloc(n_frames);
+    async->slots = (video_frame_slot_t*)malloc(n_frames * sizeof(video_frame_slot_t));
+    for (size_t s = 0; s < n_frames; s++) {
+        async->slots[s].img = ui8matrix(0, video->img_height - 1, 0, async->row_size - 1);
+        async->slots[s].fra_id = 0;
+        spsc_queue_push(async->empty, &async->slots[s]);
+    }
+    video->async = async;
+    if (pthread_create(&async->thread, NULL, _video_writer_async_encode, video)) {
+        fprintf(stderr, "(EE) Unable to create the writer thread.\n");
+        exit(1);
+    }
+}
+
+// get a free frame from the writer thread, returns NULL if the frame has to be dropped
+static video_frame_slot_t* _video_writer_async_get_slot(video_writer_async_t* async, const int can_drop) {
+    void* item;
+    if (!spsc_queue_pop(async->empty, &item)) {
+        if (can_drop && async->policy == VWRT_DROP)
+            return NULL;
+        unsigned n_tries = 0;
+        TIME_POINT(stall_b);
+        while (!spsc_queue_pop(async->empty, &item))
+            _video_reader_async_backoff(&n_tries);
+        TIME_POINT(stall_e);
+        async->stall_us += TIME_ELAPSED2_US(stall_b, stall_e);
+    }
+    return (video_frame_slot_t*)item;
+}
+
+void video_writer_save_frame(video_writer_t* video, const uint8_t** img) {
+    video_writer_async_t* async = video->async;
+    if (!async) {
+        _video_writer_save_frame(video, img);
+        return;
+    }
+    video_frame_slot_t* slot = _video_writer_async_get_slot(async, 1);
+    if (!slot) {
+        async->n_dropped++;
+        return;
+    }
+    for (size_t i = 0; i < video->img_height; i++)
+        memcpy(slot->img[i], img[i], async->row_size);
+    spsc_queue_push(async->filled, slot);
+}
+
+void video_writer_flush(video_writer_t* video) {
+    video_writer_async_t* async = video->async;
+    if (!async)
+        return;
+    // all the frames are back in the `empty` queue when the writer thread is idle
+    unsigned n_tries = 0;
+    while (spsc_queue_size(async->empty) < async->n_slots)
+        _video_reader_async_backoff(&n_tries);
+}
+
+// encode the remaining frames and stop the writer thread
+static void _video_writer_async_stop(video_writer_t* video) {
+    video_writer_async_t* async = video->async;
+    video_frame_slot_t* slot = _video_writer_async_get_slot(async, 0);
+    slot->fra_id = -1;
+    spsc_queue_push(async->filled, slot);
+    pthread_join(async->thread, NULL);
+    for (size_t s = 0; s < async->n_slots; s++)
+        free_ui8matrix(async->slots[s].img, 0, video->img_height - 1, 0, async->row_size - 1);
+    free(async->slots);
+    spsc_queue_free(async->filled);
+    spsc_queue_free(async->empty);
+    free(async);
+    video->async = NULL;
+}
+
 void video_writer_free(video_writer_t* video) {
+    if (video->async)
+        _video_writer_async_stop(video);
     switch (video->codec_type) {
         case VCDC_FFMPEG_IO: {
 #ifdef MOTION_USE_FFMPEG_IO
@@ -624,7 +2565,7 @@ void video_writer_free(video_writer_t* video) {
             fprintf(stderr, "(EE) vcodecs-io is not supported yet for video writer.\n");
             exit(-1);
 #else
-            fprintf(stderr, "(EE) Link with the vcodecs-io library is required.\n");
+            fprintf(stderr, "(EE) Link with the libavcodec libraries is required ('MOTION_VCODECS_IO_LINK').\n");
             exit(-1);
 #endif
         }
@@ -8,13 +8,14 @@ enum video_codec_e video_str_to_enum(const char* str) {
     if (strcmp(str, "FFMPEG-IO") == 0) {
         return VCDC_FFMPEG_IO;
     } else if (strcmp(str, "VCODECS-IO") == 0) {
-#ifdef MOTION_USE_VCODECS_IO
-        return VCDC_VCODECS_IO;
-#else
-        fprintf(stderr, "(EE) '%s()' failed, 'VCODECS-IO' implementation requires to link with the vcodecs-io library.\n",
-            __func__);
+        // the libavformat/libavcodec reader (`MOTION_VCODECS_IO_LINK`) has not been validated against ffmpeg-io yet
+        fprintf(stderr, "(EE) '%s()' failed, the 'VCODECS-IO' decoder is not available yet, use 'FFMPEG-IO'.\n",
+                __func__);
         exit(-1);
-#endif
+    } else if (strcmp(str, "NATIVE") == 0) {
+        return VCDC_NATIVE;
+    } else if (strcmp(str, "SHM") == 0) {
+        return VCDC_SHM;
     } else {
         fprintf(stderr, "(EE) '%s()' failed, unknow input ('%s').\n", __func__, str);
         exit(-1);
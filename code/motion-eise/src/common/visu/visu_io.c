@@ -13,7 +13,7 @@
 visu_data_t* visu_alloc_init(const char* path, const size_t start, const size_t n_ffmpeg_threads,
                              const size_t img_height, const size_t img_width, const enum pixfmt_e pixfmt,
                              const enum video_codec_e codec_type, const uint8_t draw_track_id,
-                             const int win_play, const size_t buff_size, const size_t max_RoIs_size,
+                             const int win_play, const size_t buff_size, frame_pool_t* frame_pool,
                              const uint8_t skip_fra) {
     assert(buff_size > 0);
     visu_data_t* visu = (visu_data_t*)malloc(sizeof(visu_data_t));
@@ -26,13 +26,12 @@ visu_data_t* visu_alloc_init(const char* path, const size_t start, const size_t
     visu->buff_id_read = 0;
     visu->buff_id_write = 0;
     visu->n_filled_buff = 0;
-    visu->I = (uint8_t***)malloc(visu->buff_size * sizeof(uint8_t**));
-    visu->RoIs = (RoI_t**)malloc(visu->buff_size * sizeof(RoI_t**));
+    visu->own_pool = frame_pool == NULL;
+    visu->frame_pool = frame_pool ? frame_pool : frame_pool_alloc(buff_size, 0, img_height - 1, 0, img_width - 1);
+    visu->frames = (frame_t**)malloc(visu->buff_size * sizeof(frame_t*));
+    visu->RoIs = (RoI_t**)calloc(visu->buff_size, sizeof(RoI_t*));
+    visu->RoIs_size = (size_t*)calloc(visu->buff_size, sizeof(size_t));
     visu->frame_ids = (uint32_t*)malloc(visu->buff_size * sizeof(uint32_t));
-    for (size_t i = 0; i < visu->buff_size; i++) {
-        visu->I[i] = ui8matrix(0, visu->img_height + 1, 0, visu->img_width + 1);
-        visu->RoIs[i] = features_alloc_RoIs(max_RoIs_size);
-    }
     visu->img_data = image_color_alloc(img_height, img_width);
     visu->BBs = (vec_BB_t)vector_create();
     visu->BBs_color = (vec_color_e)vector_create();
@@ -68,10 +67,10 @@ void _visu_write_or_play(visu_data_t* visu, const vec_track_t tracks) {
         const uint32_t track_id = tracks[i].id;
         if (track_id && (tracks[i].end.frame >= frame_id && tracks[i].begin.frame <= frame_id)) {
             const size_t offset = (tracks[i].end.frame - frame_id) / (visu->skip_fra + 1);
-            assert(tracks[i].RoIs_id != NULL);
-            const size_t RoIs_id_size = vector_size(tracks[i].RoIs_id);
+            assert(tracks[i].RoIs_id.head != NULL);
+            const size_t RoIs_id_size = tracks[i].RoIs_id.size;
             assert(RoIs_id_size > offset);
-            const uint32_t RoI_id = tracks[i].RoIs_id[(RoIs_id_size - 1) - offset];
+            const uint32_t RoI_id = tracking_RoIs_id_get(&tracks[i].RoIs_id, (RoIs_id_size - 1) - offset);
 
             RoI_t *RoIs_tmp = visu->RoIs[real_buff_id_read];
             if (RoI_id) {
@@ -89,7 +88,7 @@ void _visu_write_or_play(visu_data_t* visu, const vec_track_t tracks) {
     }
 
     const int is_gt_path = 0;
-    image_color_draw_BBs(visu->img_data, (const uint8_t**)visu->I[real_buff_id_read], (const BB_t*)visu->BBs,
+    image_color_draw_BBs(visu->img_data, (const uint8_t**)visu->frames[real_buff_id_read]->img, (const BB_t*)visu->BBs,
                          (const enum color_e*)visu->BBs_color, cpt, visu->draw_track_id, is_gt_path);
 
 #ifdef MOTION_OPENCV_LINK
@@ -97,9 +96,10 @@ void _visu_write_or_play(visu_data_t* visu, const vec_track_t tracks) {
 #endif
 
     video_writer_save_frame(visu->video_writer, (const uint8_t**)image_color_get_pixels_2d(visu->img_data));
+    frame_release(visu->frames[real_buff_id_read]);
 }
 
-void visu_display(visu_data_t* visu, const uint8_t** img, const RoI_t* RoIs, const size_t n_RoIs,
+void visu_display(visu_data_t* visu, frame_t* frame, const uint8_t** img, const RoI_t* RoIs, const size_t n_RoIs,
                   const vec_track_t tracks, const uint32_t frame_id) {
     // ------------------------
     // write or play image ----
@@ -117,8 +117,20 @@ void visu_display(visu_data_t* visu, const uint8_t** img, const RoI_t* RoIs, con
     assert(visu->n_filled_buff <= visu->buff_size);
 
     const size_t real_buff_id_write = visu->buff_id_write % visu->buff_size;
-    for (size_t i = 0; i < visu->img_height; i++)
-        memcpy(visu->I[real_buff_id_write][i], img[i], visu->img_width * sizeof(uint8_t));
+    if (frame && frame->pool == visu->frame_pool && (const uint8_t**)frame->img == img) {
+        frame_retain(frame);
+    } else {
+        frame = frame_pool_acquire(visu->frame_pool);
+        for (size_t i = 0; i < visu->img_height; i++)
+            memcpy(frame->img[i], img[i], visu->img_width * sizeof(uint8_t));
+    }
+    visu->frames[real_buff_id_write] = frame;
+    // only the used RoIs are kept
+    if (visu->RoIs_size[real_buff_id_write] < n_RoIs) {
+        visu->RoIs_size[real_buff_id_write] = 2 * n_RoIs;
+        visu->RoIs[real_buff_id_write] = (RoI_t*)realloc(visu->RoIs[real_buff_id_write],
+                                                         visu->RoIs_size[real_buff_id_write] * sizeof(RoI_t));
+    }
     memcpy(visu->RoIs[real_buff_id_write], RoIs, n_RoIs * sizeof(RoI_t));
     visu->frame_ids[real_buff_id_write] = frame_id;
 
@@ -126,6 +138,12 @@ void visu_display(visu_data_t* visu, const uint8_t** img, const RoI_t* RoIs, con
     visu->buff_id_write++;
 }
 
+uint32_t visu_get_oldest_frame_id(const visu_data_t* visu) {
+    if (!visu->n_filled_buff)
+        return UINT32_MAX;
+    return visu->frame_ids[visu->buff_id_read % visu->buff_size];
+}
+
 void visu_flush(visu_data_t* visu, const vec_track_t tracks) {
     while (visu->n_filled_buff) {
         _visu_write_or_play(visu, tracks);
@@ -137,12 +155,16 @@ void visu_flush(visu_data_t* visu, const vec_track_t tracks) {
 
 void visu_free(visu_data_t* visu) {
     video_writer_free(visu->video_writer);
-    for (size_t i = 0; i < visu->buff_size; i++) {
-        free_ui8matrix(visu->I[i], 0, visu->img_height + 1, 0, visu->img_width + 1);
-        features_free_RoIs(visu->RoIs[i]);
-    }
-    free(visu->I);
+    // the frames that have not been displayed are still referenced
+    for (; visu->n_filled_buff; visu->n_filled_buff--, visu->buff_id_read++)
+        frame_release(visu->frames[visu->buff_id_read % visu->buff_size]);
+    if (visu->own_pool)
+        frame_pool_free(visu->frame_pool);
+    for (size_t i = 0; i < visu->buff_size; i++)
+        free(visu->RoIs[i]);
+    free(visu->frames);
     free(visu->RoIs);
+    free(visu->RoIs_size);
     free(visu->frame_ids);
     image_color_free(visu->img_data);
     vector_free(visu->BBs);
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <nrc2.h>
+
+#include "motion/args.h"
+#include "motion/features.h"
+#include "motion/image.h"
+#include "motion/log.h"
+#include "motion/macros.h"
+#include "motion/video.h"
+
+int main(int argc, char** argv) {
+
+    // ---------------------------------- //
+    // -- DEFAULT VALUES OF PARAMETERS -- //
+    // ---------------------------------- //
+
+    char* def_p_ccl_runs = NULL;
+    char* def_p_ccl_fra_path = NULL;
+
+    // ------------------------ //
+    // -- CMD LINE ARGS HELP -- //
+    // ------------------------ //
+
+    if (args_find(argc, argv, "--help,-h")) {
+        fprintf(stderr,
+                "  --ccl-runs        Path of the CC runs file written by 'motion --ccl-fra-runs'            [%s]\n",
+                def_p_ccl_runs ? def_p_ccl_runs : "NULL");
+        fprintf(stderr,
+                "  --ccl-fra-path    Path of the files for CC debug frames (as 'motion --ccl-fra-path')     [%s]\n",
+                def_p_ccl_fra_path ? def_p_ccl_fra_path : "NULL");
+#ifdef MOTION_OPENCV_LINK
+        fprintf(stderr,
+                "  --ccl-fra-id      Show the RoI/CC ids on the ouptut CC frames                                \n");
+#endif
+        fprintf(stderr,
+                "  --help, -h        This help                                                                  \n");
+        exit(1);
+    }
+
+    // ------------------------- //
+    // -- PARSE CMD LINE ARGS -- //
+    // ------------------------- //
+
+    const char* p_ccl_runs = args_find_char(argc, argv, "--ccl-runs", def_p_ccl_runs);
+    const char* p_ccl_fra_path = args_find_char(argc, argv, "--ccl-fra-path", def_p_ccl_fra_path);
+#ifdef MOTION_OPENCV_LINK
+    const int p_ccl_fra_id = args_find(argc, argv, "--ccl-fra-id,--show-id");
+#else
+    const int p_ccl_fra_id = 0;
+#endif
+
+    // -------------------------- //
+    // -- CMD LINE ARGS CHECKS -- //
+    // -------------------------- //
+
+    if (!p_ccl_runs) {
+        fprintf(stderr, "(EE) '--ccl-runs' is missing\n");
+        exit(1);
+    }
+    if (!p_ccl_fra_path) {
+        fprintf(stderr, "(EE) '--ccl-fra-path' is missing\n");
+        exit(1);
+    }
+
+    // --------------------------------------- //
+    // -- DATA ALLOCATION & INITIALISATION -- //
+    // --------------------------------------- //
+
+    log_runs_reader_t* runs = log_runs_reader_alloc_init(p_ccl_runs);
+    const int i0 = 0, i1 = runs->height - 1, j0 = 0, j1 = runs->width - 1;
+    uint32_t** labels = ui32matrix(i0, i1, j0, j1);
+    zero_ui32matrix(labels, i0, i1, j0, j1);
+    img_data_t* img_data = image_gs_alloc(runs->height, runs->width);
+    const size_t n_threads = 1;
+    video_writer_t* video_writer = video_writer_alloc_init(p_ccl_fra_path, runs->start, n_threads, runs->height,
+                                                           runs->width, PIXFMT_GRAY, VCDC_FFMPEG_IO, 0);
+    size_t max_RoIs = 0;
+    RoI_t* RoIs = NULL;
+    uint64_t* Sx = NULL;
+    uint64_t* Sy = NULL;
+
+    // ----------------//
+    // -- PROCESSING --//
+    // ----------------//
+
+    size_t n_frames = 0;
+    log_runs_frame_t frame;
+    while (log_runs_reader_next(runs, &frame)) {
+        if (max_RoIs < frame.n_labels) {
+            max_RoIs = 2 * frame.n_labels;
+            RoIs = (RoI_t*)realloc(RoIs, max_RoIs * sizeof(RoI_t));
+            Sx = (uint64_t*)realloc(Sx, max_RoIs * sizeof(uint64_t));
+            Sy = (uint64_t*)realloc(Sy, max_RoIs * sizeof(uint64_t));
+        }
+        // rebuild the image of labels and the RoIs (the bounding boxes and the centroids) from the runs
+        for (uint32_t l = 0; l < frame.n_labels; l++) {
+            memset(&RoIs[l], 0, sizeof(RoI_t));
+            RoIs[l].id = l + 1;
+            RoIs[l].xmin = UINT32_MAX;
+            RoIs[l].ymin = UINT32_MAX;
+            Sx[l] = Sy[l] = 0;
+        }
+        for (uint32_t r = 0; r < frame.n_runs; r++) {
+            const log_run_t* run = &runs->runs[r];
+            RoI_t* RoI = &RoIs[run->label - 1];
+            const uint32_t len = run->end - run->start + 1;
+            for (uint32_t j = run->start; j <= run->end; j++)
+                labels[run->row][j] = run->label;
+            RoI->xmin = MIN(RoI->xmin, (uint32_t)run->start);
+            RoI->xmax = MAX(RoI->xmax, (uint32_t)run->end);
+            RoI->ymin = MIN(RoI->ymin, (uint32_t)run->row);
+            RoI->ymax = MAX(RoI->ymax, (uint32_t)run->row);
+            RoI->S += len;
+            Sx[run->label - 1] += (uint64_t)len * (run->start + run->end) / 2;
+            Sy[run->label - 1] += (uint64_t)len * run->row;
+        }
+        for (uint32_t l = 0; l < frame.n_labels; l++) {
+            RoIs[l].x = (float)Sx[l] / (float)RoIs[l].S;
+            RoIs[l].y = (float)Sy[l] / (float)RoIs[l].S;
+        }
+
+        image_gs_draw_labels(img_data, (const uint32_t**)labels, RoIs, frame.n_labels, p_ccl_fra_id);
+        video_writer_save_frame(video_writer, (const uint8_t**)image_gs_get_pixels_2d(img_data));
+
+        // clear the labels for the next frame
+        for (uint32_t r = 0; r < frame.n_runs; r++) {
+            const log_run_t* run = &runs->runs[r];
+            memset(&labels[run->row][run->start], 0, (run->end - run->start + 1) * sizeof(uint32_t));
+        }
+        n_frames++;
+    }
+    fprintf(stderr, "(II) %lu frame(s) rendered\n", (unsigned long)n_frames);
+
+    // ---------- //
+    // -- FREE -- //
+    // ---------- //
+
+    video_writer_free(video_writer);
+    image_gs_free(img_data);
+    free_ui32matrix(labels, i0, i1, j0, j1);
+    free(RoIs);
+    free(Sx);
+    free(Sy);
+    log_runs_reader_free(runs);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "motion/args.h"
+#include "motion/log.h"
+
+int main(int argc, char** argv) {
+
+    // ---------------------------------- //
+    // -- DEFAULT VALUES OF PARAMETERS -- //
+    // ---------------------------------- //
+
+    char* def_p_log_bin = NULL;
+    char* def_p_log_path = NULL;
+
+    // ------------------------ //
+    // -- CMD LINE ARGS HELP -- //
+    // ------------------------ //
+
+    if (args_find(argc, argv, "--help,-h")) {
+        fprintf(stderr,
+                "  --log-bin         Path of the binary log written by 'motion --log-bin'                   [%s]\n",
+                def_p_log_bin ? def_p_log_bin : "NULL");
+        fprintf(stderr,
+                "  --log-path        Path of the output text logs (same files as 'motion --log-path')       [%s]\n",
+                def_p_log_path ? def_p_log_path : "NULL");
+        fprintf(stderr,
+                "  --help, -h        This help                                                                  \n");
+        exit(1);
+    }
+
+    // ------------------------- //
+    // -- PARSE CMD LINE ARGS -- //
+    // ------------------------- //
+
+    const char* p_log_bin = args_find_char(argc, argv, "--log-bin", def_p_log_bin);
+    const char* p_log_path = args_find_char(argc, argv, "--log-path", def_p_log_path);
+
+    // -------------------------- //
+    // -- CMD LINE ARGS CHECKS -- //
+    // -------------------------- //
+
+    if (!p_log_bin) {
+        fprintf(stderr, "(EE) '--log-bin' is missing\n");
+        exit(1);
+    }
+    if (!p_log_path) {
+        fprintf(stderr, "(EE) '--log-path' is missing\n");
+        exit(1);
+    }
+
+    // ----------------//
+    // -- PROCESSING --//
+    // ----------------//
+
+    size_t n_frames = log_convert_text(p_log_bin, p_log_path);
+    fprintf(stderr, "(II) %lu frame(s) converted\n", (unsigned long)n_frames);
+
+    return EXIT_SUCCESS;
+}
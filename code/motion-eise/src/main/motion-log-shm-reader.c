@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "motion/args.h"
+#include "motion/log.h"
+
+int main(int argc, char** argv) {
+
+    // ---------------------------------- //
+    // -- DEFAULT VALUES OF PARAMETERS -- //
+    // ---------------------------------- //
+
+    char* def_p_log_shm = NULL;
+
+    // ------------------------ //
+    // -- CMD LINE ARGS HELP -- //
+    // ------------------------ //
+
+    if (args_find(argc, argv, "--help,-h")) {
+        fprintf(stderr,
+                "  --log-shm         Path of the shared-memory ring written by 'motion --log-shm' (waited)  [%s]\n",
+                def_p_log_shm ? def_p_log_shm : "NULL");
+        fprintf(stderr,
+                "  --verbose         Print the RoIs and the updated tracks of each frame                        \n");
+        fprintf(stderr,
+                "  --help, -h        This help                                                                  \n");
+        exit(1);
+    }
+
+    // ------------------------- //
+    // -- PARSE CMD LINE ARGS -- //
+    // ------------------------- //
+
+    const char* p_log_shm = args_find_char(argc, argv, "--log-shm", def_p_log_shm);
+    const int p_verbose = args_find(argc, argv, "--verbose");
+
+    // -------------------------- //
+    // -- CMD LINE ARGS CHECKS -- //
+    // -------------------------- //
+
+    if (!p_log_shm) {
+        fprintf(stderr, "(EE) '--log-shm' is missing\n");
+        exit(1);
+    }
+
+    // ----------------//
+    // -- PROCESSING --//
+    // ----------------//
+
+    // wait for the producer
+    while (access(p_log_shm, F_OK))
+        usleep(10000);
+    log_shm_reader_t* shm = log_shm_reader_alloc_init(p_log_shm);
+    const char* str_states[N_STATES] = {"UKN", "UPD", "LST", "FNS"};
+    size_t n_records = 0, n_invalid = 0;
+    // the records are printed in a local buffer first: a record is printed only if it is still valid once read
+    char* buf = NULL;
+    size_t buf_size = 0;
+    const log_shm_record_t* rec;
+    int r;
+    while ((r = log_shm_reader_next(shm, &rec)) != -1) {
+        if (r == 0) {
+            usleep(1000);
+            continue;
+        }
+        const size_t max_size = 64 + (p_verbose ? (rec->n_RoIs + rec->n_tracks) * 128 : 0);
+        if (buf_size < max_size) {
+            buf_size = 2 * max_size;
+            buf = (char*)realloc(buf, buf_size);
+        }
+        const log_RoI_t* RoIs = (const log_RoI_t*)(rec + 1);
+        const log_track_t* tracks = (const log_track_t*)(RoIs + rec->n_RoIs);
+        size_t n = snprintf(buf, buf_size, "frame %5d: %4u RoI(s), %4u track update(s)\n", rec->frame, rec->n_RoIs,
+                            rec->n_tracks);
+        for (uint32_t i = 0; p_verbose && i < rec->n_RoIs; i++)
+            n += snprintf(buf + n, buf_size - n, "  RoI %4u track %5u bb [%4u,%4u]x[%4u,%4u] S %7u c (%7.1f,%7.1f)\n",
+                          RoIs[i].id, RoIs[i].track_id, RoIs[i].xmin, RoIs[i].xmax, RoIs[i].ymin, RoIs[i].ymax,
+                          RoIs[i].S, RoIs[i].x, RoIs[i].y);
+        for (uint32_t t = 0; p_verbose && t < rec->n_tracks; t++)
+            n += snprintf(buf + n, buf_size - n, "  track %5u %s begin %5u (%6.1f,%6.1f) end %5u (%6.1f,%6.1f)\n",
+                          tracks[t].id, tracks[t].state < N_STATES ? str_states[tracks[t].state] : "???",
+                          tracks[t].begin_frame, tracks[t].begin_x, tracks[t].begin_y, tracks[t].end_frame,
+                          tracks[t].end_x, tracks[t].end_y);
+        if (!log_shm_reader_check(shm)) {
+            n_invalid++;
+            continue;
+        }
+        fwrite(buf, 1, n, stdout);
+        n_records++;
+    }
+    fprintf(stderr, "(II) %lu record(s) read, %lu lost, %lu overwritten while being read\n",
+            (unsigned long)n_records, (unsigned long)shm->n_lost, (unsigned long)n_invalid);
+
+    // ----------
+    // -- FREE --
+    // ----------
+
+    free(buf);
+    log_shm_reader_free(shm);
+
+    return EXIT_SUCCESS;
+}
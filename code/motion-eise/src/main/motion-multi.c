@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "motion/args.h"
+#include "motion/macros.h"
+#include "motion/video.h"
+#include "motion/tracking.h"
+#include "motion/pipeline.h"
+#include "motion/libmotion.h"
+#include "motion/streams.h"
+
+int main(int argc, char** argv) {
+
+    // ---------------------------------- //
+    // -- DEFAULT VALUES OF PARAMETERS -- //
+    // ---------------------------------- //
+
+    motion_params_t def; // the same detection and tracking defaults as the library (and as `motion`)
+    motion_params_default(&def, 0, 0);
+    char* def_p_vid_in_path = NULL;
+    char def_p_vid_in_codec[16] = "FFMPEG-IO";
+    int def_p_mst_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int def_p_mst_quantum = 4;
+    char* def_p_pip_stages = NULL;
+
+    // ------------------------ //
+    // -- CMD LINE ARGS HELP -- //
+    // ------------------------ //
+
+    if (args_find(argc, argv, "--help,-h")) {
+        fprintf(stderr,
+                "  --vid-in-path     Comma separated paths of the videos (one stream per video)             [%s]\n",
+                def_p_vid_in_path ? def_p_vid_in_path : "NULL");
+        fprintf(stderr,
+                "  --vid-in-codec    Select the video decoder ('FFMPEG-IO', 'NATIVE')                       [%s]\n",
+                def_p_vid_in_codec);
+        fprintf(stderr,
+                "  --mst-threads     Number of threads shared by the streams                                [%d]\n",
+                def_p_mst_threads);
+        fprintf(stderr,
+                "  --mst-quantum     Number of frames of a stream processed in a row (fairness)             [%d]\n",
+                def_p_mst_quantum);
+        fprintf(stderr,
+                "  --sd-n            Value of the N parameter in the Sigma-Delta algorithm                  [%d]\n",
+                def.chain.sd_n);
+        fprintf(stderr,
+                "  --sd-scale        Detection downscale factor (lossy above 2), RoIs refined in full res   [%d]\n",
+                def.chain.sd_scale);
+        fprintf(stderr,
+                "  --cca-roi-max1    Maximum number of RoIs after CCA                                       [%d]\n",
+                (int)def.chain.cca_roi_max1);
+        fprintf(stderr,
+                "  --cca-roi-max2    Maximum number of RoIs after surface filtering                         [%d]\n",
+                (int)def.chain.cca_roi_max2);
+        fprintf(stderr,
+                "  --flt-s-min       Minimum surface of the CCs in pixels                                   [%d]\n",
+                (int)def.chain.flt_s_min);
+        fprintf(stderr,
+                "  --flt-s-max       Maxumum surface of the CCs in pixels                                   [%d]\n",
+                (int)def.chain.flt_s_max);
+        fprintf(stderr,
+                "  --knn-k           Maximum number of neighbors considered in k-NN algorithm               [%d]\n",
+                def.chain.knn_k);
+        fprintf(stderr,
+                "  --knn-d           Maximum distance in pixels between two images (in k-NN)                [%d]\n",
+                (int)def.chain.knn_d);
+        fprintf(stderr,
+                "  --knn-s           Minimum surface ratio to match two CCs in k-NN                         [%f]\n",
+                def.chain.knn_s);
+        fprintf(stderr,
+                "  --trk-ext-d       Search radius in pixels for CC extrapolation (piece-wise tracking)     [%d]\n",
+                (int)def.chain.trk_ext_d);
+        fprintf(stderr,
+                "  --trk-ext-o       Maximum number of frames to extrapolate (linear) for lost objects      [%d]\n",
+                def.chain.trk_ext_o);
+        fprintf(stderr,
+                "  --trk-obj-min     Minimum number of frames required to track an object                   [%d]\n",
+                (int)def.chain.trk_obj_min);
+        fprintf(stderr,
+                "  --pip-stages      Stages of the processing chain, e.g. 'mrp=open3' (see '--pip-list')    [%s]\n",
+                def_p_pip_stages ? def_p_pip_stages : "NULL");
+        fprintf(stderr,
+                "  --pip-list        List the available stages of the processing chain and exit                 \n");
+        fprintf(stderr,
+                "  --stats           Show the statistics of the streams and of the threads                      \n");
+        fprintf(stderr,
+                "  --help, -h        This help                                                                  \n");
+        exit(1);
+    }
+
+    // ------------------------- //
+    // -- PARSE CMD LINE ARGS -- //
+    // ------------------------- //
+
+    const char* p_vid_in_path = args_find_char(argc, argv, "--vid-in-path", def_p_vid_in_path);
+    const char* p_vid_in_codec = args_find_char(argc, argv, "--vid-in-codec", def_p_vid_in_codec);
+    const int p_mst_threads = args_find_int_min(argc, argv, "--mst-threads", def_p_mst_threads, 1);
+    const int p_mst_quantum = args_find_int_min(argc, argv, "--mst-quantum", def_p_mst_quantum, 1);
+    const int p_sd_n = args_find_int_min(argc, argv, "--sd-n", def.chain.sd_n, 0);
+    const int p_sd_scale = args_find_int_min_max(argc, argv, "--sd-scale", def.chain.sd_scale, 1, 16);
+    const int p_cca_roi_max1 = args_find_int_min(argc, argv, "--cca-roi-max1", def.chain.cca_roi_max1, 0);
+    const int p_cca_roi_max2 = args_find_int_min(argc, argv, "--cca-roi-max2", def.chain.cca_roi_max2, 0);
+    const int p_flt_s_min = args_find_int_min(argc, argv, "--flt-s-min", def.chain.flt_s_min, 0);
+    const int p_flt_s_max = args_find_int_min(argc, argv, "--flt-s-max", def.chain.flt_s_max, 0);
+    const int p_knn_k = args_find_int_min(argc, argv, "--knn-k", def.chain.knn_k, 0);
+    const int p_knn_d = args_find_int_min(argc, argv, "--knn-d", def.chain.knn_d, 0);
+    const float p_knn_s = args_find_float_min_max(argc, argv, "--knn-s", def.chain.knn_s, 0.f, 1.f);
+    const int p_trk_ext_d = args_find_int_min(argc, argv, "--trk-ext-d", def.chain.trk_ext_d, 0);
+    const int p_trk_ext_o = args_find_int_min_max(argc, argv, "--trk-ext-o", def.chain.trk_ext_o, 0, 255);
+    const int p_trk_obj_min = args_find_int_min(argc, argv, "--trk-obj-min", def.chain.trk_obj_min, 2);
+    const char* p_pip_stages = args_find_char(argc, argv, "--pip-stages", def_p_pip_stages);
+    const int p_stats = args_find(argc, argv, "--stats");
+
+    if (args_find(argc, argv, "--pip-list")) {
+        printf("Stages of the processing chain ('step=name', for '--pip-stages'):\n");
+        pipeline_registry_print(stdout);
+        exit(0);
+    }
+
+    // --------------------- //
+    // -- HEADING DISPLAY -- //
+    // --------------------- //
+
+    printf("#  ---------------- \n");
+    printf("# |  MOTION-MULTI  |\n");
+    printf("#  ---------------- \n");
+    printf("#\n");
+    printf("# Parameters:\n");
+    printf("# -----------\n");
+    printf("#  * vid-in-path    = %s\n", p_vid_in_path);
+    printf("#  * vid-in-codec   = %s\n", p_vid_in_codec);
+    printf("#  * mst-threads    = %d\n", p_mst_threads);
+    printf("#  * mst-quantum    = %d\n", p_mst_quantum);
+    printf("#  * sd-n           = %d\n", p_sd_n);
+    printf("#  * sd-scale       = %d\n", p_sd_scale);
+    printf("#  * cca-roi-max1   = %d\n", p_cca_roi_max1);
+    printf("#  * cca-roi-max2   = %d\n", p_cca_roi_max2);
+    printf("#  * flt-s-min      = %d\n", p_flt_s_min);
+    printf("#  * flt-s-max      = %d\n", p_flt_s_max);
+    printf("#  * knn-k          = %d\n", p_knn_k);
+    printf("#  * knn-d          = %d\n", p_knn_d);
+    printf("#  * knn-s          = %1.3f\n", p_knn_s);
+    printf("#  * trk-ext-d      = %d\n", p_trk_ext_d);
+    printf("#  * trk-ext-o      = %d\n", p_trk_ext_o);
+    printf("#  * trk-obj-min    = %d\n", p_trk_obj_min);
+    printf("#  * pip-stages     = %s\n", p_pip_stages);
+    printf("#  * stats          = %d\n", p_stats);
+    printf("#\n");
+
+    // -------------------------- //
+    // -- CMD LINE ARGS CHECKS -- //
+    // -------------------------- //
+
+    if (!p_vid_in_path) {
+        fprintf(stderr, "(EE) '--vid-in-path' is missing\n");
+        exit(1);
+    }
+    if (p_sd_scale > 2)
+        fprintf(stderr, "(WW) '--sd-scale' above 2 is lossy (the small CCs are lost and the large ones are split)\n");
+
+    // --------------------------------------- //
+    // -- DATA ALLOCATION & INITIALISATION -- //
+    // --------------------------------------- //
+
+    // split the list of videos
+    char* paths_buf = strdup(p_vid_in_path);
+    size_t n_streams = 0;
+    const char** paths = (const char**)malloc((strlen(paths_buf) / 2 + 1) * sizeof(const char*));
+    for (char* path = strtok(paths_buf, ","); path; path = strtok(NULL, ","))
+        paths[n_streams++] = path;
+    if (!n_streams) {
+        fprintf(stderr, "(EE) '--vid-in-path' does not contain any path\n");
+        exit(1);
+    }
+
+    motion_params_t params = def;
+    params.chain.sd_scale = p_sd_scale;
+    params.chain.sd_n = (uint8_t)p_sd_n;
+    params.chain.cca_roi_max1 = (size_t)p_cca_roi_max1;
+    params.chain.cca_roi_max2 = (size_t)p_cca_roi_max2;
+    params.chain.flt_s_min = (uint32_t)p_flt_s_min;
+    params.chain.flt_s_max = (uint32_t)p_flt_s_max;
+    params.chain.knn_k = p_knn_k;
+    params.chain.knn_d = (uint32_t)p_knn_d;
+    params.chain.knn_s = p_knn_s;
+    params.chain.trk_ext_d = (size_t)p_trk_ext_d;
+    params.chain.trk_ext_o = (uint8_t)p_trk_ext_o;
+    params.chain.trk_obj_min = (size_t)p_trk_obj_min;
+    params.stages = p_pip_stages;
+    streams_t* engine = streams_alloc_init(paths, n_streams, &params, video_str_to_enum(p_vid_in_codec),
+                                           (size_t)p_mst_threads, (size_t)p_mst_quantum);
+
+    // ----------------//
+    // -- PROCESSING --//
+    // ----------------//
+
+    printf("# The program is running (%lu stream(s) on %d thread(s))...\n", (unsigned long)n_streams, p_mst_threads);
+    streams_run(engine);
+
+    size_t n_frames = 0;
+    for (size_t s = 0; s < n_streams; s++) {
+        const track_t* tracks;
+        motion_pipeline_get_tracks(engine->streams[s].mp, &tracks);
+        printf("# Stream n°%lu: %s\n", (unsigned long)s, paths[s]);
+        tracking_tracks_write(stdout, (const vec_track_t)tracks);
+        n_frames += engine->streams[s].n_frames;
+    }
+    printf("# -> Processed frames = %4lu\n", (unsigned long)n_frames);
+    printf("# -> Took %6.3f seconds (avg %d FPS)\n", engine->run_us * 1e-6,
+           (int)(engine->run_us > 0. ? n_frames / (engine->run_us * 1e-6) : 0.));
+    if (p_stats) {
+        printf("#\n");
+        streams_stats_print(stdout, engine);
+    }
+
+    // ---------- //
+    // -- FREE -- //
+    // ---------- //
+
+    streams_free(engine);
+    free(paths);
+    free(paths_buf);
+
+    return EXIT_SUCCESS;
+}
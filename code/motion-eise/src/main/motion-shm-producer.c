@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <nrc2.h>
+
+#include "motion/args.h"
+#include "motion/macros.h"
+#include "motion/video.h"
+
+int main(int argc, char** argv) {
+
+    // ---------------------------------- //
+    // -- DEFAULT VALUES OF PARAMETERS -- //
+    // ---------------------------------- //
+
+    char* def_p_vid_in_path = NULL;
+    char def_p_vid_in_codec[16] = "FFMPEG-IO";
+    char* def_p_vid_in_size = NULL;
+    char* def_p_shm_path = NULL;
+    int def_p_shm_slots = 8;
+    float def_p_shm_fps = 0.f;
+
+    // ------------------------ //
+    // -- CMD LINE ARGS HELP -- //
+    // ------------------------ //
+
+    if (args_find(argc, argv, "--help,-h")) {
+        fprintf(stderr,
+                "  --vid-in-path     Path to video file or to an images sequence                            [%s]\n",
+                def_p_vid_in_path ? def_p_vid_in_path : "NULL");
+        fprintf(stderr,
+                "  --vid-in-codec    Select the video decoder ('FFMPEG-IO', 'NATIVE')                       [%s]\n",
+                def_p_vid_in_codec);
+        fprintf(stderr,
+                "  --vid-in-size     Frame size of a raw gray8 input ('WxH', 'NATIVE' decoder only)         [%s]\n",
+                def_p_vid_in_size ? def_p_vid_in_size : "NULL");
+        fprintf(stderr,
+                "  --shm-path        Path of the shared-memory frames ring (e.g. '/dev/shm/motion')         [%s]\n",
+                def_p_shm_path ? def_p_shm_path : "NULL");
+        fprintf(stderr,
+                "  --shm-slots       Number of frames in the ring (>= 3)                                    [%d]\n",
+                def_p_shm_slots);
+        fprintf(stderr,
+                "  --shm-drop        Drop the frames when the ring is full (instead of waiting)                 \n");
+        fprintf(stderr,
+                "  --shm-fps         Publishing rate like a capture device (0 means as fast as possible)    [%f]\n",
+                def_p_shm_fps);
+        fprintf(stderr,
+                "  --help, -h        This help                                                                  \n");
+        exit(1);
+    }
+
+    // ------------------------- //
+    // -- PARSE CMD LINE ARGS -- //
+    // ------------------------- //
+
+    const char* p_vid_in_path = args_find_char(argc, argv, "--vid-in-path", def_p_vid_in_path);
+    const char* p_vid_in_codec = args_find_char(argc, argv, "--vid-in-codec", def_p_vid_in_codec);
+    const char* p_vid_in_size = args_find_char(argc, argv, "--vid-in-size", def_p_vid_in_size);
+    const char* p_shm_path = args_find_char(argc, argv, "--shm-path", def_p_shm_path);
+    const int p_shm_slots = args_find_int_min(argc, argv, "--shm-slots", def_p_shm_slots, 3);
+    const int p_shm_drop = args_find(argc, argv, "--shm-drop");
+    const float p_shm_fps = args_find_float_min(argc, argv, "--shm-fps", def_p_shm_fps, 0.f);
+
+    // -------------------------- //
+    // -- CMD LINE ARGS CHECKS -- //
+    // -------------------------- //
+
+    if (!p_vid_in_path) {
+        fprintf(stderr, "(EE) '--vid-in-path' is missing\n");
+        exit(1);
+    }
+    if (!p_shm_path) {
+        fprintf(stderr, "(EE) '--shm-path' is missing\n");
+        exit(1);
+    }
+    unsigned vid_in_width = 0, vid_in_height = 0;
+    if (p_vid_in_size && (sscanf(p_vid_in_size, "%ux%u", &vid_in_width, &vid_in_height) != 2 || !vid_in_width ||
+                          !vid_in_height)) {
+        fprintf(stderr, "(EE) '--vid-in-size' has to be formatted as 'WxH' (e.g. '1920x1080')\n");
+        exit(1);
+    }
+
+    // --------------------------------------- //
+    // -- VIDEO ALLOCATION & INITIALISATION -- //
+    // --------------------------------------- //
+
+    int i0, i1, j0, j1; // image dimension (i0 = y_min, i1 = y_max, j0 = x_min, j1 = x_max)
+    video_reader_t* video = video_reader_alloc_init(p_vid_in_path, 0, 0, 0, VBUF_NONE, 0,
+                                                    video_str_to_enum(p_vid_in_codec), VCDC_HWACCEL_NONE,
+                                                    vid_in_width, vid_in_height, NULL, &i0, &i1, &j0, &j1);
+    uint8_t** img = ui8matrix(i0, i1, j0, j1);
+    video_shm_writer_t* shm = video_shm_writer_alloc_init(p_shm_path, (j1 - j0) + 1, (i1 - i0) + 1, p_shm_slots);
+
+    // ----------------//
+    // -- PROCESSING --//
+    // ----------------//
+
+    fprintf(stderr, "(II) Publishing %dx%d frames in '%s'...\n", (j1 - j0) + 1, (i1 - i0) + 1, p_shm_path);
+    const double period_us = p_shm_fps > 0.f ? 1e6 / p_shm_fps : 0.;
+    size_t n_frames = 0;
+    TIME_POINT(start);
+    const uint8_t** img_view;
+    while (video_reader_get_frame_view(video, img, &img_view) != -1) {
+        if (period_us > 0.) {
+            TIME_POINT(now);
+            const double wait_us = n_frames * period_us - TIME_ELAPSED2_US(start, now);
+            if (wait_us > 0.)
+                usleep((useconds_t)wait_us);
+        }
+        video_shm_writer_save_frame(shm, img_view, !p_shm_drop);
+        n_frames++;
+    }
+    TIME_POINT(stop);
+    fprintf(stderr, "(II) %lu frame(s) read, %lu dropped, %.3f sec stalled on a full ring (total %.3f sec)\n",
+            (unsigned long)n_frames, (unsigned long)shm->n_dropped, shm->stall_us * 1e-6,
+            TIME_ELAPSED2_S(start, stop));
+
+    // ----------
+    // -- FREE --
+    // ----------
+
+    video_shm_writer_free(shm);
+    free_ui8matrix(img, i0, i1, j0, j1);
+    video_reader_free(video);
+
+    return EXIT_SUCCESS;
+}
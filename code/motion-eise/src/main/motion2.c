@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <nrc2.h>
 #include <math.h>
 
@@ -10,6 +11,7 @@
 #include "motion/args.h"
 #include "motion/tools.h"
 #include "motion/macros.h"
+#include "motion/frame_pool.h"
 
 #include "motion/CCL.h"
 #include "motion/features.h"
@@ -21,6 +23,8 @@
 #include "motion/sigma_delta.h"
 #include "motion/morpho.h"
 #include "motion/visu.h"
+#include "motion/log.h"
+#include "motion/pipeline.h"
 
 int main(int argc, char** argv) {
 
@@ -34,9 +38,17 @@ int main(int argc, char** argv) {
     int def_p_vid_in_skip = 0;
     int def_p_vid_in_loop = 1;
     int def_p_vid_in_threads = 0;
+    int def_p_vid_in_async = 0;
+    int def_p_vid_in_seg = 0;
+    int def_p_vid_in_seg_len = 500;
     char def_p_vid_in_dec_hw[16] = "NONE";
+    char def_p_vid_in_codec[16] = "FFMPEG-IO";
+    char* def_p_vid_in_cache = NULL;
+    char* def_p_vid_in_size = NULL;
     int def_p_sd_n = 2;
+    int def_p_sd_scale = 1;
     char* def_p_ccl_fra_path = NULL;
+    char* def_p_ccl_fra_runs = NULL;
     int def_p_flt_s_min = 50;
     int def_p_flt_s_max = 100000;
     int def_p_knn_k = 3;
@@ -47,9 +59,13 @@ int main(int argc, char** argv) {
     int def_p_trk_obj_min = 2;
     char* def_p_trk_roi_path = NULL;
     char* def_p_log_path = NULL;
+    char* def_p_log_bin = NULL;
+    char* def_p_log_shm = NULL;
     int def_p_cca_roi_max1 = 65536; // Maximum number of RoIs
     int def_p_cca_roi_max2 = 8192; // Maximum number of RoIs after filtering
     char* def_p_vid_out_path = NULL;
+    int def_p_vid_out_async = 0;
+    char* def_p_pip_stages = NULL;
 
     // ------------------------ //
     // -- CMD LINE ARGS HELP -- //
@@ -70,21 +86,47 @@ int main(int argc, char** argv) {
                 def_p_vid_in_skip);
         fprintf(stderr,
                 "  --vid-in-buff     Bufferize all the video in global memory before executing the chain        \n");
+        fprintf(stderr,
+                "  --vid-in-buff-z   Same as '--vid-in-buff' but the frames are compressed (delta + RLE)        \n");
         fprintf(stderr,
                 "  --vid-in-loop     Number of times the video is read in loop                              [%d]\n",
                 def_p_vid_in_loop);
         fprintf(stderr,
                 "  --vid-in-threads  Select the number of threads to use to decode video input (in ffmpeg)  [%d]\n",
                 def_p_vid_in_threads);
+        fprintf(stderr,
+                "  --vid-in-async    Number of frames decoded ahead in a separate thread (0 = synchronous)  [%d]\n",
+                def_p_vid_in_async);
+        fprintf(stderr,
+                "  --vid-in-seg      Number of video segments decoded in parallel (0 = no segmentation)     [%d]\n",
+                def_p_vid_in_seg);
+        fprintf(stderr,
+                "  --vid-in-seg-len  Number of frames per video segment (with '--vid-in-seg')               [%d]\n",
+                def_p_vid_in_seg_len);
         fprintf(stderr,
                 "  --vid-in-dec-hw   Select video decoder hardware acceleration ('NONE', 'NVDEC', 'VIDTB')  [%s]\n",
                 def_p_vid_in_dec_hw);
+        fprintf(stderr,
+                "  --vid-in-codec    Select the video decoder ('FFMPEG-IO', 'NATIVE', 'SHM')                [%s]\n",
+                def_p_vid_in_codec);
+        fprintf(stderr,
+                "  --vid-in-cache    Path to a decoded-frame cache (built at the first run, then mapped)    [%s]\n",
+                def_p_vid_in_cache ? def_p_vid_in_cache : "NULL");
+        fprintf(stderr,
+                "  --vid-in-size     Frame size of a raw gray8 input ('WxH', 'NATIVE' decoder only)         [%s]\n",
+                def_p_vid_in_size ? def_p_vid_in_size : "NULL");
         fprintf(stderr,
                 "  --sd-n            Value of the N parameter in the Sigma-Delta algorithm                  [%d]\n",
                 def_p_sd_n);
+        fprintf(stderr,
+                "  --sd-scale        Detection downscale factor (lossy above 2), RoIs refined in full res   [%d]\n",
+                def_p_sd_scale);
         fprintf(stderr,
                 "  --ccl-fra-path    Path of the files for CC debug frames                                  [%s]\n",
                 def_p_ccl_fra_path ? def_p_ccl_fra_path : "NULL");
+        fprintf(stderr,
+                "  --ccl-fra-runs    Path of a compact CC runs file (see 'motion-ccl-render')               [%s]\n",
+                def_p_ccl_fra_runs ? def_p_ccl_fra_runs : "NULL");
 #ifdef MOTION_OPENCV_LINK
         fprintf(stderr,
                 "  --ccl-fra-id      Show the RoI/CC ids on the ouptut CC frames                                \n");
@@ -125,15 +167,31 @@ int main(int argc, char** argv) {
         fprintf(stderr,
                 "  --log-path        Path of the output statistics, only required for debugging purpose     [%s]\n",
                 def_p_log_path ? def_p_log_path : "NULL");
+        fprintf(stderr,
+                "  --log-bin         Single binary file version of '--log-path' ('motion-log-convert')      [%s]\n",
+                def_p_log_bin ? def_p_log_bin : "NULL");
+        fprintf(stderr,
+                "  --log-shm         Shared-memory ring of the RoIs and tracks per frame (e.g. /dev/shm/x)  [%s]\n",
+                def_p_log_shm ? def_p_log_shm : "NULL");
         fprintf(stderr,
                 "  --vid-out-path    Path to video file or to an images sequence to write the output        [%s]\n",
                 def_p_vid_out_path ? def_p_vid_out_path : "NULL");
         fprintf(stderr,
                 "  --vid-out-play    Show the output video in a SDL window                                      \n");
+        fprintf(stderr,
+                "  --vid-out-async   Number of frames queued for a writer thread (+ CC frames), 0 = sync    [%d]\n",
+                def_p_vid_out_async);
+        fprintf(stderr,
+                "  --vid-out-drop    Drop the output frames when the writer thread is late (else wait)         \n");
 #ifdef MOTION_OPENCV_LINK
         fprintf(stderr,
                 "  --vid-out-id      Draw the track ids on the ouptut video                                     \n");
 #endif
+        fprintf(stderr,
+                "  --pip-stages      Stages of the processing chain, e.g. 'mrp=open3' (see '--pip-list')    [%s]\n",
+                def_p_pip_stages ? def_p_pip_stages : "NULL");
+        fprintf(stderr,
+                "  --pip-list        List the available stages of the processing chain and exit                 \n");
         fprintf(stderr,
                 "  --stats           Show the average latency of each task                                      \n");
         fprintf(stderr,
@@ -150,11 +208,20 @@ int main(int argc, char** argv) {
     const int p_vid_in_stop = args_find_int_min(argc, argv, "--vid-in-stop", def_p_vid_in_stop, 0);
     const int p_vid_in_skip = args_find_int_min(argc, argv, "--vid-in-skip", def_p_vid_in_skip, 0);
     const int p_vid_in_buff = args_find(argc, argv, "--vid-in-buff");
+    const int p_vid_in_buff_z = args_find(argc, argv, "--vid-in-buff-z");
     const int p_vid_in_loop = args_find_int_min(argc, argv, "--vid-in-loop", def_p_vid_in_loop, 1);
     const int p_vid_in_threads = args_find_int_min(argc, argv, "--vid-in-threads", def_p_vid_in_threads, 0);
+    const int p_vid_in_async = args_find_int_min(argc, argv, "--vid-in-async", def_p_vid_in_async, 0);
+    const int p_vid_in_seg = args_find_int_min(argc, argv, "--vid-in-seg", def_p_vid_in_seg, 0);
+    const int p_vid_in_seg_len = args_find_int_min(argc, argv, "--vid-in-seg-len", def_p_vid_in_seg_len, 1);
     const char* p_vid_in_dec_hw = args_find_char(argc, argv, "--vid-in-dec-hw", def_p_vid_in_dec_hw);
+    const char* p_vid_in_codec = args_find_char(argc, argv, "--vid-in-codec", def_p_vid_in_codec);
+    const char* p_vid_in_cache = args_find_char(argc, argv, "--vid-in-cache", def_p_vid_in_cache);
+    const char* p_vid_in_size = args_find_char(argc, argv, "--vid-in-size", def_p_vid_in_size);
     const int p_sd_n = args_find_int_min(argc, argv, "--sd-n", def_p_sd_n, 0);
+    const int p_sd_scale = args_find_int_min_max(argc, argv, "--sd-scale", def_p_sd_scale, 1, 16);
     const char* p_ccl_fra_path = args_find_char(argc, argv, "--ccl-fra-path", def_p_ccl_fra_path);
+    const char* p_ccl_fra_runs = args_find_char(argc, argv, "--ccl-fra-runs", def_p_ccl_fra_runs);
 #ifdef MOTION_OPENCV_LINK
     const int p_ccl_fra_id = args_find(argc, argv, "--ccl-fra-id,--show-id");
 #else
@@ -172,15 +239,26 @@ int main(int argc, char** argv) {
     const int p_trk_obj_min = args_find_int_min(argc, argv, "--trk-obj-min", def_p_trk_obj_min, 2);
     const char* p_trk_roi_path = args_find_char(argc, argv, "--trk-roi-path", def_p_trk_roi_path);
     const char* p_log_path = args_find_char(argc, argv, "--log-path", def_p_log_path);
+    const char* p_log_bin = args_find_char(argc, argv, "--log-bin", def_p_log_bin);
+    const char* p_log_shm = args_find_char(argc, argv, "--log-shm", def_p_log_shm);
     const char* p_vid_out_path = args_find_char(argc, argv, "--vid-out-path", def_p_vid_out_path);
     const int p_vid_out_play = args_find(argc, argv, "--vid-out-play");
+    const int p_vid_out_async = args_find_int_min(argc, argv, "--vid-out-async", def_p_vid_out_async, 0);
+    const int p_vid_out_drop = args_find(argc, argv, "--vid-out-drop");
 #ifdef MOTION_OPENCV_LINK
     const int p_vid_out_id = args_find(argc, argv, "--vid-out-id");
 #else
     const int p_vid_out_id = 0;
 #endif
+    const char* p_pip_stages = args_find_char(argc, argv, "--pip-stages", def_p_pip_stages);
     const int p_stats = args_find(argc, argv, "--stats");
 
+    if (args_find(argc, argv, "--pip-list")) {
+        printf("Stages of the processing chain ('step=name', for '--pip-stages'):\n");
+        pipeline_registry_print(stdout);
+        exit(0);
+    }
+
     // --------------------- //
     // -- HEADING DISPLAY -- //
     // --------------------- //
@@ -196,11 +274,20 @@ int main(int argc, char** argv) {
     printf("#  * vid-in-stop    = %d\n", p_vid_in_stop);
     printf("#  * vid-in-skip    = %d\n", p_vid_in_skip);
     printf("#  * vid-in-buff    = %d\n", p_vid_in_buff);
+    printf("#  * vid-in-buff-z  = %d\n", p_vid_in_buff_z);
     printf("#  * vid-in-loop    = %d\n", p_vid_in_loop);
     printf("#  * vid-in-threads = %d\n", p_vid_in_threads);
+    printf("#  * vid-in-async   = %d\n", p_vid_in_async);
+    printf("#  * vid-in-seg     = %d\n", p_vid_in_seg);
+    printf("#  * vid-in-seg-len = %d\n", p_vid_in_seg_len);
     printf("#  * vid-in-dec-hw  = %s\n", p_vid_in_dec_hw);
+    printf("#  * vid-in-codec   = %s\n", p_vid_in_codec);
+    printf("#  * vid-in-cache   = %s\n", p_vid_in_cache);
+    printf("#  * vid-in-size    = %s\n", p_vid_in_size);
     printf("#  * sd-n           = %d\n", p_sd_n);
+    printf("#  * sd-scale       = %d\n", p_sd_scale);
     printf("#  * ccl-fra-path   = %s\n", p_ccl_fra_path);
+    printf("#  * ccl-fra-runs   = %s\n", p_ccl_fra_runs);
 #ifdef MOTION_OPENCV_LINK
     printf("#  * ccl-fra-id     = %d\n", p_ccl_fra_id);
 #endif
@@ -216,11 +303,16 @@ int main(int argc, char** argv) {
     printf("#  * trk-obj-min    = %d\n", p_trk_obj_min);
     printf("#  * trk-roi-path   = %s\n", p_trk_roi_path);
     printf("#  * log-path       = %s\n", p_log_path);
+    printf("#  * log-bin        = %s\n", p_log_bin);
+    printf("#  * log-shm        = %s\n", p_log_shm);
     printf("#  * vid-out-path   = %s\n", p_vid_out_path);
     printf("#  * vid-out-play   = %d\n", p_vid_out_play);
+    printf("#  * vid-out-async  = %d\n", p_vid_out_async);
+    printf("#  * vid-out-drop   = %d\n", p_vid_out_drop);
 #ifdef MOTION_OPENCV_LINK
     printf("#  * vid-out-id     = %d\n", p_vid_out_id);
 #endif
+    printf("#  * pip-stages     = %s\n", p_pip_stages);
     printf("#  * stats          = %d\n", p_stats);
 
     printf("#\n");
@@ -237,12 +329,37 @@ int main(int argc, char** argv) {
         fprintf(stderr, "(EE) '--vid-in-stop' has to be higher than '--vid-in-start'\n");
         exit(1);
     }
+    unsigned vid_in_width = 0, vid_in_height = 0;
+    if (p_vid_in_size && (sscanf(p_vid_in_size, "%ux%u", &vid_in_width, &vid_in_height) != 2 || !vid_in_width ||
+                          !vid_in_height)) {
+        fprintf(stderr, "(EE) '--vid-in-size' has to be formatted as 'WxH' (e.g. '1920x1080')\n");
+        exit(1);
+    }
+    if (p_vid_in_seg && (p_vid_in_buff || p_vid_in_buff_z || p_vid_in_cache))
+        fprintf(stderr, "(WW) '--vid-in-buff', '--vid-in-buff-z' and '--vid-in-cache' will be ignore because "
+                        "'--vid-in-seg' is set\n");
+    if (p_sd_scale > 2)
+        fprintf(stderr, "(WW) '--sd-scale' above 2 is lossy (the small CCs are lost and the large ones are split)\n");
+    if (p_sd_scale > 1 && p_ccl_fra_path) {
+        fprintf(stderr, "(EE) '--ccl-fra-path' can't be combined with '--sd-scale' (CCs are labeled downscaled)\n");
+        exit(1);
+    }
+    if (p_sd_scale > 1 && p_ccl_fra_runs) {
+        fprintf(stderr, "(EE) '--ccl-fra-runs' can't be combined with '--sd-scale' (CCs are labeled downscaled)\n");
+        exit(1);
+    }
+    if (p_vid_in_size && strcmp(p_vid_in_codec, "NATIVE"))
+        fprintf(stderr, "(WW) '--vid-in-size' will be ignore because '--vid-in-codec' is not 'NATIVE'\n");
 #ifdef MOTION_OPENCV_LINK
     if (p_ccl_fra_id && !p_ccl_fra_path)
         fprintf(stderr, "(WW) '--ccl-fra-id' has to be combined with the '--ccl-fra-path' parameter\n");
 #endif
     if (p_vid_out_path && p_vid_out_play)
         fprintf(stderr, "(WW) '--vid-out-path' will be ignore because '--vid-out-play' is set\n");
+    if (p_vid_out_async && p_vid_out_play)
+        fprintf(stderr, "(WW) '--vid-out-async' will be ignore for the output video because '--vid-out-play' is set\n");
+    if (p_vid_out_drop && !p_vid_out_async)
+        fprintf(stderr, "(WW) '--vid-out-drop' will be ignore because '--vid-out-async' is not set\n");
 #ifdef MOTION_OPENCV_LINK
     if (p_vid_out_id && !p_vid_out_path && !p_vid_out_play)
         fprintf(stderr,
@@ -255,10 +372,24 @@ int main(int argc, char** argv) {
 
     TIME_POINT(start_alloc_init);
     int i0, i1, j0, j1; // image dimension (i0 = y_min, i1 = y_max, j0 = x_min, j1 = x_max)
-    video_reader_t* video = video_reader_alloc_init(p_vid_in_path, p_vid_in_start, p_vid_in_stop, p_vid_in_skip,
-                                                    p_vid_in_buff, p_vid_in_threads, VCDC_FFMPEG_IO,
-                                                    video_hwaccel_str_to_enum(p_vid_in_dec_hw), &i0, &i1, &j0, &j1);
+    const enum video_buffer_e vid_in_buff = p_vid_in_buff_z ? VBUF_DELTA_RLE : (p_vid_in_buff ? VBUF_RAW : VBUF_NONE);
+    video_reader_t* video;
+    if (p_vid_in_seg) // offline mode: the segments are decoded in parallel (8 frames ahead per segment decoder)
+        video = video_reader_segments_alloc_init(p_vid_in_path, p_vid_in_start, p_vid_in_stop, p_vid_in_skip,
+                                                 p_vid_in_seg, p_vid_in_seg_len, 8, p_vid_in_threads,
+                                                 video_str_to_enum(p_vid_in_codec),
+                                                 video_hwaccel_str_to_enum(p_vid_in_dec_hw), vid_in_width,
+                                                 vid_in_height, &i0, &i1, &j0, &j1);
+    else
+        video = video_reader_alloc_init(p_vid_in_path, p_vid_in_start, p_vid_in_stop, p_vid_in_skip, vid_in_buff,
+                                        p_vid_in_threads, video_str_to_enum(p_vid_in_codec),
+                                        video_hwaccel_str_to_enum(p_vid_in_dec_hw), vid_in_width, vid_in_height,
+                                        p_vid_in_cache, &i0, &i1, &j0, &j1);
     video->loop_size = (size_t)(p_vid_in_loop);
+    // decode ahead in a separate thread (the frames are then obtained by pointer swap)
+    video_reader_async_t* video_async = NULL;
+    if (p_vid_in_async)
+        video_async = video_reader_async_alloc_init(video, p_vid_in_async, i0, i1, j0, j1);
     video_writer_t* video_writer = NULL;
     img_data_t* img_data = NULL;
     if (p_ccl_fra_path) {
@@ -266,82 +397,87 @@ int main(int argc, char** argv) {
         const size_t n_threads = 1;
         video_writer = video_writer_alloc_init(p_ccl_fra_path, p_vid_in_start, n_threads, (i1 - i0) + 1, (j1 - j0) + 1,
                                                PIXFMT_GRAY, VCDC_FFMPEG_IO, 0);
+        if (p_vid_out_async)
+            video_writer_async_start(video_writer, p_vid_out_async, p_vid_out_drop ? VWRT_DROP : VWRT_BLOCK);
     }
+    // input frames (t - 1 and t), the visualization keeps references on the last `p_trk_obj_min` ones
+    frame_pool_t* frame_pool = frame_pool_alloc((p_vid_out_play || p_vid_out_path) ? p_trk_obj_min + 2 : 2,
+                                                i0, i1, j0, j1);
     visu_data_t *visu_data = NULL;
     if (p_vid_out_play || p_vid_out_path) {
         const uint8_t n_threads = 1;
         visu_data = visu_alloc_init(p_vid_out_path, p_vid_in_start, n_threads, (i1 - i0) + 1, (j1 - j0) + 1,
                                     PIXFMT_RGB24, VCDC_FFMPEG_IO, p_vid_out_id, p_vid_out_play, p_trk_obj_min,
-                                    p_cca_roi_max2, p_vid_in_skip);
+                                    frame_pool, p_vid_in_skip);
+        // the displayed frames stay on the main thread
+        if (p_vid_out_async && !p_vid_out_play)
+            video_writer_async_start(visu_data->video_writer, p_vid_out_async,
+                                     p_vid_out_drop ? VWRT_DROP : VWRT_BLOCK);
     }
 
     // --------------------- //
     // -- DATA ALLOCATION -- //
     // --------------------- //
 
-    sigma_delta_data_t* sd_data0 = sigma_delta_alloc_data(i0, i1, j0, j1, 1, 254);
-    sigma_delta_data_t* sd_data1 = sigma_delta_alloc_data(i0, i1, j0, j1, 1, 254);
-    morpho_data_t* morpho_data0 = morpho_alloc_data(i0, i1, j0, j1);
-    morpho_data_t* morpho_data1 = morpho_alloc_data(i0, i1, j0, j1);
-    RoI_t* RoIs_tmp0 = features_alloc_RoIs(p_cca_roi_max1);
-    RoI_t* RoIs0 = features_alloc_RoIs(p_cca_roi_max2);
-    RoI_t* RoIs_tmp1 = features_alloc_RoIs(p_cca_roi_max1);
-    RoI_t* RoIs1 = features_alloc_RoIs(p_cca_roi_max2);
-    CCL_data_t* ccl_data0 = CCL_LSL_alloc_data(i0, i1, j0, j1);
-    CCL_data_t* ccl_data1 = CCL_LSL_alloc_data(i0, i1, j0, j1);
-    kNN_data_t* knn_data = kNN_alloc_data(p_cca_roi_max2);
-    tracking_data_t* tracking_data = tracking_alloc_data(MAX(p_trk_obj_min, p_trk_ext_o) + 1, p_cca_roi_max2);
-    uint8_t **IG0 = ui8matrix(i0, i1, j0, j1); // grayscale input image at t - 1
-    uint8_t **IG1 = ui8matrix(i0, i1, j0, j1); // grayscale input image at t
-    uint8_t **IB0 = ui8matrix(i0, i1, j0, j1); // binary image (after Sigma-Delta) at t - 1
-    uint8_t **IB1 = ui8matrix(i0, i1, j0, j1); // binary image (after Sigma-Delta) at t
-    uint32_t **L10 = ui32matrix(i0, i1, j0, j1); // labels (CCL) at t - 1
-    uint32_t **L11 = ui32matrix(i0, i1, j0, j1); // labels (CCL) at t
-    uint32_t **L20 = NULL; // labels (CCL + surface filter) at t - 1
-    uint32_t **L21 = NULL; // labels (CCL + surface filter) at t
-    if (p_ccl_fra_path) {
-        L20 = ui32matrix(i0, i1, j0, j1);
-        L21 = ui32matrix(i0, i1, j0, j1);
-    }
-
+    // processing chain (Sigma-Delta, morphology, CCL, CCA, filtering, k-NN and tracking)
+    pipeline_params_t pip_params = {i0, i1, j0, j1, p_sd_scale, (uint8_t)p_sd_n, (size_t)p_cca_roi_max1,
+                                    (size_t)p_cca_roi_max2, (uint32_t)p_flt_s_min, (uint32_t)p_flt_s_max, p_knn_k,
+                                    (uint32_t)p_knn_d, p_knn_s, (size_t)p_trk_ext_d, (size_t)p_trk_obj_min,
+                                    (uint8_t)p_trk_ext_o, (uint8_t)(p_trk_roi_path != NULL || visu_data),
+                                    (uint8_t)(p_ccl_fra_path != NULL)};
+    pipeline_t* pip = pipeline_alloc(&pip_params, p_pip_stages);
+    pipeline_frame_t* fra0 = &pip->frames[0]; // detection data at t - 1
+    pipeline_frame_t* fra1 = &pip->frames[1]; // detection data at t
+    kNN_data_t* knn_data = (kNN_data_t*)pip->data[PIP_KNN];
+    tracking_data_t* tracking_data = (tracking_data_t*)pip->data[PIP_TRK];
+    frame_t* F0 = frame_pool_acquire(frame_pool); // input frame at t - 1
+    frame_t* F1 = frame_pool_acquire(frame_pool); // input frame at t
+    uint8_t **IG0 = F0->img; // grayscale input image at t - 1
+    uint8_t **IG1 = F1->img; // grayscale input image at t
+    // read-only views on the input images: they point on IG0/IG1 or directly in the decoder memory (zero-copy)
+    const uint8_t **IG0_view = (const uint8_t**)IG0;
+    const uint8_t **IG1_view = (const uint8_t**)IG1;
+
+    
     // ------------------------- //
     // -- DATA INITIALISATION -- //
     // ------------------------- //
 
     int cur_fra;
-    if ((cur_fra = video_reader_get_frame(video, IG1)) != -1) {
-        sigma_delta_init_data(sd_data0, (const uint8_t**)IG1, i0, i1, j0, j1);
-        sigma_delta_init_data(sd_data1, (const uint8_t**)IG1, i0, i1, j0, j1);
-    } else {
+    if (video_async) {
+        cur_fra = video_reader_async_get_frame(video_async, &F1->img);
+        IG1 = F1->img;
+        IG1_view = (const uint8_t**)IG1;
+    } else
+        cur_fra = video_reader_get_frame_view(video, IG1, &IG1_view);
+    if (cur_fra == -1) {
         fprintf(stderr, "(EE) Something is not working well with the input video.\n");
         exit(1);
     }
+    pipeline_init(pip, IG1_view);
     zero_ui8matrix(IG0, i0, i1, j0, j1);
     zero_ui8matrix(IG1, i0, i1, j0, j1);
-    zero_ui8matrix(IB0, i0, i1, j0, j1);
-    zero_ui8matrix(IB1, i0, i1, j0, j1);
-    zero_ui32matrix(L10, i0, i1, j0, j1);
-    zero_ui32matrix(L11, i0, i1, j0, j1);
-    if (p_ccl_fra_path) {
-        zero_ui32matrix(L20, i0, i1, j0, j1);
-        zero_ui32matrix(L21, i0, i1, j0, j1);
-    }
-    morpho_init_data(morpho_data0);
-    morpho_init_data(morpho_data1);
-    CCL_LSL_init_data(ccl_data0);
-    CCL_LSL_init_data(ccl_data1);
-    features_init_RoIs(RoIs_tmp0, p_cca_roi_max1);
-    features_init_RoIs(RoIs_tmp1, p_cca_roi_max1);
-    features_init_RoIs(RoIs0, p_cca_roi_max2);
-    features_init_RoIs(RoIs1, p_cca_roi_max2);
-    kNN_init_data(knn_data);
-    tracking_init_data(tracking_data);
     // to bufferize/display the first frame
     if (visu_data)
-        visu_display(visu_data, (const uint8_t**)IG1, RoIs1, 0, tracking_data->tracks, cur_fra);
+        visu_display(visu_data, F1, (const uint8_t**)IG1, fra1->RoIs, 0, tracking_data->tracks, cur_fra);
+
+    if (p_log_path)
+        tools_create_folder(p_log_path);
+    // the binary log is written by a separate thread by chunks of 1 MB
+    log_writer_t* log_writer = p_log_bin ? log_writer_alloc_init(p_log_bin, 1 << 20, 4) : NULL;
+    // live output for the consumers in other processes (4 MB of records, the oldest records are overwritten)
+    log_shm_writer_t* log_shm = p_log_shm ? log_shm_writer_alloc_init(p_log_shm, 4 << 20) : NULL;
+    // CC debug frames as runs (taken from the CCL run-length coding) instead of encoded gray frames
+    log_runs_writer_t* runs_writer = p_ccl_fra_runs ?
+        log_runs_writer_alloc_init(p_ccl_fra_runs, (j1 - j0) + 1, (i1 - i0) + 1, p_vid_in_start) : NULL;
 
     TIME_POINT(stop_alloc_init);
     printf("# Allocations and initialisations took %6.3f sec\n", TIME_ELAPSED2_SEC(start_alloc_init, stop_alloc_init));
+    printf("# Processing chain: ");
+    pipeline_stages_print(stdout, pip);
+    printf("\n");
+
+
 
     // --------------------- //
     // -- PROCESSING LOOP -- //
@@ -349,13 +485,23 @@ int main(int argc, char** argv) {
 
     printf("# The program is running...\n");
     size_t n_moving_objs = 0, n_processed_frames = 0;
-    TIME_SETA(dec_a); TIME_SETA(sd_a); TIME_SETA(mrp_a); TIME_SETA(ccl_a); TIME_SETA(cca_a); TIME_SETA(flt_a);
-    TIME_SETA(knn_a); TIME_SETA(trk_a); TIME_SETA(log_a); TIME_SETA(vis_a);
+    TIME_SETA(dec_a); TIME_SETA(log_a); TIME_SETA(vis_a);
     TIME_POINT(start_compute);
     while (1) {
-        // step 0: video decoding
+        // step 0: video decoding (or waiting for the decoder thread in async mode)
         TIME_POINT(dec_b);
-        cur_fra = video_reader_get_frame(video, IG1);
+        // the frame can still be referenced by the visualization, then it is replaced by a free one
+        if (frame_is_shared(F1)) {
+            frame_release(F1);
+            F1 = frame_pool_acquire(frame_pool);
+            IG1 = F1->img;
+        }
+        if (video_async) {
+            cur_fra = video_reader_async_get_frame(video_async, &F1->img);
+            IG1 = F1->img;
+            IG1_view = (const uint8_t**)IG1;
+        } else
+            cur_fra = video_reader_get_frame_view(video, IG1, &IG1_view);
         TIME_POINT(dec_e);
         TIME_ACC(dec_a, dec_b, dec_e);
 
@@ -368,106 +514,34 @@ int main(int argc, char** argv) {
         // -------------------------------------- //
         // -- IMAGE PROCESSING CHAIN EXECUTION -- //
         // -------------------------------------- //
-
+       
         // ------------------------- //
         // -- Processing at t - 1 -- //
         // ------------------------- //
 
-        uint32_t n_RoIs0 = 0;
-        if (n_processed_frames > 0) {
-            // step 1: motion detection (per pixel) with Sigma-Delta algorithm
-            TIME_POINT(sd_b);
-            sigma_delta_compute(sd_data0, (const uint8_t**)IG0, IB0, i0, i1, j0, j1, p_sd_n);
-            TIME_POINT(sd_e);
-            TIME_ACC(sd_a, sd_b, sd_e);
-
-            // step 2: mathematical morphology
-            TIME_POINT(mrp_b);
-            morpho_compute_opening3(morpho_data0, (const uint8_t**)IB0, IB0, i0, i1, j0, j1);
-            morpho_compute_closing3(morpho_data0, (const uint8_t**)IB0, IB0, i0, i1, j0, j1);
-            TIME_POINT(mrp_e);
-            TIME_ACC(mrp_a, mrp_b, mrp_e);
-
-            // step 3: connected components labeling (CCL)
-            TIME_POINT(ccl_b);
-            const uint32_t n_RoIs_tmp0 = CCL_LSL_apply(ccl_data0, (const uint8_t**)IB0, L10, 0);
-            assert(n_RoIs_tmp0 <= (uint32_t)p_cca_roi_max1);
-            TIME_POINT(ccl_e);
-            TIME_ACC(ccl_a, ccl_b, ccl_e);
-
-            // step 4: connected components analysis (CCA): from image of labels to "regions of interest" (RoIs)
-            TIME_POINT(cca_b);
-            features_extract((const uint32_t**)L10, i0, i1, j0, j1, RoIs_tmp0, n_RoIs_tmp0);
-            TIME_POINT(cca_e);
-            TIME_ACC(cca_a, cca_b, cca_e);
-
-            // step 5: surface filtering (rm too small and too big RoIs)
-            TIME_POINT(flt_b);
-            n_RoIs0 = features_filter_surface((const uint32_t**)L10, L20, i0, i1, j0, j1, RoIs_tmp0, n_RoIs_tmp0,
-                                              p_flt_s_min, p_flt_s_max);
-            assert(n_RoIs0 <= (uint32_t)p_cca_roi_max2);
-            // features_labels_zero_init(RoIs_tmp->basic, L1);
-            features_shrink_basic(RoIs_tmp0, n_RoIs_tmp0, RoIs0);
-            TIME_POINT(flt_e);
-            TIME_ACC(flt_a, flt_b, flt_e);
-        }
+        // steps 1 to 5 on t - 1 (with the detection data of t - 1)
+        if (n_processed_frames > 0)
+            pipeline_detect(pip, 0, IG0_view);
+        else
+            fra0->n_RoIs = 0;
 
         // --------------------- //
         // -- Processing at t -- //
         // --------------------- //
 
-        // step 1: motion detection (per pixel) with Sigma-Delta algorithm
-        TIME_POINT(sd_b);
-        sigma_delta_compute(sd_data1, (const uint8_t**)IG1, IB1, i0, i1, j0, j1, p_sd_n);
-        TIME_POINT(sd_e);
-        TIME_ACC(sd_a, sd_b, sd_e);
-
-        // step 2: mathematical morphology
-        TIME_POINT(mrp_b);
-        morpho_compute_opening3(morpho_data1, (const uint8_t**)IB1, IB1, i0, i1, j0, j1);
-        morpho_compute_closing3(morpho_data1, (const uint8_t**)IB1, IB1, i0, i1, j0, j1);
-        TIME_POINT(mrp_e);
-        TIME_ACC(mrp_a, mrp_b, mrp_e);
-
-        // step 3: connected components labeling (CCL)
-        TIME_POINT(ccl_b);
-        const uint32_t n_RoIs_tmp1 = CCL_LSL_apply(ccl_data1, (const uint8_t**)IB1, L11, 0);
-        assert(n_RoIs_tmp1 <= (uint32_t)p_cca_roi_max1);
-        TIME_POINT(ccl_e);
-        TIME_ACC(ccl_a, ccl_b, ccl_e);
-
-        // step 4: connected components analysis (CCA): from image of labels to "regions of interest" (RoIs)
-        TIME_POINT(cca_b);
-        features_extract((const uint32_t**)L11, i0, i1, j0, j1, RoIs_tmp1, n_RoIs_tmp1);
-        TIME_POINT(cca_e);
-        TIME_ACC(cca_a, cca_b, cca_e);
-
-        // step 5: surface filtering (rm too small and too big RoIs)
-        TIME_POINT(flt_b);
-        const uint32_t n_RoIs1 = features_filter_surface((const uint32_t**)L11, L21, i0, i1, j0, j1, RoIs_tmp1,
-                                                         n_RoIs_tmp1, p_flt_s_min, p_flt_s_max);
-        assert(n_RoIs1 <= (uint32_t)p_cca_roi_max2);
-        // features_labels_zero_init(RoIs_tmp->basic, L1);
-        features_shrink_basic(RoIs_tmp1, n_RoIs_tmp1, RoIs1);
-        TIME_POINT(flt_e);
-        TIME_ACC(flt_a, flt_b, flt_e);
-
-        // ----------------------------- //
-        // -- Associations (t - 1, t) -- //
-        // ----------------------------- //
-
-        // step 6: k-NN matching (RoIs associations)
-        TIME_POINT(knn_b);
-        kNN_match(knn_data, RoIs0, n_RoIs0, RoIs1, n_RoIs1, p_knn_k, p_knn_d, p_knn_s);
-        TIME_POINT(knn_e);
-        TIME_ACC(knn_a, knn_b, knn_e);
-
-        // step 7: temporal tracking
-        TIME_POINT(trk_b);
-        tracking_perform(tracking_data, RoIs1, n_RoIs1, cur_fra, p_trk_ext_d, p_trk_obj_min,
-                         p_trk_roi_path != NULL || visu_data, p_trk_ext_o, p_knn_s);
-        TIME_POINT(trk_e);
-        TIME_ACC(trk_a, trk_b, trk_e);
+        // steps 1 to 5: motion detection, morphology, CCL, CCA and surface filtering
+        pipeline_detect(pip, 1, IG1_view);
+
+        // --------------------------------------- //
+        // -- Associations between t - 1 and t -- //
+        // --------------------------------------- //
+
+        // steps 6 and 7: k-NN matching and temporal tracking
+        pipeline_associate(pip, cur_fra);
+        RoI_t* RoIs0 = fra0->RoIs; // RoIs at t - 1
+        const uint32_t n_RoIs0 = fra0->n_RoIs;
+        RoI_t* RoIs1 = fra1->RoIs; // RoIs at t
+        const uint32_t n_RoIs1 = fra1->n_RoIs;
 
         // ---------- //
         // -- LOGS -- //
@@ -476,13 +550,12 @@ int main(int argc, char** argv) {
         TIME_POINT(log_b);
         // save frames (CCs)
         if (img_data) {
-            image_gs_draw_labels(img_data, (const uint32_t**)L21, RoIs1, n_RoIs1, p_ccl_fra_id);
+            image_gs_draw_labels(img_data, (const uint32_t**)fra1->L2, RoIs1, n_RoIs1, p_ccl_fra_id);
             video_writer_save_frame(video_writer, (const uint8_t**)image_gs_get_pixels_2d(img_data));
         }
 
         // save stats
         if (p_log_path) {
-            tools_create_folder(p_log_path);
             char filename[1024];
             snprintf(filename, sizeof(filename), "%s/%05d.txt", p_log_path, cur_fra);
             FILE* f = fopen(filename, "w");
@@ -500,20 +573,40 @@ int main(int argc, char** argv) {
             }
             fclose(f);
         }
+        if (log_writer) {
+            int prev_fra = cur_fra > p_vid_in_start ? cur_fra - (p_vid_in_skip + 1) : -1;
+            log_writer_write_frame(log_writer, prev_fra, cur_fra, RoIs0, n_RoIs0, RoIs1, n_RoIs1,
+                                   cur_fra > p_vid_in_start ? knn_data : NULL, tracking_data->tracks);
+        }
+        if (log_shm)
+            log_shm_writer_write_frame(log_shm, cur_fra, RoIs1, n_RoIs1, tracking_data->tracks);
+        if (runs_writer)
+            log_runs_writer_write_frame(runs_writer, cur_fra, (const CCL_data_t*)fra1->data[PIP_CCL], fra1->RoIs_tmp,
+                                        fra1->n_RoIs_tmp);
         TIME_POINT(log_e);
         TIME_ACC(log_a, log_b, log_e);
 
         // display the result to the screen or write it into a video file
         TIME_POINT(vis_b);
         if (visu_data)
-            visu_display(visu_data, (const uint8_t**)IG1, RoIs1, n_RoIs1, tracking_data->tracks, cur_fra);
+            visu_display(visu_data, F1, IG1_view, RoIs1, n_RoIs1, tracking_data->tracks, cur_fra);
+        // when they are not written at the end, the RoI ids histories are only needed by the visualization buffer (up
+        // to its oldest frame, the buffer can be older than `p_trk_obj_min` frames when frames are shed or dropped)
+        if (visu_data && !p_trk_roi_path)
+            tracking_release_RoIs_id(tracking_data, visu_get_oldest_frame_id(visu_data));
         TIME_POINT(vis_e);
         TIME_ACC(vis_a, vis_b, vis_e);
 
-        // swap IG0 <-> IG1 for the next frame
+        // swap IG0 <-> IG1 (and their views and frames) for the next frame
+        frame_t* tmp_fra = F0;
+        F0 = F1;
+        F1 = tmp_fra;
         uint8_t** tmp = IG0;
         IG0 = IG1;
         IG1 = tmp;
+        const uint8_t** tmp_view = IG0_view;
+        IG0_view = IG1_view;
+        IG1_view = tmp_view;
 
         n_processed_frames++;
         n_moving_objs = tracking_count_objects(tracking_data->tracks);
@@ -523,6 +616,7 @@ int main(int argc, char** argv) {
         fprintf(stderr, " -- FPS = %4d", (int)(n_processed_frames / (TIME_ELAPSED2_SEC(start_compute, stop_compute))));
         fprintf(stderr, " -- Tracks = %3lu\r", (unsigned long)n_moving_objs);
         fflush(stderr);
+
     }
     TIME_POINT(stop_compute);
     fprintf(stderr, "\n");
@@ -546,50 +640,91 @@ int main(int argc, char** argv) {
     if (p_stats) {
         printf("#\n");
         printf("# Average latencies: \n");
-        printf("# -> Video decoding = %8.3f ms\n", TIME_ELAPSED_MS(dec_a) / n_processed_frames);
-        printf("# -> Sigma-Delta    = %8.3f ms\n", TIME_ELAPSED_MS(sd_a)  / n_processed_frames);
-        printf("# -> Morphology     = %8.3f ms\n", TIME_ELAPSED_MS(mrp_a) / n_processed_frames);
-        printf("# -> CC Labeling    = %8.3f ms\n", TIME_ELAPSED_MS(ccl_a) / n_processed_frames);
-        printf("# -> CC Analysis    = %8.3f ms\n", TIME_ELAPSED_MS(cca_a) / n_processed_frames);
-        printf("# -> Filtering      = %8.3f ms\n", TIME_ELAPSED_MS(flt_a) / n_processed_frames);
-        printf("# -> k-NN           = %8.3f ms\n", TIME_ELAPSED_MS(knn_a) / n_processed_frames);
-        printf("# -> Tracking       = %8.3f ms\n", TIME_ELAPSED_MS(trk_a) / n_processed_frames);
+        if (video_async)
+            printf("# -> Input stall    = %8.3f ms\n", TIME_ELAPSED_MS(dec_a) / n_processed_frames);
+        else
+            printf("# -> Video decoding = %8.3f ms\n", TIME_ELAPSED_MS(dec_a) / n_processed_frames);
+        pipeline_latencies_print(stdout, pip, n_processed_frames);
         printf("# -> *Logs*         = %8.3f ms\n", TIME_ELAPSED_MS(log_a) / n_processed_frames);
         printf("# -> *Visu*         = %8.3f ms\n", TIME_ELAPSED_MS(vis_a) / n_processed_frames);
         TIME_SETA(total);
-        TIME_ADD(total, dec_a); TIME_ADD(total,  sd_a); TIME_ADD(total, mrp_a); TIME_ADD(total, ccl_a);
-        TIME_ADD(total, cca_a); TIME_ADD(total, flt_a); TIME_ADD(total, knn_a); TIME_ADD(total, trk_a);
-        TIME_ADD(total, log_a); TIME_ADD(total, vis_a);
+        TIME_ADD(total, dec_a); TIME_ADD(total, log_a); TIME_ADD(total, vis_a);
+        for (int s = 0; s < PIP_N_STAGES; s++)
+            t_total_us += pip->stage_us[s];
         double total = TIME_ELAPSED_MS(total) / n_processed_frames;
         printf("# => Total          = %8.3f ms [~%5.2f FPS]\n", total, 1000. / total);
+        if (video_async) {
+            printf("#\n");
+            printf("# Decoder thread: \n");
+            printf("# -> Video decoding = %8.3f ms\n",
+                   video_async->n_decoded ? video_async->decode_us * 1e-3 / video_async->n_decoded : 0.);
+        }
+        if (video->fra_zbuffer) {
+            video_zbuffer_t* zbuf = video->fra_zbuffer;
+            printf("#\n");
+            printf("# Compressed frames buffer: \n");
+            printf("# -> Footprint      = %8.1f MB (raw = %.1f MB)\n", zbuf->zip_size / (1024. * 1024.),
+                   zbuf->raw_size / (1024. * 1024.));
+            printf("# -> Ratio          = %8.2f\n", zbuf->zip_size ? (double)zbuf->raw_size / zbuf->zip_size : 0.);
+            printf("# -> Decompression  = %8.3f ms\n",
+                   zbuf->n_decoded ? zbuf->decode_us * 1e-3 / zbuf->n_decoded : 0.);
+        }
+        if (p_trk_roi_path || visu_data) {
+            printf("#\n");
+            printf("# Tracks RoI ids histories: \n");
+            printf("# -> Footprint      = %8.1f KB\n",
+                   tracking_RoIs_id_pool_footprint(tracking_data->RoIs_id_pool) / 1024.);
+            printf("# -> Fragmentation  = %8.2f %%\n",
+                   100.f * tracking_RoIs_id_pool_fragmentation(tracking_data->RoIs_id_pool));
+        }
     }
 
     // some frames have been buffered for the visualization, display or write these frames here
     if (visu_data)
         visu_flush(visu_data, tracking_data->tracks);
 
+    if (p_stats && p_vid_out_async) {
+        video_writer_t* writers[2] = {visu_data ? visu_data->video_writer : NULL, video_writer};
+        const char* names[2] = {"Output video", "CC frames"};
+        for (int w = 0; w < 2; w++) {
+            if (!writers[w] || !writers[w]->async)
+                continue;
+            video_writer_flush(writers[w]);
+            video_writer_async_t* async = writers[w]->async;
+            printf("#\n");
+            printf("# Writer thread (%s): \n", names[w]);
+            printf("# -> Video encoding = %8.3f ms\n",
+                   async->n_written ? async->encode_us * 1e-3 / async->n_written : 0.);
+            printf("# -> Pipeline stall = %8.3f ms\n", async->stall_us * 1e-3 / n_processed_frames);
+            printf("# -> Written frames = %4lu\n", (unsigned long)async->n_written);
+            printf("# -> Dropped frames = %4lu\n", (unsigned long)async->n_dropped);
+        }
+    }
+
+    if (p_stats && log_writer) {
+        printf("#\n");
+        printf("# Binary log: \n");
+        printf("# -> Record size    = %8.1f KB\n",
+               log_writer->n_frames ? log_writer->buffer->n_bytes / (1024. * log_writer->n_frames) : 0.);
+        printf("# -> Pipeline stall = %8.3f ms\n", log_writer->buffer->stall_us * 1e-3 / n_processed_frames);
+    }
+
+    if (p_stats && runs_writer) {
+        printf("#\n");
+        printf("# CC runs: \n");
+        printf("# -> Record size    = %8.1f KB\n",
+               runs_writer->n_frames ? runs_writer->buffer->n_bytes / (1024. * runs_writer->n_frames) : 0.);
+        printf("# -> Pipeline stall = %8.3f ms\n", runs_writer->buffer->stall_us * 1e-3 / n_processed_frames);
+    }
+
     // ---------- //
     // -- FREE -- //
     // ---------- //
 
-    sigma_delta_free_data(sd_data0);
-    sigma_delta_free_data(sd_data1);
-    morpho_free_data(morpho_data0);
-    morpho_free_data(morpho_data1);
-    free_ui8matrix(IG0, i0, i1, j0, j1);
-    free_ui8matrix(IG1, i0, i1, j0, j1);
-    free_ui8matrix(IB0, i0, i1, j0, j1);
-    free_ui8matrix(IB1, i0, i1, j0, j1);
-    free_ui32matrix(L10, i0, i1, j0, j1);
-    free_ui32matrix(L11, i0, i1, j0, j1);
-    if (p_ccl_fra_path) {
-        free_ui32matrix(L20, i0, i1, j0, j1);
-        free_ui32matrix(L21, i0, i1, j0, j1);
-    }
-    features_free_RoIs(RoIs_tmp0);
-    features_free_RoIs(RoIs_tmp1);
-    features_free_RoIs(RoIs0);
-    features_free_RoIs(RoIs1);
+    frame_release(F0);
+    frame_release(F1);
+    if (video_async)
+        video_reader_async_free(video_async);
     video_reader_free(video);
     if (img_data) {
         image_gs_free(img_data);
@@ -597,10 +732,14 @@ int main(int argc, char** argv) {
     }
     if (visu_data)
         visu_free(visu_data);
-    CCL_LSL_free_data(ccl_data0);
-    CCL_LSL_free_data(ccl_data1);
-    kNN_free_data(knn_data);
-    tracking_free_data(tracking_data);
+    frame_pool_free(frame_pool);
+    pipeline_free(pip);
+    if (log_writer)
+        log_writer_free(log_writer);
+    if (log_shm)
+        log_shm_writer_free(log_shm);
+    if (runs_writer)
+        log_runs_writer_free(runs_writer);
 
     printf("#\n");
     printf("# End of the program, exiting.\n");